@@ -11,7 +11,7 @@ case "${OS}" in
         # sudo privileges are required on Arch Linux
         if command -v pacman > /dev/null; then
             echo "Installing dependencies via pacman for Arch Linux..."
-            sudo pacman -S --needed glm rapidjson tomlplusplus
+            sudo pacman -S --needed glm rapidjson
         else
             echo "Error: pacman package manager not found. Please ensure you are on Arch Linux."
             exit 1
@@ -23,8 +23,7 @@ case "${OS}" in
         # sudo is not required in MSYS2. Installing dependencies for the UCRT64 architecture directly.
         echo "Installing UCRT64 dependencies via pacman..."
         pacman -S --needed mingw-w64-ucrt-x86_64-glm \
-                           mingw-w64-ucrt-x86_64-rapidjson \
-                           mingw-w64-ucrt-x86_64-tomlplusplus
+                           mingw-w64-ucrt-x86_64-rapidjson
         ;;
         
     *)
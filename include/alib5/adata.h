@@ -8,11 +8,19 @@
  */
 // 核心
 #include <alib5/data/kernel.h>
+// 预编译路径
+#include <alib5/data/compiled_path.h>
+// 差异与补丁
+#include <alib5/data/patch.h>
 // 验证器
 #include <alib5/data/validator.h>
 // 一些预制的policy
 #include <alib5/data/data_json.h>
+#include <alib5/data/data_fastjson.h>
 #include <alib5/data/data_toml.h>
+#include <alib5/data/data_binary.h>
+// 只读冻结格式
+#include <alib5/data/frozen.h>
 // 反射支持
 #ifdef ALIB5_ENABLE_REFLECTION
 #include <alib5/data/reflect.h>
@@ -10,5 +10,6 @@
  #include <alib5/log/kernel.h>
  // 预制菜加入
  #include <alib5/log/targets.h>
+ #include <alib5/log/ring_file.h>
  #include <alib5/log/filters.h>
  #include <alib5/log/prefab.h>
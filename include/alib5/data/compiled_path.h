@@ -0,0 +1,137 @@
+/**
+ * @file compiled_path.h
+ * @brief Precompiled JSON pointer accessor for AData / AData 的预编译 JSON pointer 访问器
+ *
+ * @details
+ * English: `jump_ptr` splits the pointer, unescapes every token and hashes every key on each call. A
+ * `CompiledPath` does that once. While resolving, it remembers the child slot found in every object,
+ * tagged with the object's `layout_stamp()`. The next lookup on an unchanged document compares the stamp
+ * and loads the slot directly, without hashing or comparing keys.
+ *
+ * Chinese: `jump_ptr` 每次调用都要切分路径、反转义并对每个键求哈希。`CompiledPath` 只做一次。
+ * 解析时会记住在每个对象中找到的子节点槽位，并以该对象的 `layout_stamp()` 标记；在未变化的文档上再次查找时
+ * 只比较 stamp 并直接读取槽位，不再求哈希或比较键。
+ */
+
+#ifndef ALIB5_ADATA_COMPILED_PATH
+#define ALIB5_ADATA_COMPILED_PATH
+
+#include <alib5/data/kernel.h>
+#include <string_view>
+#include <cstdint>
+
+namespace alib5::data {
+
+    /**
+     * @brief A JSON pointer parsed once and resolved against documents many times.
+     *
+     * @details
+     * Follows `jump_ptr`: a numeric token indexes an array (negative counts from the end), anything else
+     * is an object key with `~0` / `~1` unescaped. The slot cache is mutable, so one instance must not be
+     * resolved from several threads at once (neither may the document, see `AData`).
+     */
+    class ALIB5_API CompiledPath {
+        struct Step {
+            std::pmr::string key;
+            uint32_t hash;
+            bool has_index;
+            std::ptrdiff_t index;
+        };
+        struct Cache {
+            uint64_t stamp;
+            size_t slot;
+        };
+
+        std::pmr::string source;
+        std::pmr::vector<Step> steps;
+        mutable std::pmr::vector<Cache> cache;
+        bool ok { false };
+
+        /**
+         * @param touch Drop the cached structural hashes along the path, the result is going to be modified.
+         */
+        template<class V>
+        const BasicAData<V>* walk(const BasicAData<V>& root, bool touch) const;
+
+    public:
+        /**
+         * @param pointer JSON pointer such as "/a/b/3/c". Empty means the root itself.
+         * @param invoke_err Report a malformed pointer through `invoke_error`.
+         */
+        CompiledPath(
+            std::string_view pointer,
+            bool invoke_err = true,
+            std::pmr::memory_resource* __a = ALIB5_DEFAULT_MEMORY_RESOURCE
+        );
+
+        /**
+         * @brief False if the pointer was malformed, resolving then always fails.
+         */
+        inline bool valid() const { return ok; }
+        inline explicit operator bool() const { return ok; }
+
+        inline std::string_view str() const { return source; }
+        inline size_t depth() const { return steps.size(); }
+
+        /**
+         * @brief Drops every cached slot.
+         */
+        void reset_cache() const;
+
+        /**
+         * @brief Resolves the path against `root`.
+         * @return Pointer to the addressed node, nullptr if it does not exist.
+         */
+        template<class V>
+        const BasicAData<V>* resolve(const BasicAData<V>& root) const {
+            return walk(root, false);
+        }
+
+        template<class V>
+        BasicAData<V>* resolve(BasicAData<V>& root) const {
+            return const_cast<BasicAData<V>*>(walk(static_cast<const BasicAData<V>&>(root), true));
+        }
+    };
+
+} // namespace alib5::data
+
+// ----------------------------------------------------------------------------------------------------
+// Inline Implementations
+// ----------------------------------------------------------------------------------------------------
+
+namespace alib5::data {
+
+    template<class V>
+    inline const BasicAData<V>* CompiledPath::walk(const BasicAData<V>& root, bool touch) const {
+        if(!ok) return nullptr;
+        const BasicAData<V>* current = &root;
+
+        for(size_t i = 0; i < steps.size(); ++i) {
+            const Step& s = steps[i];
+            if(touch) current->invalidate_hash();
+            if(current->is_object()) {
+                // 要写入时取得可写负载,共享的负载会先被复制
+                auto& obj = touch ? const_cast<BasicAData<V>*>(current)->object() : current->object();
+                Cache& c = cache[i];
+                uint64_t stamp = obj.layout_stamp();
+                if(c.stamp != stamp) {
+                    size_t pos = obj.find_entry(s.key, s.hash);
+                    if(pos == obj.entries.size()) return nullptr;
+                    c = Cache{stamp, obj.entries[pos].index};
+                }
+                current = &obj.children.data[c.slot];
+            } else if(current->is_array() && s.has_index) {
+                auto& arr = touch ? const_cast<BasicAData<V>*>(current)->array() : current->array();
+                current = arr.at_ptr(s.index);
+                if(!current) return nullptr;
+            } else {
+                return nullptr;
+            }
+        }
+        if(touch) current->invalidate_hash();
+        return current;
+    }
+
+} // namespace alib5::data
+
+#endif
@@ -0,0 +1,148 @@
+/**
+ * @file data_binary.h
+ * @brief Compact binary Data Policy for ALib5 / ALib5 的紧凑二进制数据策略
+ *
+ * @details
+ * English: `Binary` serializes `AData` into a tagged binary form, similar in spirit to CBOR / MessagePack.
+ * Integers and doubles are stored as raw little-endian 8 byte values, strings and keys carry a varint
+ * length, and every object / array carries the byte length of its body so a reader can skip a whole
+ * subtree without decoding it (see `Binary::parse_at`).
+ *
+ * Chinese: `Binary` 将 `AData` 序列化为带标签的二进制格式，思路类似 CBOR / MessagePack。
+ * 整数与浮点数以 8 字节小端原始值存储，字符串与键带 varint 长度前缀，每个对象 / 数组都记录
+ * 其内容的字节长度，读取方可以不解码直接跳过整棵子树（见 `Binary::parse_at`）。
+ *
+ * @par Layout
+ * @code
+ * document := "ADB" version(1) value
+ * value    := Null | False | True
+ *           | Int    i64
+ *           | Double f64
+ *           | String varint(len) bytes
+ *           | Object u32(body_len) body      body := varint(count) (varint(len) key value)*
+ *           | Array  u32(body_len) body      body := varint(count) value*
+ *           | Object64 / Array64 : same as above with u64(body_len)
+ * @endcode
+ */
+
+#ifndef ALIB5_ADATA_PL_BINARY
+#define ALIB5_ADATA_PL_BINARY
+
+#include <alib5/data/kernel.h>
+#include <string_view>
+#include <cstdint>
+
+namespace alib5::data {
+
+    /**
+     * @brief Configuration for binary parsing and dumping.
+     */
+    struct ALIB5_API BinaryConfig {
+        /**
+         * @brief Maximum container nesting accepted while parsing, guards against hostile input.
+         */
+        size_t max_depth { 1024 };
+    };
+
+    /**
+     * @brief Binary policy class implementing `IsDataPolicy` for `AData`.
+     */
+    struct ALIB5_API Binary {
+        using __dump_fn = void(std::string_view, void*);
+
+        /**
+         * @brief Type tag written before every value.
+         */
+        enum Tag : uint8_t {
+            TagNull,
+            TagFalse,
+            TagTrue,
+            TagInt,
+            TagDouble,
+            TagString,
+            TagObject,
+            TagArray,
+            TagObject64,
+            TagArray64
+        };
+
+        constexpr static uint8_t version = 1;
+        constexpr static std::string_view magic = "ADB";
+
+        BinaryConfig cfg; ///< Configuration setting for the policy.
+
+        Binary(const BinaryConfig& c = BinaryConfig()) : cfg(c) {}
+
+        /**
+         * @brief Parses a binary document into an `AData` hierarchy.
+         * @return bool False on a bad header, truncated or malformed data.
+         */
+        bool ALIB5_API parse(std::string_view data, dadata_t& root);
+
+        /**
+         * @brief Decodes only the subtree addressed by a JSON pointer, skipping everything else.
+         *
+         * @details
+         * Siblings on the way are skipped using their length prefixes, so the cost depends on the
+         * size of the addressed subtree and on the number of keys visited, not on the document size.
+         *
+         * @param data The binary document.
+         * @param pointer JSON pointer such as "/items/3/name". Empty means the whole document.
+         * @param node Receives the subtree.
+         * @return bool False if the path does not exist or the data is malformed.
+         */
+        bool ALIB5_API parse_at(std::string_view data, std::string_view pointer, dadata_t& node);
+
+        /**
+         * @brief Internal method handling the core dump logic, output goes to `fn` in one chunk.
+         *
+         * @details Container lengths are patched after their bodies, so the whole document is built in a
+         * buffer owned by this call first. Use the string overloads to skip that copy.
+         */
+        bool ALIB5_API __internal_dump(__dump_fn fn, void* p, const dadata_t& root);
+
+        /**
+         * @brief Dumps straight into a byte string.
+         */
+        bool ALIB5_API __internal_dump(std::string& out, const dadata_t& root);
+        bool ALIB5_API __internal_dump(std::pmr::string& out, const dadata_t& root);
+
+        /**
+         * @brief Dumps an `AData` node to a target container, appending to it.
+         * @return bool Always true, kept for symmetry with other policies.
+         */
+        template<IsStringLike T>
+        auto dump(T&& target, const dadata_t& root);
+    };
+
+} // namespace alib5::data
+
+// ----------------------------------------------------------------------------------------------------
+// Inline Implementations
+// ----------------------------------------------------------------------------------------------------
+
+namespace alib5::data {
+
+    template<IsStringLike T>
+    inline auto Binary::dump(T&& target, const dadata_t& root) {
+        using type = std::remove_reference_t<T>;
+        if constexpr (std::is_same_v<type, std::string> || std::is_same_v<type, std::pmr::string>) {
+            return __internal_dump(target, root);
+        } else {
+            auto fn = [](std::string_view sv, void* ag) {
+                using type = std::decay_t<T>;
+                type& out = *static_cast<type*>(ag);
+
+                if constexpr (requires { out.append(sv); }) {
+                    out.append(sv);
+                } else {
+                    out += sv;
+                }
+            };
+            return __internal_dump(fn, &target, root);
+        }
+    }
+
+} // namespace alib5::data
+
+#endif
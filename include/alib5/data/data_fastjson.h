@@ -0,0 +1,201 @@
+/**
+ * @file data_fastjson.h
+ * @brief SIMD structural-index JSON Data Policy for ALib5 / ALib5 的 SIMD 结构索引 JSON 数据策略
+ *
+ * @details
+ * English: `FastJSON` is an alternative to the RapidJSON backed `JSON` policy. Parsing happens in two stages:
+ * stage 1 scans the input 64 bytes at a time (AVX2 / SSE2 with a scalar fallback, picked at runtime) and
+ * records the offset of every structural character outside of strings; stage 2 walks that index and builds
+ * `AData` nodes directly. Dumping is shared with `JSON`.
+ *
+ * Chinese: `FastJSON` 是基于 RapidJSON 的 `JSON` 策略之外的另一种实现。解析分为两个阶段：
+ * 第一阶段每次扫描 64 字节（运行时选择 AVX2 / SSE2，或者标量实现），记录字符串外每个结构字符的位置；
+ * 第二阶段遍历该索引直接构建 `AData` 节点。Dump 与 `JSON` 共用。
+ */
+
+#ifndef ALIB5_ADATA_PL_FASTJSON
+#define ALIB5_ADATA_PL_FASTJSON
+
+#include <alib5/data/data_json.h>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+namespace alib5 {
+    /**
+     * @brief Minimum number of input bytes handed to each thread by `FastJSON::parse_parallel`.
+     *
+     * @details
+     * English: Smaller inputs use fewer threads, below this size everything is parsed on the calling thread.
+     * Chinese: 输入较小时减少线程数,小于该值时全部在调用线程上解析
+     */
+    static constexpr size_t conf_parallel_parse_chunk = 1 << 20;
+}
+
+namespace alib5::detail {
+    /**
+     * @brief Builds the structural index of a JSON text (stage 1).
+     *
+     * @details
+     * Every `{ } [ ] : ,`, every opening quote and the first byte of every literal/number outside
+     * of strings gets its offset appended to `out` (in order). Escapes are resolved, so `\"` never
+     * closes a string.
+     *
+     * @param data The JSON text. Must be smaller than 4GB.
+     * @param out Receives the offsets, cleared first.
+     * @return bool False if a string is left unterminated.
+     */
+    bool ALIB5_API fastjson_structural_index(std::string_view data, std::vector<uint32_t>& out);
+
+    /**
+     * @brief Name of the stage 1 kernel picked for this CPU ("avx2", "sse2" or "scalar").
+     */
+    std::string_view ALIB5_API fastjson_kernel_name();
+} // namespace alib5::detail
+
+namespace alib5::data {
+
+    /**
+     * @brief Document parsed with `FastJSON::parse_lazy`.
+     *
+     * @details
+     * Objects and arrays in `root` start out as lazy nodes pointing into `text`. Each one becomes a real
+     * `Object` / `Array` the first time it is accessed, so time and memory follow what is read, not the
+     * document size. Copying a lazy node materializes the copy completely, but nodes moved out of `root`
+     * still refer to this document and must not outlive it.
+     * Not thread safe, not even for readers: const access materializes the node in place, so two threads
+     * reading the same part of `root` race. Share a document between threads only behind a lock, or hand
+     * them copies (which are fully materialized) instead.
+     */
+    class ALIB5_API LazyJSONDocument : public LazySource {
+        friend struct FastJSON;
+
+        std::pmr::string text; ///< Retained input text.
+        std::vector<uint32_t> index; ///< Structural index of `text`.
+        std::vector<uint32_t> jumps; ///< For every opening bracket in `index`, the position of its closing one.
+
+    public:
+        dadata_t root; ///< Declared last, so it is destroyed before the text it refers to.
+
+        explicit LazyJSONDocument(std::pmr::memory_resource* __a = ALIB5_DEFAULT_MEMORY_RESOURCE);
+
+        LazyJSONDocument(const LazyJSONDocument&) = delete;
+        LazyJSONDocument& operator=(const LazyJSONDocument&) = delete;
+
+        /**
+         * @brief Drops the tree and the retained text.
+         */
+        void clear();
+
+        inline std::string_view source() const { return text; }
+
+        void materialize(LazyNode node, void* target) const override;
+    };
+
+    /**
+     * @brief Document produced by `FastJSON::parse_parallel`.
+     *
+     * @details
+     * `root` is an array whose elements were built concurrently, each worker allocating from its own
+     * monotonic arena. The arenas belong to the document, so the elements (and everything moved out of
+     * them) must not outlive it; copy them to another allocator to keep them. The upstream resource is
+     * shared by all workers during parsing and therefore has to be thread safe (the default one is).
+     */
+    class ALIB5_API ParallelJSONDocument {
+        friend struct FastJSON;
+
+        std::pmr::memory_resource* upstream;
+        std::vector<std::unique_ptr<std::pmr::monotonic_buffer_resource>> arenas;
+
+    public:
+        dadata_t root; ///< Declared last, so it is destroyed before the arenas.
+
+        explicit ParallelJSONDocument(std::pmr::memory_resource* __a = ALIB5_DEFAULT_MEMORY_RESOURCE)
+        : upstream(__a), root(__a) {}
+
+        ParallelJSONDocument(const ParallelJSONDocument&) = delete;
+        ParallelJSONDocument& operator=(const ParallelJSONDocument&) = delete;
+
+        /**
+         * @brief Drops the tree and releases every arena.
+         */
+        void clear() {
+            root.set_null();
+            arenas.clear();
+        }
+    };
+
+    /**
+     * @brief JSON policy using a SIMD structural index instead of RapidJSON's SAX reader.
+     *
+     * @details
+     * Accepts strict RFC 8259 JSON. When `cfg.allow_comments` is set, or the input does not fit the
+     * 32-bit index, parsing falls back to `JSON`. Large unsigned integers behave like the `JSON` policy
+     * (cast to int64), numbers beyond uint64 become doubles.
+     */
+    struct ALIB5_API FastJSON {
+        JSONConfig cfg; ///< Shared with `JSON`, only `allow_comments` matters for parsing.
+
+        /**
+         * @brief Input shapes accepted by `parse_parallel`.
+         */
+        enum ParallelInput {
+            Lines, ///< JSON Lines: one value per line, blank lines are skipped.
+            Array  ///< A single top-level array.
+        };
+
+        FastJSON(const JSONConfig& c = JSONConfig()) : cfg(c) {}
+
+        /**
+         * @brief Parses JSON string data into an `AData` hierarchy.
+         * @return bool True if parsing succeeded, false if an error occurred.
+         */
+        bool ALIB5_API parse(std::string_view data, dadata_t& root);
+
+        /**
+         * @brief Validates the whole text but only builds nodes when they are accessed.
+         *
+         * @details
+         * The text is scanned and checked like `parse` (including strings and numbers), but objects and
+         * arrays are left as lazy nodes. Falls back to a full `JSON` parse under the same conditions as `parse`.
+         *
+         * @param data The JSON text, moved into `doc`.
+         * @param doc Receives the text and the (lazy) tree.
+         * @return bool False if the text is not valid JSON.
+         */
+        bool ALIB5_API parse_lazy(std::pmr::string&& data, LazyJSONDocument& doc);
+
+        /**
+         * @brief Copies `data` into the document first.
+         */
+        bool parse_lazy(std::string_view data, LazyJSONDocument& doc) {
+            return parse_lazy(std::pmr::string(data, doc.root.get_allocator()), doc);
+        }
+
+        /**
+         * @brief Parses many records on several threads into one array.
+         *
+         * @details
+         * The input is split at record boundaries: after a newline for `Lines` (raw newlines cannot appear
+         * inside JSON strings), between top-level elements for `Array`, which first builds the structural
+         * index in parallel chunks. Records are parsed by a pool of `threads` workers into per-worker
+         * arenas and spliced into `doc.root` in input order. `Lines` has no 4GB limit since every line is
+         * indexed on its own; `Array` falls back to a serial `JSON` parse under the conditions of `parse`.
+         *
+         * @param threads Number of workers, 0 uses `std::thread::hardware_concurrency()`.
+         * @return bool False if any record is not valid JSON, `doc` is cleared then.
+         */
+        bool ALIB5_API parse_parallel(std::string_view data, ParallelJSONDocument& doc, ParallelInput input = Lines, size_t threads = 0);
+
+        /**
+         * @brief Dumps an `AData` node, identical to `JSON::dump`.
+         */
+        template<IsStringLike T>
+        auto dump(T&& target, const dadata_t& root) {
+            return JSON(cfg).dump(std::forward<T>(target), root);
+        }
+    };
+
+} // namespace alib5::data
+
+#endif
@@ -19,6 +19,8 @@
 #include <functional>
 #include <string_view>
 #include <compare>
+#include <memory_resource>
+#include <span>
 
 namespace alib5::data {
 
@@ -69,8 +71,9 @@ namespace alib5::data {
         bool compact_lines { false };   ///< If true, removes line breaks for a compact output.
         bool compact_spaces { false };  ///< If true, removes extra spaces (e.g., around colons).
         bool ensure_ascii { false };    ///< If true, escapes non-ASCII characters.
-        bool warn_when_nan { true };    ///< If true, emits a warning when encountering NaN/Inf values.
-        int float_precision { -1 };     ///< Floating-point output precision. -1 means default format.
+        bool warn_when_nan { true };    ///< If true, emits a warning when encountering NaN/Inf values, which are written as `null` either way.
+        int float_precision { -1 };     ///< Fixed-point digits after the dot. -1 means the shortest round-trip form.
+        size_t dump_chunk_size { 64 * 1024 }; ///< Bytes buffered before a callback/fd target receives them.
         
         std::function<CompareFn> sort_object { nullptr }; ///< Function to sort object keys before dumping.
         
@@ -106,6 +109,48 @@ namespace alib5::data {
         bool allow_comments { false };
     };
 
+    /**
+     * @brief A parsed JSON document that owns its input buffer and a per-document arena.
+     *
+     * @details
+     * Produced by `JSON::parse_insitu`. The input text is retained and parsed in place
+     * (strings are unescaped directly inside `buffer`). Keys longer than the inline key
+     * capacity keep pointing into `buffer` instead of being copied, string values are
+     * still copied out of it, and every node and string of `root` is bump-allocated from
+     * `arena`, so a large document costs no per-string heap allocation and is released at
+     * once when the document dies.
+     *
+     * @warning `root`, and every copy of it on `arena`, must not outlive the document.
+     * Copy it to another allocator (e.g. `AData(doc.root, res)`) if you need to keep the
+     * data around, that also copies the keys out of `buffer`.
+     */
+    struct ALIB5_API JSONDocument {
+        std::pmr::monotonic_buffer_resource arena; ///< Arena backing every node of `root`.
+        std::pmr::string buffer; ///< Retained input text, modified in place by the parser.
+        dadata_t root; ///< Parsed tree, allocated from `arena`.
+
+        /**
+         * @param upstream Where the arena and the buffer take their memory from.
+         * @param initial_arena Initial arena block size, usually about the size of the input.
+         */
+        JSONDocument(std::pmr::memory_resource* upstream = ALIB5_DEFAULT_MEMORY_RESOURCE, size_t initial_arena = 64 * 1024)
+        : arena(initial_arena, upstream)
+        , buffer(upstream)
+        , root(&arena) {}
+
+        JSONDocument(const JSONDocument&) = delete;
+        JSONDocument& operator=(const JSONDocument&) = delete;
+
+        /**
+         * @brief Drops the tree and releases the arena; the buffer keeps its capacity.
+         */
+        void clear() {
+            root.set_null();
+            arena.release();
+            buffer.clear();
+        }
+    };
+
     /**
      * @brief JSON policy class implementing `IsDataPolicy` for `AData`.
      * 
@@ -145,12 +190,62 @@ namespace alib5::data {
          * Chinese: 失败返回false
          */
         bool ALIB5_API parse(std::string_view data, dadata_t& root);
+
+        /**
+         * @brief Parses a mutable buffer in place (RapidJSON in-situ mode).
+         *
+         * @details
+         * Strings are unescaped inside `data` itself and object keys are referenced
+         * directly instead of being copied into a temporary, so the only remaining copy
+         * of a string is its final store into `root`. The buffer does not need a trailing
+         * '\0', which makes a writable (e.g. `MAP_PRIVATE`) mmap usable as input.
+         * Pair it with a `root` living on a monotonic arena to turn that store into a bump
+         * allocation, or use the `JSONDocument` overload which does both for you.
+         *
+         * @param data Buffer to parse. Its contents are garbage after the call.
+         * @param root The root `AData` node to write parsed values into.
+         * @return bool True if parsing succeeded.
+         */
+        bool ALIB5_API parse_insitu(std::span<char> data, dadata_t& root);
+
+        /**
+         * @brief Takes over `text` and parses it in place into `doc`.
+         *
+         * @details
+         * Previous contents of `doc` are released first.
+         */
+        bool ALIB5_API parse_insitu(std::pmr::string&& text, JSONDocument& doc);
+
+        /**
+         * @brief Copies `text` into the document buffer and parses it in place.
+         */
+        bool parse_insitu(std::string_view text, JSONDocument& doc) {
+            std::pmr::string buf(text, doc.buffer.get_allocator());
+            return parse_insitu(std::move(buf), doc);
+        }
         
         /**
          * @brief Internal method handling the core dump rendering logic.
+         *
+         * @details Output is collected in a buffer owned by this call and handed to `fn` in chunks of
+         * about `cfg.dump_chunk_size` bytes instead of once per token.
          */
         DumpResult ALIB5_API __internal_dump(__dump_fn fn, void* p, const dadata_t& root);
 
+        /**
+         * @brief Dumps straight into a string, without an intermediate buffer.
+         */
+        DumpResult ALIB5_API __internal_dump(std::string& out, const dadata_t& root);
+        DumpResult ALIB5_API __internal_dump(std::pmr::string& out, const dadata_t& root);
+
+        /**
+         * @brief Dumps to a file descriptor, writing `cfg.dump_chunk_size` sized chunks.
+         *
+         * @details Write failures are reported through `invoke_error(err_io_error, ...)`; the
+         * rest of the document is discarded once a write failed.
+         */
+        DumpResult ALIB5_API dump_to_fd(int fd, const dadata_t& root);
+
         /**
          * @brief Dumps an `AData` node to a target string container.
          * 
@@ -173,19 +268,25 @@ namespace alib5::data {
 
     template<IsStringLike T> 
     inline auto JSON::dump(T&& target, const dadata_t& root) {
-        auto fn = [](std::string_view sv, void* ag) {
-            using type = std::decay_t<T>;
-            type& out = *static_cast<type*>(ag);
+        using type = std::remove_reference_t<T>;
+        if constexpr (std::is_same_v<type, std::string> || std::is_same_v<type, std::pmr::string>) {
+            // 直接写入目标字符串,不需要中转
+            return __internal_dump(target, root);
+        } else {
+            auto fn = [](std::string_view sv, void* ag) {
+                using type = std::decay_t<T>;
+                type& out = *static_cast<type*>(ag);
+                
+                // Standard approach depending on append vs operator+= availability
+                if constexpr (requires { out.append(sv); }) {
+                    out.append(sv);
+                } else {
+                    out += sv; 
+                }
+            };
             
-            // Standard approach depending on append vs operator+= availability
-            if constexpr (requires { out.append(sv); }) {
-                out.append(sv);
-            } else {
-                out += sv; 
-            }
-        };
-        
-        return __internal_dump(fn, &target, root);
+            return __internal_dump(fn, &target, root);
+        }
     }
 
 } // namespace alib5::data
@@ -0,0 +1,166 @@
+/**
+ * @file data_text.h
+ * @author aaaa0ggmc (lovelinux@yslwd.eu.org)
+ * @brief Text helpers shared by the adata readers and writers / adata 各个读写器共用的文本工具
+ *
+ * \par Original Comment
+ * English: Number and string formatting used by both the `AData` policies and the reflection paths,
+ * kept here so neither side has to include the other.
+ * Chinese: `AData`策略与反射路径都会用到的数字、字符串格式化,放在这里两边就不必互相包含
+ *
+ * @version 5.0
+ * @date 2026-06-10
+ * @copyright Copyright (c) 2026
+ */
+#ifndef ALIB5_ADATA_TEXT
+#define ALIB5_ADATA_TEXT
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+
+namespace alib5::detail {
+
+    /**
+     * @brief Value of one hexadecimal digit, -1 if `c` is not one.
+     */
+    inline int text_hex_value(char c);
+
+    /**
+     * @brief Appends the UTF-8 encoding of code point `cp`, the caller has already validated it.
+     */
+    template<class Out>
+    void text_append_utf8(Out & out, uint32_t cp);
+
+    /**
+     * @brief Appends `in` as a quoted JSON string.
+     */
+    template<class Out>
+    void json_write_string(Out & out, std::string_view in);
+
+    /**
+     * @brief Appends a finite floating point number, the part of float formatting JSON and TOML share.
+     *
+     * @details
+     * A negative `precision` gives the shortest round-trip form, which always keeps a `.` or an exponent
+     * so the value is read back as a float; otherwise `precision` digits after the point. `force_float`
+     * keeps the `.` in the fixed form too (precision 0), TOML needs that to tell floats from integers.
+     * The two formats spell NaN and infinities differently, callers handle them before.
+     */
+    template<class Out, class T>
+    requires std::is_floating_point_v<T>
+    void text_write_finite_float(Out & out, T v, int precision, bool force_float = false);
+
+    /**
+     * @brief Appends a floating point number in its JSON form, shared by every JSON writer of adata.
+     *
+     * @details
+     * JSON has no NaN or infinities, they are written as `null` (callers that want to report them check
+     * before). A negative `precision` gives the shortest round-trip form, which always keeps a `.` or an
+     * exponent so the value is read back as a float; otherwise `precision` digits after the point.
+     */
+    template<class Out, class T>
+    requires std::is_floating_point_v<T>
+    void json_write_float(Out & out, T v, int precision = -1);
+
+}
+
+// ============================================================================
+// Implementation
+// ============================================================================
+
+namespace alib5::detail {
+
+    inline int text_hex_value(char c) {
+        if(c >= '0' && c <= '9') return c - '0';
+        if(c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if(c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+
+    template<class Out>
+    inline void text_append_utf8(Out & out, uint32_t cp) {
+        if(cp < 0x80) {
+            out.push_back((char)cp);
+        } else if(cp < 0x800) {
+            out.push_back((char)(0xC0 | (cp >> 6)));
+            out.push_back((char)(0x80 | (cp & 0x3F)));
+        } else if(cp < 0x10000) {
+            out.push_back((char)(0xE0 | (cp >> 12)));
+            out.push_back((char)(0x80 | ((cp >> 6) & 0x3F)));
+            out.push_back((char)(0x80 | (cp & 0x3F)));
+        } else {
+            out.push_back((char)(0xF0 | (cp >> 18)));
+            out.push_back((char)(0x80 | ((cp >> 12) & 0x3F)));
+            out.push_back((char)(0x80 | ((cp >> 6) & 0x3F)));
+            out.push_back((char)(0x80 | (cp & 0x3F)));
+        }
+    }
+
+    template<class Out>
+    inline void json_write_string(Out & out, std::string_view in) {
+        static constexpr char hex[] = "0123456789abcdef";
+        out.push_back('"');
+
+        size_t run = 0;
+        for(size_t i = 0; i < in.size(); ++i) {
+            unsigned char c = in[i];
+            if(c >= 0x20 && c != '"' && c != '\\') continue;
+
+            // 先把不需要转义的一段整体写出去
+            out.append(in.data() + run, i - run);
+            run = i + 1;
+            switch(c) {
+                case '"':  out.append("\\\"", 2); break;
+                case '\\': out.append("\\\\", 2); break;
+                case '\b': out.append("\\b", 2); break;
+                case '\f': out.append("\\f", 2); break;
+                case '\n': out.append("\\n", 2); break;
+                case '\r': out.append("\\r", 2); break;
+                case '\t': out.append("\\t", 2); break;
+                default: {
+                    char buf[6] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xF]};
+                    out.append(buf, 6);
+                }
+            }
+        }
+        out.append(in.data() + run, in.size() - run);
+        out.push_back('"');
+    }
+
+    template<class Out, class T>
+    requires std::is_floating_point_v<T>
+    inline void text_write_finite_float(Out & out, T v, int precision, bool force_float) {
+        // fixed格式下很大的数也放得下
+        char buf[512];
+        std::to_chars_result r {};
+        bool fixed = false;
+        if(precision >= 0) {
+            r = std::to_chars(buf, buf + sizeof(buf), v, std::chars_format::fixed, precision);
+            fixed = (r.ec == std::errc());
+        }
+        if(!fixed) {
+            r = std::to_chars(buf, buf + sizeof(buf), v);
+        }
+        // 保证读回来依然是浮点数
+        if((!fixed || force_float) && std::string_view(buf, r.ptr - buf).find_first_of(".e") == std::string_view::npos) {
+            *r.ptr++ = '.';
+            *r.ptr++ = '0';
+        }
+        out.append(buf, r.ptr - buf);
+    }
+
+    template<class Out, class T>
+    requires std::is_floating_point_v<T>
+    inline void json_write_float(Out & out, T v, int precision) {
+        if(!std::isfinite(v)) {
+            out.append("null", 4);
+            return;
+        }
+        text_write_finite_float(out, v, precision);
+    }
+
+}
+
+#endif
@@ -8,15 +8,12 @@
  * @copyright Copyright (c) 2026
  * 
  * @details
- * English: This file provides the TOML parsing strategy for the ALib5 data kernel.
- * Please note that TOML dumping (serialization) is currently unsupported.
+ * English: This file provides the TOML parsing and dumping strategy for the ALib5 data kernel.
+ * The reader is a single pass over the text that creates `AData` nodes directly (no intermediate tree),
+ * the writer renders tables, arrays of tables and inline values into a chunked buffer.
  * 
- * Chinese: 本文件提供了 ALib5 数据内核的 TOML 解析策略。
- * 请注意，目前不支持 TOML 转储（序列化）功能。
- * 
- * @par Original Comments:
- * English: Angry toml does not yet support delicious dump.
- * Chinese: 愤怒的toml还不支持美味的dump
+ * Chinese: 本文件提供了 ALib5 数据内核的 TOML 解析与转储策略。
+ * 读取器只扫描一遍文本并直接创建 `AData` 节点（没有中间树），写入器把表、表数组和内联值写入分块缓冲。
  */
 
 #ifndef ALIB5_ADATA_PL_TOML
@@ -28,20 +25,33 @@ namespace alib5::data {
 
     /**
      * @brief Configuration for TOML parsing and dumping.
-     * 
-     * @details Currently empty as parsing utilizes default `toml++` behavior, 
-     * and dumping is not yet implemented.
      */
     struct ALIB5_API TOMLConfig {
-        
+        int float_precision { -1 };     ///< Fixed-point digits after the dot. -1 means the shortest round-trip form.
+        bool warn_when_null { true };   ///< TOML has no null, such nodes are skipped. If true, each one is reported.
+        size_t dump_chunk_size { 64 * 1024 }; ///< Bytes buffered before a callback target receives them.
     };
 
     /**
      * @brief TOML policy class implementing `IsDataPolicy` for `AData`.
+     * 
+     * @details
+     * Parses TOML 1.0: tables become objects, arrays of tables become arrays of objects. Dates and times
+     * have no `AData` counterpart and are kept as strings (a space between date and time becomes 'T'),
+     * so they are dumped back as quoted strings.
      */
     struct ALIB5_API TOML {
         using __dump_fn = void(std::string_view, void*);
 
+        /**
+         * @brief Result status of a dump operation.
+         */
+        enum DumpResult {
+            Success,
+            EncounteredNull, ///< Some null nodes were skipped.
+            RootNotTable     ///< Only objects can be dumped as a TOML document, nothing was written.
+        };
+
         TOMLConfig cfg; ///< Configuration settings for the policy.
         
         /**
@@ -53,8 +63,12 @@ namespace alib5::data {
         /**
          * @brief Parses TOML string data into an `AData` hierarchy.
          * 
+         * @details
+         * Redefinitions forbidden by the spec (duplicate keys, a table defined twice, extending an inline
+         * table or a static array ...) are errors. Errors are reported through `invoke_error` with their line.
+         * 
          * @param data The TOML string format data.
-         * @param node The root `AData` node to write parsed values into.
+         * @param node The root `AData` node to write parsed values into, always an object afterwards.
          * @return bool True if parsing succeeded, false if an error occurred.
          * 
          * @par Original Comments:
@@ -66,22 +80,31 @@ namespace alib5::data {
         /**
          * @brief Internal method handling the core dump rendering logic.
          * 
-         * @warning This function is deprecated and currently unimplemented. Calling it will trigger a panic.
+         * @details Output is collected in a buffer owned by this call and handed to `fn` in chunks of
+         * about `cfg.dump_chunk_size` bytes.
+         */
+        DumpResult ALIB5_API __internal_dump(__dump_fn fn, void* p, const dadata_t& root);
+
+        /**
+         * @brief Dumps straight into a string, without an intermediate buffer.
          */
-        [[deprecated("This function hasn't been implemented")]]
-        void ALIB5_API __internal_dump(__dump_fn fn, void* p, const dadata_t& root);
+        DumpResult ALIB5_API __internal_dump(std::string& out, const dadata_t& root);
+        DumpResult ALIB5_API __internal_dump(std::pmr::string& out, const dadata_t& root);
 
         /**
          * @brief Dumps an `AData` node to a target string container.
          * 
+         * @details
+         * Scalars and arrays come first in every table, then objects as `[sub.tables]` and non-empty arrays
+         * holding only objects as `[[arrays.of.tables]]`. Tables holding nothing but sub tables get no header
+         * of their own. Anything else nested is written inline.
+         * 
          * @tparam T The target string-like type (e.g., std::string, std::pmr::string).
          * @param target The container to which the serialized TOML text will be appended.
-         * @param root The source `AData` root node.
-         * 
-         * @warning This function is deprecated and currently unimplemented. Calling it will trigger a panic.
+         * @param root The source `AData` root node, must be an object.
+         * @return DumpResult Status indicator of the dump operation.
          */
         template<IsStringLike T> 
-        [[deprecated("This function hasn't been implemented")]]
         auto dump(T&& target, const dadata_t& root);
     };
 
@@ -95,17 +118,23 @@ namespace alib5::data {
 
     template<IsStringLike T> 
     inline auto TOML::dump(T&& target, const dadata_t& root) {
-        auto fn = [](std::string_view sv, void* ag) {
-            using type = std::decay_t<T>;
-            type& out = *static_cast<type*>(ag);
+        using type = std::remove_reference_t<T>;
+        if constexpr (std::is_same_v<type, std::string> || std::is_same_v<type, std::pmr::string>) {
+            // 直接写入目标字符串,不需要中转
+            return __internal_dump(target, root);
+        } else {
+            auto fn = [](std::string_view sv, void* ag) {
+                using type = std::decay_t<T>;
+                type& out = *static_cast<type*>(ag);
             
-            if constexpr (requires { out.append(sv); }) {
-                out.append(sv);
-            } else {
-                out += sv; 
-            }
-        };
-        return __internal_dump(fn, &target, root);
+                if constexpr (requires { out.append(sv); }) {
+                    out.append(sv);
+                } else {
+                    out += sv;
+                }
+            };
+            return __internal_dump(fn, &target, root);
+        }
     }
 
 } // namespace alib5::data
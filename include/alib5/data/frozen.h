@@ -0,0 +1,343 @@
+/**
+ * @file frozen.h
+ * @brief Frozen, memory-mapped read-only AData / 冻结的只读内存映射 AData
+ *
+ * @details
+ * English: A frozen document is a flat, offset based image of an `AData` tree. It is written once with
+ * `FrozenAData::freeze` and later opened with `FrozenAData::open`, which only maps the file, so opening
+ * costs O(1) and every process mapping the same file shares one copy of the pages. Queries go through
+ * `FrozenView`, a const view shaped like `Object::at_ptr` / `Array::at_ptr`.
+ *
+ * Chinese: 冻结文档是 `AData` 树的扁平、基于偏移量的镜像。使用 `FrozenAData::freeze` 写入一次，
+ * 之后用 `FrozenAData::open` 打开，打开时只做内存映射，因此是 O(1) 的，映射同一文件的多个进程共享同一份页面。
+ * 查询通过 `FrozenView` 完成，它是一个接口形似 `Object::at_ptr` / `Array::at_ptr` 的只读视图。
+ *
+ * @par Layout
+ * @code
+ * Header  (32 bytes) : magic "AFZ1" | u32 version | u64 root offset | u64 blob offset | u64 file size
+ * Node    (16 bytes) : u8 type | u8[3] pad | u32 count | u64 payload
+ *     Null/Bool/Int/Double : payload holds the value inline
+ *     String               : count = length, payload = offset into the string blob
+ *     Array                : count = n, payload = offset of n contiguous nodes
+ *     Object               : count = n, payload = offset of n KeyRefs followed by n nodes,
+ *                            KeyRefs are sorted by (hash, key) for binary search
+ * KeyRef  (16 bytes) : u32 hash | u32 length | u64 offset into the string blob
+ * @endcode
+ * All numbers are little-endian; opening is refused on big-endian hosts.
+ */
+
+#ifndef ALIB5_ADATA_FROZEN
+#define ALIB5_ADATA_FROZEN
+
+#include <alib5/data/kernel.h>
+#include <string_view>
+#include <cstdint>
+#include <bit>
+
+namespace alib5::data {
+
+    namespace frozen {
+        enum NodeType : uint8_t {
+            FNull,
+            FBool,
+            FInt,
+            FDouble,
+            FString,
+            FObject,
+            FArray
+        };
+
+        struct Header {
+            char magic[4];
+            uint32_t version;
+            uint64_t root;
+            uint64_t blob;
+            uint64_t size;
+        };
+
+        struct Node {
+            uint8_t type;
+            uint8_t pad[3];
+            uint32_t count;
+            uint64_t payload;
+        };
+
+        struct KeyRef {
+            uint32_t hash;
+            uint32_t length;
+            uint64_t offset;
+        };
+
+        static_assert(sizeof(Header) == 32 && sizeof(Node) == 16 && sizeof(KeyRef) == 16);
+
+        constexpr char magic[4] = {'A', 'F', 'Z', '1'};
+        constexpr uint32_t version = 1;
+
+        /**
+         * @brief FNV-1a, the hash used by object key tables.
+         */
+        constexpr uint32_t hash_key(std::string_view key) {
+            uint32_t h = 2166136261u;
+            for(char c : key) {
+                h ^= (uint8_t)c;
+                h *= 16777619u;
+            }
+            return h;
+        }
+    }
+
+    /**
+     * @brief Read-only view of one node inside a frozen document.
+     *
+     * @details
+     * Views are two pointers and are cheap to copy. A default constructed (or failed lookup) view is
+     * empty, check it with `operator bool`. Views are valid as long as the owning `FrozenAData` is open.
+     */
+    class ALIB5_API FrozenView {
+        const char* base { nullptr };
+        const frozen::Node* node { nullptr };
+
+        const char* blob() const {
+            return base + reinterpret_cast<const frozen::Header*>(base)->blob;
+        }
+        const frozen::KeyRef* keys() const {
+            return reinterpret_cast<const frozen::KeyRef*>(base + node->payload);
+        }
+        const frozen::Node* children() const {
+            if(node->type == frozen::FObject) {
+                return reinterpret_cast<const frozen::Node*>(base + node->payload + node->count * sizeof(frozen::KeyRef));
+            }
+            return reinterpret_cast<const frozen::Node*>(base + node->payload);
+        }
+
+    public:
+        FrozenView() = default;
+        FrozenView(const char* b, const frozen::Node* n) : base(b), node(n) {}
+
+        explicit operator bool() const { return node != nullptr; }
+
+        /**
+         * @brief Same type numbering as `AData::get_type()`.
+         */
+        dtype_t get_type() const;
+        inline bool is_null() const { return get_type() == dadata_t::TNull; }
+        inline bool is_value() const { return get_type() == dadata_t::TValue; }
+        inline bool is_object() const { return get_type() == dadata_t::TObject; }
+        inline bool is_array() const { return get_type() == dadata_t::TArray; }
+
+        /**
+         * @brief Type of a value node, only meaningful when `is_value()`.
+         */
+        dvalue_type_t value_type() const;
+
+        /**
+         * @brief Number of children of an object / array, 0 otherwise.
+         */
+        inline size_t size() const {
+            return (node && (node->type == frozen::FObject || node->type == frozen::FArray)) ? node->count : 0;
+        }
+        inline bool empty() const { return !size(); }
+
+        /**
+         * @brief Looks up an object member by binary search on the key table. Empty view if missing.
+         */
+        FrozenView at_ptr(std::string_view key) const;
+
+        /**
+         * @brief Looks up an array element, negative indices count from the end. Empty view if missing.
+         */
+        FrozenView at_ptr(std::ptrdiff_t index) const;
+
+        inline bool contains(std::string_view key) const { return (bool)at_ptr(key); }
+
+        /**
+         * @brief Panicking accessors, mirroring the const `operator[]` of `AData`.
+         */
+        FrozenView operator[](std::string_view key) const {
+            auto v = at_ptr(key);
+            panicf_if(!v, "Invalid visit {}!", key);
+            return v;
+        }
+        FrozenView operator[](std::ptrdiff_t index) const {
+            auto v = at_ptr(index);
+            panic_if(!v, "Array out of bounds!");
+            return v;
+        }
+
+        /**
+         * @brief Jumps to a JSON pointer path. Empty view if missing.
+         */
+        FrozenView jump_ptr(std::string_view path, bool invoke_err = true) const;
+
+        /**
+         * @brief Key of the i-th member of an object (in key table order).
+         */
+        std::string_view key_at(size_t i) const {
+            const auto& k = keys()[i];
+            return std::string_view(blob() + k.offset, k.length);
+        }
+
+        /**
+         * @brief The i-th child of an object / array, no bounds check.
+         */
+        FrozenView child_at(size_t i) const { return FrozenView(base, children() + i); }
+
+        /**
+         * @brief Reads the value as `T`.
+         *
+         * @details
+         * Numeric types convert between int / double / bool like `CacheValue::to`, strings parse into
+         * numbers. `std::string_view` only works on string nodes and points into the mapping, there is
+         * no cache to stringify numbers into.
+         */
+        template<class T>
+        auto to() const;
+
+        /**
+         * @brief Copies the subtree into a regular `AData`.
+         */
+        void thaw(dadata_t& out) const;
+
+        /**
+         * @brief Iterates members of an object (as a key/view proxy) or elements of an array (key is empty).
+         */
+        struct Iterator;
+        Iterator begin() const;
+        Iterator end() const;
+    };
+
+    struct FrozenView::Iterator {
+        struct Proxy {
+            std::string_view _first;
+            FrozenView _second;
+
+            std::string_view first() const { return _first; }
+            FrozenView second() const { return _second; }
+        };
+
+        FrozenView owner;
+        size_t index;
+
+        Proxy operator*() const {
+            return Proxy{
+                owner.is_object() ? owner.key_at(index) : std::string_view(),
+                owner.child_at(index)
+            };
+        }
+        Iterator& operator++() { ++index; return *this; }
+        bool operator==(const Iterator& o) const { return index == o.index; }
+        bool operator!=(const Iterator& o) const { return index != o.index; }
+    };
+
+    inline FrozenView::Iterator FrozenView::begin() const { return {*this, 0}; }
+    inline FrozenView::Iterator FrozenView::end() const { return {*this, size()}; }
+
+    /**
+     * @brief Owner of a frozen document (a read-only mapping or a borrowed buffer).
+     */
+    class ALIB5_API FrozenAData {
+        const char* data { nullptr };
+        size_t length { 0 };
+        bool mapped { false };
+#ifdef _WIN32
+        void* mapping_handle { nullptr };
+#endif
+
+        bool check_header();
+
+    public:
+        FrozenAData() = default;
+        FrozenAData(const FrozenAData&) = delete;
+        FrozenAData& operator=(const FrozenAData&) = delete;
+        FrozenAData(FrozenAData&& o) ALIB5_NOEXCEPT { *this = std::move(o); }
+        FrozenAData& operator=(FrozenAData&& o) ALIB5_NOEXCEPT;
+        ~FrozenAData() { close(); }
+
+        /**
+         * @brief Writes the frozen image of `root`, appending it to `out`.
+         * @details If `out` already holds data it is zero padded first, so the image starts at a multiple of
+         * `alignof(Node)`. Pass `out.data()` plus the returned offset to `open_memory`; the buffer itself
+         * still has to come from an allocation that is at least 8-byte aligned.
+         * @return size_t Offset of the image inside `out`.
+         */
+        static size_t freeze(const dadata_t& root, std::pmr::string& out);
+
+        /**
+         * @brief Writes the frozen image of `root` to a file.
+         * @return bool False if the file could not be written.
+         */
+        static bool freeze_to_file(const dadata_t& root, std::string_view path);
+
+        /**
+         * @brief Maps a frozen file read-only. Only the header is checked, so this is O(1).
+         */
+        bool open(std::string_view path);
+
+        /**
+         * @brief Uses an existing buffer (must be 8-byte aligned and outlive this object).
+         */
+        bool open_memory(std::string_view buffer);
+
+        /**
+         * @brief Unmaps the file, every view becomes dangling.
+         */
+        void close();
+
+        inline bool is_open() const { return data != nullptr; }
+
+        /**
+         * @brief Walks every node and checks all offsets against the file size.
+         *
+         * @details `open` trusts the file contents, call this once for files from untrusted sources.
+         */
+        bool verify() const;
+
+        FrozenView root() const {
+            if(!data) return {};
+            auto* h = reinterpret_cast<const frozen::Header*>(data);
+            return FrozenView(data, reinterpret_cast<const frozen::Node*>(data + h->root));
+        }
+    };
+
+} // namespace alib5::data
+
+// ----------------------------------------------------------------------------------------------------
+// Inline Implementations
+// ----------------------------------------------------------------------------------------------------
+
+namespace alib5::data {
+
+    template<class T>
+    inline auto FrozenView::to() const {
+        using type = std::decay_t<T>;
+        panic_if(!node, "Visiting an empty FrozenView!");
+        if constexpr(std::is_same_v<type, std::string_view>) {
+            if(node->type != frozen::FString) {
+                invoke_error(err_format_error, "Frozen node is not a string!");
+                return std::string_view();
+            }
+            return std::string_view(blob() + node->payload, node->count);
+        } else {
+            switch(node->type) {
+            case frozen::FInt: return (type)std::bit_cast<int64_t>(node->payload);
+            case frozen::FDouble: return (type)std::bit_cast<double>(node->payload);
+            case frozen::FBool: return (type)(node->payload != 0);
+            case frozen::FString: {
+                std::from_chars_result result {};
+                std::string_view s(blob() + node->payload, node->count);
+                auto v = ext::to_T<type>(s, &result);
+                if(result.ec != std::errc()) {
+                    invoke_error(err_format_error, "Cannot format \"{}\" correctly!", s);
+                }
+                return (type)v;
+            }
+            default:
+                invoke_error(err_format_error, "Frozen node is not a value!");
+                return type();
+            }
+        }
+    }
+
+} // namespace alib5::data
+
+#endif
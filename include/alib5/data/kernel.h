@@ -19,12 +19,16 @@
 #include <alib5/aref.h>
 #include <alib5/ecs/linear_storage.h>
 #include <deque>
+#include <atomic>
 #include <variant>
 #include <optional>
 #include <charconv>
 #include <algorithm>
 #include <cmath>
 #include <limits>
+#include <bit>
+#include <cstring>
+#include <memory_resource>
 
 namespace alib5 {
 
@@ -42,6 +46,15 @@ namespace alib5 {
      */
     static constexpr double conf_value_compare_epsilon = 1e-12;
 
+    /**
+     * @brief Objects with at most this many keys are searched linearly, larger ones build a hash index.
+     * 
+     * @details
+     * English: Most objects only hold a handful of keys, comparing cached hashes is faster than hashing into buckets and costs no extra memory.
+     * Chinese: 大部分对象只有几个键,线性比较缓存的哈希比查桶更快,也不需要额外内存
+     */
+    static constexpr size_t conf_object_linear_threshold = 8;
+
     /**
      * @brief Concept defining valid types for node values.
      */
@@ -120,9 +133,82 @@ namespace alib5 {
         class JSON; ///< Forward declaration for default data policy.
     }
 
+    namespace detail {
+        /**
+         * @brief Writes the text form of a scalar value into `buf` without allocating.
+         *
+         * @details
+         * English: Numbers use the shortest round-trip form of `std::to_chars`, bools become "1" / "0" as before.
+         * Chinese: 数字使用`std::to_chars`的最短往返格式,bool与之前一样为"1" / "0"
+         */
+        template<class T>
+        inline std::string_view scalar_to_chars(char (&buf)[32], T v) {
+            if constexpr(std::is_same_v<T, bool>) {
+                buf[0] = v ? '1' : '0';
+                return std::string_view(buf, 1);
+            } else {
+                auto res = std::to_chars(buf, buf + sizeof(buf), v);
+                return std::string_view(buf, res.ptr - buf);
+            }
+        }
+
+        /**
+         * @brief splitmix64 finalizer, every input bit affects every output bit.
+         */
+        constexpr uint64_t hash_mix(uint64_t x) {
+            x ^= x >> 30;
+            x *= 0xbf58476d1ce4e5b9ULL;
+            x ^= x >> 27;
+            x *= 0x94d049bb133111ebULL;
+            return x ^ (x >> 31);
+        }
+
+        constexpr uint64_t hash_combine(uint64_t seed, uint64_t v) {
+            return hash_mix(seed ^ (v + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2)));
+        }
+
+        /**
+         * @brief Hash of a scalar consistent with `equals` under `CompareStrategy::Strict`.
+         *
+         * @details
+         * English: The type takes part in the hash since Strict never matches different types, -0.0 hashes
+         * like 0.0. Returns 0 for NaN, which is not equal to itself and therefore cannot be hashed.
+         * Chinese: Strict下不同类型永远不相等,所以类型参与哈希;-0.0与0.0哈希相同。NaN不等于自身,返回0表示无法哈希
+         */
+        template<class V>
+        inline uint64_t value_hash(const V& v) {
+            uint64_t h;
+            switch(v.get_type()) {
+            case V::STRING:
+                h = (uint64_t)TransparentStringHash{}(v.raw_view());
+                break;
+            case V::INT:
+                h = (uint64_t)v.template to<int64_t>();
+                break;
+            case V::FLOATING: {
+                double d = v.template to<double>();
+                if(d != d) return 0;
+                if(d == 0) d = 0;
+                std::memcpy(&h, &d, sizeof(h));
+                break;
+            }
+            default:
+                h = v.template to<bool>() ? 1 : 0;
+                break;
+            }
+            h = hash_combine((uint64_t)v.get_type() + 1, h);
+            return h ? h : 1;
+        }
+    }
+
     /**
      * @brief Dynamic value wrapper capable of storing strings, integers, floats, or booleans.
      * 
+     * @details
+     * Numbers and bools live natively in the node, `data` only holds text for strings or as a cache of the
+     * text form of a number. That cache is filled on demand (`stringify()`, `to<std::string_view>()`), never
+     * by parsing, arithmetic or dumping, and is not carried over by copies.
+     * 
      * @warning Not thread-safe. Must be locked under multi-threading even for const operations.
      * 
      * @par Original Comments:
@@ -187,7 +273,9 @@ namespace alib5 {
         CacheValue(T&& d, std::pmr::memory_resource* __a = ALIB5_DEFAULT_MEMORY_RESOURCE) : data(__a) {
             type = STRING;
             data_dirt = true;
-            transform<std::decay_t<T>>() = std::forward<T>(d);
+            integer = 0;
+            // 直接写入数值,transform会先尝试把空字符串解析成数字
+            set(std::forward<T>(d));
         }
 
         /**
@@ -202,7 +290,9 @@ namespace alib5 {
         }
 
         CacheValue(const CacheValue& other, std::pmr::memory_resource* a = ALIB5_DEFAULT_MEMORY_RESOURCE) 
-        : data(other.data, a), data_dirt(other.data_dirt), type(other.type) {
+        : data(a), data_dirt(other.type != STRING), type(other.type) {
+            // 数字的文本缓存不拷贝,需要时再生成
+            if(type == STRING) data = other.data;
             this->integer = other.integer; 
         }
 
@@ -224,8 +314,9 @@ namespace alib5 {
 
         CacheValue& operator=(const CacheValue& other) {
             if(this == &other) [[unlikely]] return *this;
-            data = other.data; 
-            data_dirt = other.data_dirt;
+            if(other.type == STRING) data = other.data;
+            else data.clear();
+            data_dirt = other.type != STRING;
             type = other.type;
             integer = other.integer;
             return *this;
@@ -247,9 +338,21 @@ namespace alib5 {
 
         /**
          * @brief Returns raw underlying string view representation (may be out of sync if dirty).
+         * 
+         * @details Only meaningful for `STRING` values, use `stringify()` to get the text of any type.
          */
         std::string_view raw_view() const { return data; }
 
+        /**
+         * @brief Text form of the value, numbers are formatted into the cache on first use.
+         * 
+         * @details The view stays valid until the value is modified.
+         */
+        std::string_view stringify() const {
+            sync_to_string();
+            return data;
+        }
+
         /**
          * @brief Transforms the underlying type and provides a reference for modification.
          * 
@@ -423,10 +526,115 @@ namespace alib5 {
 
     using Value = CacheValue;
 
+    struct LazyNode;
+
+    /**
+     * @brief Owner of the raw text behind lazily parsed nodes (see `FastJSON::parse_lazy`).
+     */
+    struct ALIB5_API LazySource {
+        virtual ~LazySource() = default;
+
+        /**
+         * @brief Replaces `target` (the `AData` currently holding `node`) with a real object / array.
+         * 
+         * @details Direct children that are containers stay lazy, only one level is built per call.
+         */
+        virtual void materialize(LazyNode node, void* target) const = 0;
+    };
+
+    /**
+     * @brief Placeholder of an object / array that has not been materialized yet.
+     */
+    struct LazyNode {
+        const LazySource* source;
+        uint32_t position; ///< Opaque to everyone but `source`
+        bool is_object;
+    };
+
+    /**
+     * @brief Returns a process-wide unique, non-zero stamp for `Object::layout_stamp`.
+     */
+    uint64_t ALIB5_API next_layout_stamp();
+
+    /**
+     * @brief Memory resource that additionally interns object keys of the documents built on it.
+     * 
+     * @details
+     * English: Build a document on top of a pool (`AData doc(&pool)`) and every object key too long to be stored
+     * inline is kept once in the pool, so arrays of homogeneous records stop storing the same long keys over and
+     * over. Other allocations are forwarded to the upstream resource. Interned keys are only released with the
+     * pool, which must outlive every document using it. Not thread-safe, same as `AData`.
+     * Chinese: 在pool上构建文档(`AData doc(&pool)`)后,所有放不进entry的长键只在pool中保存一份,
+     * 同构记录组成的数组不再重复保存相同的键。其他分配转发给上游资源。驻留的键随pool一起释放,
+     * pool的生命周期必须长于使用它的文档。和`AData`一样线程不安全
+     */
+    class ALIB5_API KeyPool : public std::pmr::memory_resource {
+        struct Slot {
+            const char* data;
+            uint32_t length;
+            uint32_t hash;
+        };
+        std::pmr::memory_resource* upstream;
+        std::pmr::monotonic_buffer_resource arena;
+        std::pmr::vector<Slot> table;
+        size_t count { 0 };
+
+        void grow();
+
+    public:
+        explicit KeyPool(std::pmr::memory_resource* __upstream = ALIB5_DEFAULT_MEMORY_RESOURCE)
+        : upstream(__upstream), arena(__upstream), table(__upstream) {}
+
+        KeyPool(const KeyPool&) = delete;
+        KeyPool& operator=(const KeyPool&) = delete;
+
+        /**
+         * @brief Returns the pooled copy of `key`, adding it if missing.
+         * @param hash Must be `Object::hash_key(key)`.
+         */
+        const char* intern(std::string_view key, uint32_t hash);
+
+        /**
+         * @brief Number of distinct keys interned so far.
+         */
+        inline size_t size() const { return count; }
+
+        inline std::pmr::memory_resource* upstream_resource() const { return upstream; }
+
+    protected:
+        void* do_allocate(size_t bytes, size_t alignment) override {
+            return upstream->allocate(bytes, alignment);
+        }
+
+        void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+            upstream->deallocate(p, bytes, alignment);
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+            return this == &other;
+        }
+    };
+
     /**
      * @brief A generic dynamic data node representing Null, CacheValue, Object, or Array.
      * 
-     * @warning Not thread-safe regardless of const qualification.
+     * @details
+     * English: Objects and arrays are reference counted and copied on write. Copying a node only shares its payload,
+     * the first non-const access to a shared payload duplicates that one level (its children are shared again), so
+     * a copy that is changed in a few places only duplicates the paths leading to them. `detach()` makes a copy
+     * that shares nothing.
+     * A payload whose insides were handed out for writing (non-const `object()`, `array()`, `operator[]`,
+     * iterators ...) is marked leaked: a reference into it may still be written through, so copies duplicate it
+     * instead of sharing it. Copies themselves start unleaked, `seal()` clears the mark when no such reference is
+     * kept anymore.
+     * Chinese: 对象和数组带引用计数,写时复制。拷贝节点只共享负载,第一次对共享负载的非const访问只复制这一层
+     * (子节点继续共享),所以只改动少数几处的拷贝只会复制通往这些地方的路径。`detach()`得到完全不共享的拷贝。
+     * 内部被以可写方式交出去过的负载(非const的`object()`、`array()`、`operator[]`、迭代器等)会被标记为泄漏:
+     * 外面可能还拿着可以写入的引用,所以拷贝时复制它而不是共享。拷贝出来的负载没有这个标记,确认不再持有这类引用后可以用`seal()`清掉
+     * 
+     * @warning Not thread-safe regardless of const qualification. Copies sharing a payload may be used from
+     * different threads (the count is atomic), but `structural_hash()` and `CompiledPath` write caches into the
+     * shared nodes even through const access.
      */
     template<class ValueType = CacheValue>
     struct ALIB5_API BasicAData {
@@ -438,43 +646,142 @@ namespace alib5 {
          */
         struct ALIB5_API Object {
             using container_t = ecs::detail::LinearStorage<data_type>;
+
+            /**
+             * @brief A key, its cached hash and the slot of its child in `children` (32 bytes).
+             * 
+             * @details
+             * English: Keys up to `inline_capacity` bytes are stored inside the entry. Longer keys live outside,
+             * either allocated from the object's memory resource or interned in a `KeyPool`.
+             * Chinese: 不超过`inline_capacity`字节的键直接存放在entry里,更长的键从对象的内存资源分配,
+             * 或者驻留在`KeyPool`中
+             */
+            struct Entry {
+                constexpr static size_t inline_capacity = 23;
+                constexpr static uint8_t tag_external = 0x80; ///< Key lives outside of the entry
+                constexpr static uint8_t tag_owned = 0x40; ///< External key allocated by the object itself
+
+                /// Inline key bytes, or pointer + length of an external key. The last byte is the tag / inline length.
+                char storage[inline_capacity + 1];
+                uint32_t hash;
+                uint32_t index;
+
+                inline uint8_t tag() const { return (uint8_t)storage[inline_capacity]; }
+                inline bool is_external() const { return tag() & tag_external; }
+                inline bool is_owned() const { return tag() & tag_owned; }
+
+                inline std::string_view key() const {
+                    if(!is_external()) return std::string_view(storage, tag());
+                    const char* p;
+                    uint32_t len;
+                    std::memcpy(&p, storage, sizeof(p));
+                    std::memcpy(&len, storage + sizeof(p), sizeof(len));
+                    return std::string_view(p, len);
+                }
+
+                inline void set_inline(std::string_view k) {
+                    std::memcpy(storage, k.data(), k.size());
+                    storage[inline_capacity] = (char)k.size();
+                }
+
+                inline void set_external(const char* p, uint32_t len, bool owned) {
+                    std::memcpy(storage, &p, sizeof(p));
+                    std::memcpy(storage + sizeof(p), &len, sizeof(len));
+                    storage[inline_capacity] = (char)(tag_external | (owned ? tag_owned : 0));
+                }
+            };
+            static_assert(sizeof(Entry) == 32);
+            using entries_t = std::pmr::vector<Entry>;
             
             container_t children; ///< Storage for child nodes.
-            
-            std::pmr::unordered_map<
-                std::pmr::string,
-                size_t,
-                detail::TransparentStringHash,
-                detail::TransparentStringEqual
-            > object_mapper; ///< Key to index mapping.
+            entries_t entries; ///< Keys of the object, searched linearly while small.
+            /**
+             * @brief Open addressing index into `entries` (position + 1, 0 means empty).
+             * 
+             * @details
+             * English: Stays empty until the object grows past `conf_object_linear_threshold`.
+             * Chinese: 对象超过`conf_object_linear_threshold`个键后才会建立
+             */
+            std::pmr::vector<uint32_t> slots;
+            /// Lazily assigned by `layout_stamp()`, reset to 0 whenever a key -> slot mapping changes.
+            mutable uint64_t stamp { 0 };
         
             Object(std::pmr::memory_resource* __a = ALIB5_DEFAULT_MEMORY_RESOURCE);
             
             Object(const Object& other, std::pmr::memory_resource* a)
-            : children(other.children, a), object_mapper(other.object_mapper, a) {}
+            : children(other.children, a), entries(a), slots(other.slots, a) {
+                copy_entries(other);
+            }
+
+            Object(const Object& other) : Object(other, other.resource()) {}
 
             Object(Object&& other) ALIB5_NOEXCEPT
-            : children(std::move(other.children)), object_mapper(std::move(other.object_mapper)) {}
+            : children(std::move(other.children)), entries(std::move(other.entries)), slots(std::move(other.slots)) {
+                other.stamp = 0;
+            }
 
             Object(Object&& other, std::pmr::memory_resource* a)
-            : children(std::move(other.children), a), object_mapper(std::move(other.object_mapper), a) {}
+            : children(std::move(other.children), a), entries(a), slots(std::move(other.slots), a) {
+                // 资源相同时键的所有权可以直接转移
+                if(other.resource() == a) entries.swap(other.entries);
+                else copy_entries(other);
+                other.stamp = 0;
+            }
 
             Object& operator=(const Object& other) {
                 if(this == &other) [[unlikely]] return *this;
+                clear();
                 children = other.children;
-                object_mapper = other.object_mapper;
+                slots = other.slots;
+                copy_entries(other);
                 return *this;
             }
 
             Object& operator=(Object&& other) ALIB5_NOEXCEPT {
                 if(this == &other) [[unlikely]] return *this;
+                clear();
                 children = std::move(other.children);
-                object_mapper = std::move(other.object_mapper);
+                slots = std::move(other.slots);
+                if(other.resource() == resource()) entries.swap(other.entries);
+                else copy_entries(other);
+                other.stamp = 0;
                 return *this;
             }
 
+            ~Object() {
+                for(auto& e : entries) release_key(e);
+            }
+
+            inline std::pmr::memory_resource* resource() const { return entries.get_allocator().resource(); }
+
+            /**
+             * @brief Identifies the current key -> slot layout of this object.
+             * 
+             * @details
+             * English: Two equal stamps mean the same object with unchanged key -> slot mappings, so a slot resolved
+             * earlier can be loaded directly. Adding keys keeps the stamp since existing slots never move, while
+             * remove / rename / clear / assignment change it. Used by `CompiledPath`.
+             * Chinese: 相同的stamp代表同一个对象且键到槽位的映射没有变化,之前解析出的槽位可以直接使用。
+             * 新增键不会移动已有槽位因此stamp不变,remove / rename / clear / 赋值会改变它。供`CompiledPath`使用
+             */
+            inline uint64_t layout_stamp() const {
+                if(!stamp) stamp = next_layout_stamp();
+                return stamp;
+            }
+
+            inline static uint32_t hash_key(std::string_view key) {
+                return (uint32_t)detail::TransparentStringHash{}(key);
+            }
+
+            /**
+             * @brief Position of `key` in `entries`, `entries.size()` if missing.
+             */
+            size_t find_entry(std::string_view key, uint32_t hash) const;
+            inline size_t find_entry(std::string_view key) const { return find_entry(key, hash_key(key)); }
+
             void reserve(size_t buffer_size) {
                 children.reserve(buffer_size);
+                entries.reserve(buffer_size);
             }
             
             /**
@@ -484,9 +791,25 @@ namespace alib5 {
              * English: Object has strict requirements for index alignment, so multithreaded operations must be locked by the user.
              * Chinese: Object对索引对齐要求十分严格,因此多线程操作一定要自己加锁
              */
-            std::pair<data_type*, size_t> ALIB5_API ensure_node(std::string_view key);
+            std::pair<data_type*, size_t> ALIB5_API ensure_node(std::string_view key) { return ensure_node(key, false); }
+
+            /**
+             * @brief Like `ensure_node`, but a new key longer than `Entry::inline_capacity` is referenced instead of copied.
+             *
+             * @details
+             * English: `key` must outlive this object and every copy of it on the same memory resource (copies to
+             * another resource copy the key). `JSON::parse_insitu` uses it for keys inside a `JSONDocument` buffer,
+             * whose nodes live on the document's arena and so never outlive the buffer.
+             * Chinese: `key`必须比这个对象以及它在同一内存资源上的所有拷贝活得更久(拷贝到别的资源时会复制键)。
+             * `JSON::parse_insitu`用它引用`JSONDocument`缓冲区里的键,节点都在文档的arena上,不会比缓冲区活得久
+             */
+            std::pair<data_type*, size_t> ensure_node_borrowed(std::string_view key) { return ensure_node(key, true); }
             
             bool ALIB5_API rename(std::string_view old_name, std::string_view new_name);
+
+            /**
+             * @brief Removes a key. The last key is moved into its position, so iteration order changes.
+             */
             bool ALIB5_API remove(std::string_view name);
 
             /**
@@ -501,9 +824,9 @@ namespace alib5 {
             }
         
             inline const data_type* at_ptr(std::string_view visit) const {
-                auto it = object_mapper.find(visit);
-                if(it == object_mapper.end()) return nullptr;
-                return &children.data[it->second];
+                size_t pos = find_entry(visit);
+                if(pos == entries.size()) return nullptr;
+                return &children.data[entries[pos].index];
             }
             
             inline data_type* at_ptr(std::string_view visit) {
@@ -513,8 +836,11 @@ namespace alib5 {
             }
 
             inline void clear() {
+                for(auto& e : entries) release_key(e);
+                stamp = 0;
                 children.clear();
-                object_mapper.clear();
+                entries.clear();
+                slots.clear();
             }
 
             /**
@@ -526,10 +852,10 @@ namespace alib5 {
                 return *a;
             }
 
-            inline size_t size() const { return object_mapper.size(); }
-            inline bool empty() const { return !object_mapper.size(); }
+            inline size_t size() const { return entries.size(); }
+            inline bool empty() const { return entries.empty(); }
             inline bool contains(std::string_view key) const {
-                return object_mapper.find(key) != object_mapper.end();
+                return find_entry(key) != entries.size();
             }
 
             template<bool is_const>
@@ -541,8 +867,8 @@ namespace alib5 {
                 using reference = std::conditional_t<is_const, const value_type&, value_type&>;
                 
                 using it_type = std::conditional_t<is_const,
-                    typename decltype(object_mapper)::const_iterator,
-                    typename decltype(object_mapper)::iterator
+                    typename entries_t::const_iterator,
+                    typename entries_t::iterator
                 >;
                 using cont_ref = std::conditional_t<is_const, const container_t&, container_t&>;
                 
@@ -550,37 +876,60 @@ namespace alib5 {
                 cont_ref cont;
 
                 struct Proxy {
-                    const std::pmr::string& _first;
+                    std::string_view _first;
                     reference _second;
+                    uint32_t _hash;
 
-                    auto& first() const { return _first; }
+                    std::string_view first() const { return _first; }
                     reference second() const { return _second; }
+                    /// Cached hash of the key, see `find(key, hash)`
+                    uint32_t hash() const { return _hash; }
                 };
 
                 ObjectIterator(it_type iter, cont_ref container) : it(iter), cont(container) {}
 
-                auto& first() const { return it->first; }
-                auto& second() const { return cont.data[it->second]; }
+                std::string_view first() const { return it->key(); }
+                auto& second() const { return cont.data[it->index]; }
+                /// Slot of the child in `children`
+                size_t index() const { return it->index; }
+                uint32_t hash() const { return it->hash; }
 
-                auto operator*() const { return Proxy{it->first, cont.data[it->second]}; }
+                auto operator*() const { return Proxy{it->key(), cont.data[it->index], it->hash}; }
                 auto& operator++() { ++it; return *this; }
                 auto operator++(int) { auto old = *this; ++it; return old; }
                 bool operator==(const ObjectIterator& other) const { return it == other.it; }
                 bool operator!=(const ObjectIterator& other) const { return it != other.it; }
-                auto operator->() const { return Proxy{it->first, cont.data[it->second]}; } 
+                auto operator->() const { return Proxy{it->key(), cont.data[it->index], it->hash}; } 
             };
 
             using iterator = ObjectIterator<false>;
             using const_iterator = ObjectIterator<true>;
             using value_type = decltype(children.data)::value_type;
 
-            iterator begin() { return {object_mapper.begin(), children}; }
-            const_iterator begin() const { return {object_mapper.begin(), children}; }
-            iterator end() { return {object_mapper.end(), children}; }
-            const_iterator end() const { return {object_mapper.end(), children}; }
+            iterator begin() { return {entries.begin(), children}; }
+            const_iterator begin() const { return {entries.begin(), children}; }
+            iterator end() { return {entries.end(), children}; }
+            const_iterator end() const { return {entries.end(), children}; }
         
-            iterator find(std::string_view d) { return {object_mapper.find(d), children}; }
-            const_iterator find(std::string_view d) const { return {object_mapper.find(d), children}; }
+            iterator find(std::string_view d) { return {entries.begin() + find_entry(d), children}; }
+            const_iterator find(std::string_view d) const { return {entries.begin() + find_entry(d), children}; }
+
+            /**
+             * @brief Lookup with a hash cached by another object (`Proxy::hash`), skips rehashing the key.
+             */
+            iterator find(std::string_view d, uint32_t hash) { return {entries.begin() + find_entry(d, hash), children}; }
+            const_iterator find(std::string_view d, uint32_t hash) const { return {entries.begin() + find_entry(d, hash), children}; }
+
+        private:
+            std::pair<data_type*, size_t> ensure_node(std::string_view key, bool borrow);
+            void assign_key(Entry& e, std::string_view key);
+            void release_key(Entry& e);
+            void copy_entries(const Object& other);
+            void place_slot(size_t pos);
+            size_t slot_of(size_t pos) const;
+            void erase_slot(size_t pos);
+            void rebuild_slots();
+            void after_insert();
         };
 
         /**
@@ -653,29 +1002,165 @@ namespace alib5 {
         };
 
     private:
-        std::variant<std::monostate, value_type, Object, Array> data;
+        /**
+         * @brief Reference counted payload of an object / array.
+         * 
+         * @details
+         * English: Only a moved-from handle is empty, the owning node never sees one.
+         * Chinese: 只有被移走的句柄为空,持有它的节点不会看到空句柄
+         */
+        template<class C>
+        class Shared {
+            struct Box {
+                std::atomic<uint32_t> refs { 1 };
+                /// 已经确认子树中没有惰性节点,拷贝时可以直接共享
+                std::atomic<bool> settled { false };
+                /// 内部的引用被以可写方式交出去过,不能再共享
+                std::atomic<bool> leaked { false };
+                std::pmr::memory_resource* res;
+                C payload;
+
+                Box(std::pmr::memory_resource* a) : res(a), payload(a) {}
+                Box(const C& other, std::pmr::memory_resource* a) : res(a), payload(other, a) {}
+            };
+            Box* box { nullptr };
+
+            template<class... Args>
+            static Box* make(std::pmr::memory_resource* a, Args&&... args) {
+                std::pmr::polymorphic_allocator<Box> alloc(a);
+                Box* b = alloc.allocate(1);
+                ::new(b) Box(std::forward<Args>(args)..., a);
+                return b;
+            }
+
+            void release() {
+                if(box && box->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    std::pmr::polymorphic_allocator<Box> alloc(box->res);
+                    box->~Box();
+                    alloc.deallocate(box, 1);
+                }
+                box = nullptr;
+            }
+
+        public:
+            explicit Shared(std::pmr::memory_resource* a) : box(make(a)) {}
+            Shared(const C& other, std::pmr::memory_resource* a) : box(make(a, other)) {}
+            Shared(const Shared& other) : box(other.box) { if(box) box->refs.fetch_add(1, std::memory_order_relaxed); }
+            Shared(Shared&& other) ALIB5_NOEXCEPT : box(std::exchange(other.box, nullptr)) {}
+
+            Shared& operator=(const Shared& other) {
+                if(box == other.box) return *this;
+                Shared tmp(other);
+                std::swap(box, tmp.box);
+                return *this;
+            }
+
+            Shared& operator=(Shared&& other) ALIB5_NOEXCEPT {
+                if(this == &other) return *this;
+                release();
+                box = std::exchange(other.box, nullptr);
+                return *this;
+            }
+
+            ~Shared() { release(); }
+
+            inline const C& get() const { return box->payload; }
+            inline std::pmr::memory_resource* resource() const { return box->res; }
+            inline bool same(const Shared& other) const { return box == other.box; }
+            inline uint32_t use_count() const { return box->refs.load(std::memory_order_relaxed); }
+            /// 泄漏的负载可能经由外面的引用放进惰性节点,不算settled
+            inline bool settled() const {
+                return box->settled.load(std::memory_order_acquire) && !box->leaked.load(std::memory_order_relaxed);
+            }
+            inline void mark_settled() const { box->settled.store(true, std::memory_order_release); }
+            inline bool leaked() const { return box->leaked.load(std::memory_order_relaxed); }
+            /// 只能在确认没有外部引用时调用
+            inline void seal() { box->leaked.store(false, std::memory_order_relaxed); }
+
+            /**
+             * @brief Payload for writing that stays inside the node, duplicated first if it is shared.
+             */
+            C& own() {
+                if(box->refs.load(std::memory_order_acquire) != 1) {
+                    Box* b = make(box->res, box->payload);
+                    release();
+                    box = b;
+                }
+                // 可写的负载里随时可能放进惰性节点
+                box->settled.store(false, std::memory_order_relaxed);
+                return box->payload;
+            }
+
+            /**
+             * @brief Payload for writing that is handed out to the caller, marks it leaked.
+             */
+            C& unique() {
+                C& c = own();
+                box->leaked.store(true, std::memory_order_relaxed);
+                return c;
+            }
+        };
+
+        std::variant<std::monostate, value_type, Shared<Object>, Shared<Array>, LazyNode> data;
+        constexpr static size_t lazy_index = 4;
         std::pmr::memory_resource* allocator;
+        /// Cached `structural_hash()`, 0 while unknown. Cleared by every non-const access to this node, only set on unleaked objects / arrays.
+        mutable uint64_t hash_cache { 0 };
         
+        template<class T>
+        static constexpr bool is_container = std::is_same_v<T, Object> || std::is_same_v<T, Array>;
+
+        template<class T>
+        using storage_t = std::conditional_t<is_container<T>, Shared<T>, T>;
+
+        [[noreturn]] void __type_mismatch(const char* requested) const {
+            vpanicf_if(true,
+                "Type doesnt match! CurrentId:{} (0 null, 1 value, 2 object, 3 array), RequestedType:{}",
+                (int)get_type(), requested);
+            std::abort();
+        }
+
         template<class T> 
-        auto& __get_value() const {
+        const auto& __get_value() const {
             using type = std::decay_t<T>;
-            const type* f = std::get_if<type>(&data);
-            [[likely]] if(f) {
-                return *f;
+            const storage_t<type>* f = std::get_if<storage_t<type>>(&data);
+            if constexpr(is_container<type>) {
+                [[unlikely]] if(!f && is_lazy()) {
+                    materialize();
+                    f = std::get_if<storage_t<type>>(&data);
+                }
+                [[likely]] if(f) return f->get();
+            } else {
+                [[likely]] if(f) return *f;
             }
-            vpanicf_if(!f,
-                "Type doesnt match! CurrentId:{} (0 null, 1 value, 2 object, 3 array), RequestedType:{}",
-                (int)get_type(), typeid(type).name());
-            std::abort();
+            __type_mismatch(typeid(type).name());
         }
 
         template<class T> 
         inline auto& __get_value() {
-            return const_cast<std::decay_t<T>&>(
-                static_cast<const BasicAData*>(this)->__get_value<T>()
-            );
+            using type = std::decay_t<T>;
+            // 拿到可修改的引用就视为修改
+            hash_cache = 0;
+            if constexpr(is_container<type>) {
+                // 先确保类型正确(并物化惰性节点),共享的负载在这里复制一份
+                static_cast<const BasicAData*>(this)->__get_value<type>();
+                return std::get_if<Shared<type>>(&data)->unique();
+            } else {
+                return const_cast<type&>(
+                    static_cast<const BasicAData*>(this)->__get_value<type>()
+                );
+            }
         }
 
+        /**
+         * @brief Materializes the lazy nodes below every unsettled payload, then marks those payloads settled.
+         * 
+         * @details
+         * English: Copies must not refer to a lazy source, this keeps copying O(1) once a tree has been checked.
+         * Chinese: 拷贝不能引用惰性数据源,树检查过一次之后拷贝就是O(1)的
+         */
+        void __settle() const;
+
         template<class T> 
         auto& __ensure_type() {
             using type = std::decay_t<T>;
@@ -686,7 +1171,16 @@ namespace alib5 {
             }
         }
 
-        static auto clone_data(const decltype(data)& src, std::pmr::memory_resource* res) {
+        /**
+         * @brief Copies `owner`'s payload for a node allocating from `res`.
+         * 
+         * @details Objects and arrays on the same resource are shared unless leaked, otherwise one level is copied.
+         */
+        static auto clone_data(const BasicAData& owner, std::pmr::memory_resource* res) {
+            const auto& src = owner.data;
+            if(src.index() == 2 || src.index() == 3) {
+                owner.__settle();
+            }
             return std::visit([res](auto&& v) -> decltype(data) {
                 using T = std::decay_t<decltype(v)>;
                 if constexpr (std::is_same_v<T, std::monostate>) return v;
@@ -694,18 +1188,22 @@ namespace alib5 {
                     value_type x(res);
                     x = v;
                     return x; 
-                } else if constexpr (std::is_same_v<T, Object>) {
-                    Object o(res);
-                    o = v;
-                    return o;
+                } else if constexpr (std::is_same_v<T, Shared<Object>> || std::is_same_v<T, Shared<Array>>) {
+                    // 泄漏的负载还可能经由外面的引用写入,复制这一层,子节点按同样的规则处理
+                    if(v.resource() == res && !v.leaked()) return v;
+                    return T(v.get(), res);
                 } else {
-                    Array a(res);
-                    a = v;
-                    return a;
+                    // 拷贝不能继续引用源文本,整棵子树物化
+                    BasicAData tmp(res);
+                    tmp.data = v;
+                    tmp.materialize_all();
+                    return std::move(tmp.data);
                 }
             }, src);
         }
 
+        const BasicAData* __jump(std::string_view path, bool invoke_err, bool touch) const;
+
     public:
         inline std::pmr::memory_resource* get_allocator() { return allocator; }
 
@@ -728,14 +1226,15 @@ namespace alib5 {
         }
 
         BasicAData(const BasicAData& other)
-        : allocator(other.allocator), data(clone_data(other.data, other.allocator)) {}
+        : data(clone_data(other, other.allocator)), allocator(other.allocator), hash_cache(other.hash_cache) {}
         
         BasicAData(BasicAData&& other) ALIB5_NOEXCEPT : allocator(other.allocator) {
             *this = std::move(other);
         }
 
         BasicAData(const BasicAData& other, std::pmr::memory_resource* __a) : allocator(__a) {
-            data = clone_data(other.data, __a);
+            data = clone_data(other, __a);
+            hash_cache = other.hash_cache;
         }
 
         BasicAData(const BasicAData::Object& other, std::pmr::memory_resource* __a = ALIB5_DEFAULT_MEMORY_RESOURCE) : allocator(__a) {
@@ -760,25 +1259,146 @@ namespace alib5 {
         ~BasicAData() = default;
 
         /**
-         * @brief Returns a detached copy of this data.
+         * @brief Returns a deep copy of this data that shares no payload with it.
+         * 
+         * @details
+         * English: Plain copies share objects / arrays until one side writes, use this when references into the
+         * copy are kept while the original may be copied again.
+         * Chinese: 普通拷贝在一方写入之前共享对象/数组,如果要长期持有拷贝内部的引用,而原数据还可能被再次拷贝,用这个
          * 
          * @par Original Comments:
          * English: Solves the crash caused by assignment between parent and child. Issue resolved, API retained for compatibility.
          * Chinese: 解决父子之间赋值出现的crash. 问题已经被处理了,调整了赋值链条,但是api保留一下
          */
-        BasicAData detach() const { return *this; }
+        BasicAData detach() const;
+
+        /**
+         * @brief Declares that no reference or iterator obtained through non-const access into this subtree is used
+         * anymore, so copies may share its payloads again.
+         * 
+         * @details
+         * English: Payloads that were written through are marked leaked and duplicated by every copy, which is the
+         * safe default. Call this after building or editing a tree (a parser result, a batch of edits ...) to get
+         * O(1) copies of it back. Writing through an older reference afterwards is undefined.
+         * Chinese: 被写入过的负载会被标记为泄漏,每次拷贝都会复制它,这是安全的默认行为。构建或编辑完一棵树之后
+         * (解析结果、一批修改等)调用它,拷贝就重新是O(1)的。之后再经由旧的引用写入是未定义行为
+         */
+        void seal();
 
-        inline Type get_type() const { return (Type)data.index(); }
+        /**
+         * @brief True if both nodes refer to the same object / array payload, i.e. one is an unmodified copy of the other.
+         */
+        inline bool shares_payload(const BasicAData& other) const {
+            if(data.index() != other.data.index()) return false;
+            if(auto* l = std::get_if<Shared<Object>>(&data)) return l->same(*std::get_if<Shared<Object>>(&other.data));
+            if(auto* l = std::get_if<Shared<Array>>(&data)) return l->same(*std::get_if<Shared<Array>>(&other.data));
+            return false;
+        }
+
+        /**
+         * @brief True if this node is an object / array whose payload is marked leaked, see `seal()`.
+         */
+        inline bool payload_leaked() const {
+            if(auto* o = std::get_if<Shared<Object>>(&data)) return o->leaked();
+            if(auto* a = std::get_if<Shared<Array>>(&data)) return a->leaked();
+            return false;
+        }
+
+        inline Type get_type() const {
+            size_t i = data.index();
+            [[unlikely]] if(i == lazy_index) return std::get<LazyNode>(data).is_object ? TObject : TArray;
+            return (Type)i;
+        }
+
+        /**
+         * @brief True for an object / array from a lazy parse that has not been accessed yet.
+         */
+        inline bool is_lazy() const { return data.index() == lazy_index; }
+
+        /**
+         * @brief Builds a lazy node (one level) now, no-op for other nodes.
+         * 
+         * @details
+         * English: `object()` / `array()` call this on demand, even through const references.
+         * Chinese: `object()` / `array()` 会按需调用,即使是通过const引用访问
+         */
+        void materialize() const {
+            if(const LazyNode* n = std::get_if<LazyNode>(&data)) {
+                LazyNode node = *n;
+                node.source->materialize(node, const_cast<BasicAData*>(this));
+            }
+        }
+
+        /**
+         * @brief Materializes the whole subtree, afterwards nothing refers to the lazy source anymore.
+         */
+        void materialize_all() const;
+
+        /**
+         * @brief Turns this node into a lazy placeholder, used by `LazySource` implementations.
+         */
+        void set_lazy(LazyNode node) {
+            hash_cache = 0;
+            data.template emplace<LazyNode>(node);
+        }
         inline bool is_null() const { return get_type() == TNull; }
         inline bool is_object() const { return get_type() == TObject; }
         inline bool is_array() const { return get_type() == TArray; }
         inline bool is_value() const { return get_type() == TValue; }
 
+        /**
+         * @brief Compares two trees.
+         * 
+         * @details
+         * English: Where both sides carry a cached `structural_hash()`, equal hashes end the comparison of that
+         * subtree, under `Strict` different hashes also mean "not equal". Otherwise the trees are walked.
+         * Chinese: 两边都有缓存的哈希时,哈希相同直接视为子树相等;Strict下哈希不同即不相等。否则逐节点比较
+         */
         static bool equals(const BasicAData& left, const BasicAData& right, CompareStrategy strategy = CompareStrategy::Strict);
         bool equals(const BasicAData& b, CompareStrategy strategy = CompareStrategy::Strict) const {
             return equals(*this, b, strategy);
         }
 
+        /**
+         * @brief Merkle hash of this subtree, computed on first use and cached in every node of it.
+         * 
+         * @details
+         * English: Trees that are equal under `CompareStrategy::Strict` hash the same (key order does not matter),
+         * so the hash can key content-addressed caches. Hashing is opt-in: nothing is computed until this is
+         * called, later calls only rehash what changed since. The hash is cached on objects and arrays whose payload
+         * is not leaked (see `seal()`): every non-const access to a node drops its cached hash, and a reference that
+         * can still write below a node implies its payload is leaked, so a cached hash is never stale. On a tree that
+         * is being written through (every payload leaked) nothing is cached, copy it or call `seal()` when done.
+         * Values are cheap to hash and never cached. Subtrees holding NaN are never cached and hash to 0.
+         * Chinese: Strict下相等的树哈希相同(与键的顺序无关),可以作为按内容寻址的缓存键。只有调用时才会计算,
+         * 之后只重算发生变化的部分。哈希缓存在负载没有泄漏(见`seal()`)的对象和数组上:对节点的非const访问会清掉它的缓存,
+         * 而还能写入其下方的引用意味着它的负载已经泄漏,所以缓存不会过期。正在被写入的树(负载全部泄漏)不会缓存,
+         * 写完之后拷贝一份或者调用`seal()`。值的哈希很便宜,不缓存。包含NaN的子树不会被缓存,哈希为0
+         * 
+         * @warning Not thread-safe, even though it is const.
+         */
+        uint64_t structural_hash() const;
+
+        /**
+         * @brief The cached `structural_hash()`, 0 if it is not known.
+         */
+        inline uint64_t cached_hash() const { return hash_cache; }
+
+        /**
+         * @brief Drops the cached hash of this node.
+         * 
+         * @details Only needed by code that writes into a payload without going through the node, its parents do
+         * not cache while it can be reached that way.
+         */
+        inline void invalidate_hash() const { hash_cache = 0; }
+
+        /**
+         * @brief True if both nodes carry the same cached hash, i.e. they are known to be equal.
+         */
+        static inline bool same_cached_hash(const BasicAData& left, const BasicAData& right) {
+            return left.hash_cache && left.hash_cache == right.hash_cache;
+        }
+
         value_type& value() { return __get_value<value_type>(); }
         Object& object() { return __get_value<Object>(); }
         Array& array() { return __get_value<Array>(); }
@@ -811,12 +1431,15 @@ namespace alib5 {
             using safe_t = std::remove_cv_t<decltype(data)>;
             if(this == &other) return *this;
             safe_t d = std::move(other.data);
+            hash_cache = other.hash_cache;
             other.set<std::monostate>();
 
             if(this->allocator == other.allocator) {
                 this->data = std::move(d);
             } else {
-                this->data = clone_data(d, allocator);
+                BasicAData tmp(other.allocator);
+                tmp.data = std::move(d);
+                this->data = clone_data(tmp, allocator);
             }
             return *this;
         }
@@ -848,12 +1471,11 @@ namespace alib5 {
                 std::abort();
             }
             
-            if(val.allocator == this->allocator) {
-                decltype(data) safe_d = clone_data(val.data, allocator);
-                data = std::move(safe_d);
-            } else {
-                this->data = clone_data(val.data, allocator);
-            }
+            // val可能就在当前负载里面,替换之后不能再访问
+            uint64_t h = val.hash_cache;
+            decltype(data) safe_d = clone_data(val, allocator);
+            data = std::move(safe_d);
+            hash_cache = h;
             return *this;
         }
 
@@ -900,12 +1522,15 @@ namespace alib5 {
         /**
          * @brief Jumps to a specific pointer path. Returns nullptr if missing.
          */
-        const BasicAData* ALIB5_API jump_ptr(std::string_view path, bool invoke_err = true) const;
+        const BasicAData* jump_ptr(std::string_view path, bool invoke_err = true) const {
+            return __jump(path, invoke_err, false);
+        }
 
+        /**
+         * @brief Drops the cached hashes along the path, the result may be modified.
+         */
         BasicAData* jump_ptr(std::string_view path, bool invoke_err = true) {
-            return const_cast<BasicAData*>(
-                (((const BasicAData*)this)->jump_ptr(path, invoke_err))
-            );
+            return const_cast<BasicAData*>(__jump(path, invoke_err, true));
         }
 
         BasicAData& jump(std::string_view path, bool invoke_err = true) {
@@ -1064,10 +1689,12 @@ namespace alib5 {
 namespace alib5 {
     inline void CacheValue::sync_to_string() const {
         if(!data_dirt) return;
+        // assign会复用已有容量,短数字也在SSO以内,一般不会分配
+        char buf[32];
         switch(type) {
-            case INT:      data = ext::to_string(integer); break;
-            case FLOATING: data = ext::to_string(floating); break;
-            case BOOL:     data = ext::to_string(boolean); break;
+            case INT:      data.assign(detail::scalar_to_chars(buf, integer)); break;
+            case FLOATING: data.assign(detail::scalar_to_chars(buf, floating)); break;
+            case BOOL:     data.assign(detail::scalar_to_chars(buf, boolean)); break;
             default: break;
         }
         data_dirt = false;
@@ -1143,7 +1770,10 @@ namespace alib5 {
     inline auto CacheValue::expect() const {
         auto make_value = [this]<class T1>(T1& val) {
             if constexpr(IsStringLike<T>) {
-                if(data_dirt) back_sync(ext::to_string(val));
+                if(data_dirt) {
+                    char buf[32];
+                    back_sync(detail::scalar_to_chars(buf, val));
+                }
                 return std::make_pair(std::string_view(data), true);
             } else return std::make_pair(T(val), true);
         };
@@ -1256,15 +1886,16 @@ namespace alib5 {
         if(type == STRING) return data;
 
         auto& buffer = stringify_buffer();
+        char buf[32];
         switch(type) {
         case INT:
-            buffer = ext::to_string(integer);
+            buffer.assign(detail::scalar_to_chars(buf, integer));
             break;
         case FLOATING:
-            buffer = ext::to_string(floating);
+            buffer.assign(detail::scalar_to_chars(buf, floating));
             break;
         case BOOL:
-            buffer = ext::to_string(boolean);
+            buffer.assign(detail::scalar_to_chars(buf, boolean));
             break;
         case STRING:
             break;
@@ -1346,7 +1977,8 @@ namespace alib5 {
         auto make_value = [this]<class T1>(const T1& val) {
             if constexpr(IsStringLike<T>) {
                 auto& buffer = stringify_buffer();
-                buffer = ext::to_string(val);
+                char buf[32];
+                buffer.assign(detail::scalar_to_chars(buf, val));
                 return std::make_pair(std::string_view(buffer), true);
             } else {
                 return std::make_pair(T(val), true);
@@ -1459,49 +2091,182 @@ namespace alib5 {
     template<class V>
     inline BasicAData<V>::Object::Object(std::pmr::memory_resource* __a)
         : children(0, __a, __a)
-        , object_mapper(__a) {}
+        , entries(__a)
+        , slots(__a) {}
+
+    template<class V>
+    inline size_t BasicAData<V>::Object::find_entry(std::string_view key, uint32_t hash) const {
+        if(slots.empty()) {
+            for(size_t i = 0; i < entries.size(); ++i) {
+                if(entries[i].hash == hash && entries[i].key() == key) return i;
+            }
+            return entries.size();
+        }
+        size_t mask = slots.size() - 1;
+        for(size_t i = hash & mask; slots[i]; i = (i + 1) & mask) {
+            const Entry& e = entries[slots[i] - 1];
+            if(e.hash == hash && e.key() == key) return slots[i] - 1;
+        }
+        return entries.size();
+    }
+
+    template<class V>
+    inline void BasicAData<V>::Object::place_slot(size_t pos) {
+        size_t mask = slots.size() - 1;
+        size_t i = entries[pos].hash & mask;
+        while(slots[i]) i = (i + 1) & mask;
+        slots[i] = (uint32_t)(pos + 1);
+    }
 
     template<class V>
-    inline std::pair<BasicAData<V>*, size_t> BasicAData<V>::Object::ensure_node(std::string_view key) {
-        auto it = object_mapper.find(key);
-        if(it != object_mapper.end()) {
-            return std::make_pair(&children[it->second], it->second);
+    inline size_t BasicAData<V>::Object::slot_of(size_t pos) const {
+        size_t mask = slots.size() - 1;
+        size_t i = entries[pos].hash & mask;
+        while(slots[i] != pos + 1) i = (i + 1) & mask;
+        return i;
+    }
+
+    template<class V>
+    inline void BasicAData<V>::Object::erase_slot(size_t pos) {
+        // 线性探测的后移删除,不留墓碑
+        size_t mask = slots.size() - 1;
+        size_t hole = slot_of(pos);
+        for(size_t j = (hole + 1) & mask; slots[j]; j = (j + 1) & mask) {
+            size_t home = entries[slots[j] - 1].hash & mask;
+            // home不在(hole, j]之间时才能挪到hole
+            bool movable = hole <= j ? (home <= hole || home > j) : (home <= hole && home > j);
+            if(movable) {
+                slots[hole] = slots[j];
+                hole = j;
+            }
         }
+        slots[hole] = 0;
+    }
 
-        auto alloc = object_mapper.get_allocator();
+    template<class V>
+    inline void BasicAData<V>::Object::rebuild_slots() {
+        // 负载因子保持在1/2以下
+        slots.assign(std::bit_ceil(entries.size() * 2), 0);
+        for(size_t i = 0; i < entries.size(); ++i) place_slot(i);
+    }
+
+    template<class V>
+    inline void BasicAData<V>::Object::after_insert() {
+        if(slots.empty()) {
+            if(entries.size() > conf_object_linear_threshold) rebuild_slots();
+        } else if(entries.size() * 2 > slots.size()) {
+            rebuild_slots();
+        } else {
+            place_slot(entries.size() - 1);
+        }
+    }
+
+    template<class V>
+    inline void BasicAData<V>::Object::assign_key(Entry& e, std::string_view key) {
+        if(key.size() <= Entry::inline_capacity) {
+            e.set_inline(key);
+            return;
+        }
+        panic_if(key.size() > UINT32_MAX, "Key is too long!");
+        auto* res = resource();
+        // 只有长键才需要判断,短键本来就不分配内存
+        if(auto* pool = dynamic_cast<KeyPool*>(res)) {
+            e.set_external(pool->intern(key, e.hash), (uint32_t)key.size(), false);
+            return;
+        }
+        char* p = static_cast<char*>(res->allocate(key.size(), 1));
+        std::memcpy(p, key.data(), key.size());
+        e.set_external(p, (uint32_t)key.size(), true);
+    }
+
+    template<class V>
+    inline void BasicAData<V>::Object::release_key(Entry& e) {
+        if(!e.is_owned()) return;
+        auto k = e.key();
+        resource()->deallocate(const_cast<char*>(k.data()), k.size(), 1);
+    }
+
+    template<class V>
+    inline void BasicAData<V>::Object::copy_entries(const Object& other) {
+        entries.reserve(other.entries.size());
+        bool same_pool = other.resource() == resource();
+        for(const Entry& src : other.entries) {
+            Entry& e = entries.emplace_back(src);
+            // 同一个KeyPool里驻留的键直接共享,其余外部键重新分配或驻留
+            if(src.is_external() && !(same_pool && !src.is_owned())) {
+                assign_key(e, src.key());
+            }
+        }
+    }
+
+    template<class V>
+    inline std::pair<BasicAData<V>*, size_t> BasicAData<V>::Object::ensure_node(std::string_view key, bool borrow) {
+        uint32_t hash = hash_key(key);
+        size_t pos = find_entry(key, hash);
+        if(pos != entries.size()) {
+            size_t index = entries[pos].index;
+            return std::make_pair(&children[index], index);
+        }
+
+        auto res = entries.get_allocator().resource();
         size_t index = 0;
         bool flag;
-        BasicAData<V>& node = children.try_next_with_index(flag, index, alloc.resource());
-        object_mapper.emplace(std::pmr::string(key, alloc), index);
+        BasicAData<V>& node = children.try_next_with_index(flag, index, res);
+        panic_if(index > UINT32_MAX, "Too many children in one object!");
+        // 先在局部构造,key可能指向本对象某个entry,扩容后会失效
+        Entry e {};
+        e.hash = hash;
+        e.index = (uint32_t)index;
+        // 不拥有的外部键在拷贝到同一资源时共享,和KeyPool里驻留的键一样
+        if(borrow && key.size() > Entry::inline_capacity && key.size() <= UINT32_MAX) e.set_external(key.data(), (uint32_t)key.size(), false);
+        else assign_key(e, key);
+        entries.push_back(e);
+        after_insert();
         return std::make_pair(&node, index);
     }
 
     template<class V>
     inline bool BasicAData<V>::Object::remove(std::string_view name) {
-        auto it = object_mapper.find(name);
-        if(it == object_mapper.end()) {
+        size_t pos = find_entry(name);
+        if(pos == entries.size()) {
             return false;
         }
-        children.remove(it->second);
-        object_mapper.erase(it);
+        children.remove(entries[pos].index);
+        release_key(entries[pos]);
+        stamp = 0;
+        if(!slots.empty()) erase_slot(pos);
+
+        size_t last = entries.size() - 1;
+        if(pos != last) {
+            // 把最后一个键挪到空位,索引也跟着指过去
+            if(!slots.empty()) slots[slot_of(last)] = (uint32_t)(pos + 1);
+            entries[pos] = entries[last];
+        }
+        entries.pop_back();
         return true;
     }
 
     template<class V>
     inline bool BasicAData<V>::Object::rename(std::string_view old_name, std::string_view new_name) {
-        auto it = object_mapper.find(old_name);
-        if(it == object_mapper.end()) {
+        size_t pos = find_entry(old_name);
+        if(pos == entries.size()) {
             return false;
         }
         if(old_name == new_name) {
             return true;
         }
-        auto index = it->second;
-        object_mapper.erase(it);
-        object_mapper.emplace(
-            std::pmr::string(new_name, object_mapper.get_allocator()),
-            index
-        );
+        // 目标键已存在时保留目标键,丢弃旧节点
+        if(find_entry(new_name) != entries.size()) {
+            return remove(old_name);
+        }
+        stamp = 0;
+        if(!slots.empty()) erase_slot(pos);
+        Entry e = entries[pos];
+        e.hash = hash_key(new_name);
+        assign_key(e, new_name);
+        release_key(entries[pos]);
+        entries[pos] = e;
+        if(!slots.empty()) place_slot(pos);
         return true;
     }
 
@@ -1521,7 +2286,8 @@ namespace alib5 {
     }
 
     template<class V>
-    inline const BasicAData<V>* BasicAData<V>::jump_ptr(std::string_view path, bool err) const {
+    inline const BasicAData<V>* BasicAData<V>::__jump(std::string_view path, bool err, bool touch) const {
+        if(touch) hash_cache = 0;
         if(path.empty()) return this;
         if(path[0] != '/') {
             if(err) invoke_error(err_locate_error, "Failed to parse pointer which isn't begin with '/'!PATH:{}", path);
@@ -1543,9 +2309,12 @@ namespace alib5 {
             val = s;
 
             if(auto ss = val.template expect<int>(); ss.second && current->is_array()) {
-                auto* ptr = current->array().at_ptr(ss.first);
+                // 要写入时沿路径取得可写负载,共享的负载会被复制
+                auto& arr = touch ? const_cast<BasicAData<V>*>(current)->array() : current->array();
+                auto* ptr = arr.at_ptr(ss.first);
                 if(ptr) {
                     current = ptr;
+                    if(touch) current->hash_cache = 0;
                 } else {
                     if(err) {
                         invoke_error(err_locate_error, "Locate failed when finding array index {}!", ss.first);
@@ -1569,9 +2338,11 @@ namespace alib5 {
                     }
                     cast.push_back(s[i]);
                 }
-                auto* ptr = current->object().at_ptr(cast);
+                auto& obj = touch ? const_cast<BasicAData<V>*>(current)->object() : current->object();
+                auto* ptr = obj.at_ptr(cast);
                 if(ptr) {
                     current = ptr;
+                    if(touch) current->hash_cache = 0;
                 } else {
                     if(err) {
                         invoke_error(err_locate_error, "Locate failed when finding object name {}!", cast);
@@ -1601,6 +2372,14 @@ namespace alib5 {
             Frame f = frames.back();
             frames.pop_back();
 
+            // 共享同一份负载的拷贝一定相等
+            if(f.left->shares_payload(*f.right)) continue;
+            // 缓存的哈希相同说明Strict相等,也就满足更宽松的策略
+            if(f.left->hash_cache && f.right->hash_cache) {
+                if(f.left->hash_cache == f.right->hash_cache) continue;
+                if(st == CompareStrategy::Strict) return false;
+            }
+
             auto lt = f.left->get_type();
             auto rt = f.right->get_type();
             if(lt != rt) {
@@ -1627,7 +2406,7 @@ namespace alib5 {
 
                 if(lo.size() != ro.size()) return false;
                 for(auto it : lo) {
-                    auto proxy = ro.find(it.first());
+                    auto proxy = ro.find(it.first(), it.hash());
                     if(proxy == ro.end()) {
                         return false;
                     }
@@ -1664,11 +2443,184 @@ namespace alib5 {
         return values[index];
     }
 
+    template<class V>
+    inline void BasicAData<V>::materialize_all() const {
+        std::vector<const BasicAData<V>*> stack;
+        stack.push_back(this);
+        while(!stack.empty()) {
+            const BasicAData<V>* n = stack.back();
+            stack.pop_back();
+            n->materialize();
+            if(n->is_object()) {
+                for(auto proxy : n->object()) stack.push_back(&proxy.second());
+            } else if(n->is_array()) {
+                for(auto& v : n->array()) stack.push_back(&v);
+            }
+        }
+    }
+
+    template<class V>
+    inline void BasicAData<V>::__settle() const {
+        if(auto* o = std::get_if<Shared<Object>>(&data); o && o->settled()) return;
+        if(auto* a = std::get_if<Shared<Array>>(&data); a && a->settled()) return;
+
+        std::vector<const BasicAData<V>*> stack;
+        std::vector<const BasicAData<V>*> checked;
+        stack.push_back(this);
+        while(!stack.empty()) {
+            const BasicAData<V>* n = stack.back();
+            stack.pop_back();
+            n->materialize();
+            if(auto* o = std::get_if<Shared<Object>>(&n->data)) {
+                if(o->settled()) continue;
+                for(auto proxy : o->get()) stack.push_back(&proxy.second());
+                checked.push_back(n);
+            } else if(auto* a = std::get_if<Shared<Array>>(&n->data)) {
+                if(a->settled()) continue;
+                for(auto& v : a->get()) stack.push_back(&v);
+                checked.push_back(n);
+            }
+        }
+        // 整棵子树都处理完之后再标记,中途失败也不会留下错误的标记
+        for(auto* n : checked) {
+            if(auto* o = std::get_if<Shared<Object>>(&n->data)) o->mark_settled();
+            else if(auto* a = std::get_if<Shared<Array>>(&n->data)) a->mark_settled();
+        }
+    }
+
+    template<class V>
+    inline BasicAData<V> BasicAData<V>::detach() const {
+        BasicAData<V> out(*this);
+        // 逐层取得可写负载,还在共享的负载都会被复制一份
+        std::vector<BasicAData<V>*> stack;
+        stack.push_back(&out);
+        while(!stack.empty()) {
+            BasicAData<V>* n = stack.back();
+            stack.pop_back();
+            n->materialize();
+            // 引用不会交出去,不需要标记泄漏,哈希缓存也依旧有效
+            if(auto* o = std::get_if<Shared<Object>>(&n->data)) {
+                for(auto proxy : o->own()) stack.push_back(&proxy.second());
+            } else if(auto* a = std::get_if<Shared<Array>>(&n->data)) {
+                for(auto& v : a->own()) stack.push_back(&v);
+            }
+        }
+        return out;
+    }
+
+    template<class V>
+    inline void BasicAData<V>::seal() {
+        std::vector<BasicAData<V>*> stack;
+        stack.push_back(this);
+        while(!stack.empty()) {
+            BasicAData<V>* n = stack.back();
+            stack.pop_back();
+            // 没泄漏的负载下面也不会有泄漏的:要写入子节点必须先可写地拿到这一层
+            if(auto* o = std::get_if<Shared<Object>>(&n->data)) {
+                if(!o->leaked()) continue;
+                o->seal();
+                for(auto proxy : o->own()) stack.push_back(&proxy.second());
+            } else if(auto* a = std::get_if<Shared<Array>>(&n->data)) {
+                if(!a->leaked()) continue;
+                a->seal();
+                for(auto& v : a->own()) stack.push_back(&v);
+            }
+        }
+    }
+
+    template<class V>
+    inline uint64_t BasicAData<V>::structural_hash() const {
+        constexpr uint64_t seed_null = 0x6e756c6cULL;
+        constexpr uint64_t seed_object = 0x6f626a656374ULL;
+        constexpr uint64_t seed_array = 0x6172726179ULL;
+
+        struct Frame {
+            const BasicAData<V>* node;
+            bool expanded;
+        };
+        std::vector<Frame> frames;
+        // 算好的哈希,子节点按顺序排在父节点的位置上
+        std::vector<uint64_t> hashes;
+        frames.push_back(Frame{this, false});
+
+        // 后序遍历,子节点的哈希都算好之后再合并到父节点
+        while(!frames.empty()) {
+            Frame f = frames.back();
+            frames.pop_back();
+            const BasicAData<V>* n = f.node;
+            if(!f.expanded) {
+                if(n->hash_cache) {
+                    hashes.push_back(n->hash_cache);
+                    continue;
+                }
+                switch(n->get_type()) {
+                case TNull:
+                    hashes.push_back(detail::hash_mix(seed_null));
+                    continue;
+                case TValue:
+                    // 叶子可能被外面拿着的value()引用改掉,不缓存
+                    hashes.push_back(detail::value_hash(n->value()));
+                    continue;
+                case TArray: {
+                    auto& arr = n->array();
+                    frames.push_back(Frame{n, true});
+                    for(size_t i = arr.size(); i > 0; --i) frames.push_back(Frame{&arr[i - 1], false});
+                    continue;
+                }
+                case TObject: {
+                    frames.push_back(Frame{n, true});
+                    size_t base = frames.size();
+                    for(auto proxy : n->object()) frames.push_back(Frame{&proxy.second(), false});
+                    // 倒过来压栈,第一个子节点最先算完
+                    std::reverse(frames.begin() + base, frames.end());
+                    continue;
+                }
+                }
+            }
+
+            uint64_t h;
+            bool ok = true;
+            if(n->get_type() == TArray) {
+                auto& arr = n->array();
+                const uint64_t* child = hashes.data() + hashes.size() - arr.size();
+                h = detail::hash_combine(seed_array, arr.size());
+                for(size_t i = 0; i < arr.size(); ++i) {
+                    if(!child[i]) { ok = false; break; }
+                    h = detail::hash_combine(h, child[i]);
+                }
+                hashes.resize(hashes.size() - arr.size());
+            } else {
+                auto& obj = n->object();
+                const uint64_t* child = hashes.data() + hashes.size() - obj.size();
+                // 求和与键的顺序无关
+                uint64_t sum = 0;
+                size_t i = 0;
+                for(auto proxy : obj) {
+                    if(!child[i]) { ok = false; break; }
+                    sum += detail::hash_combine((uint64_t)detail::TransparentStringHash{}(proxy.first()), child[i]);
+                    ++i;
+                }
+                h = detail::hash_combine(detail::hash_combine(seed_object, obj.size()), sum);
+                hashes.resize(hashes.size() - obj.size());
+            }
+            // 含NaN的子树为0
+            h = ok ? (h ? h : 1) : 0;
+            // 泄漏的负载下面可能还有能写入的引用,写入时不会经过这个节点,不能缓存
+            if(!n->payload_leaked()) n->hash_cache = h;
+            hashes.push_back(h);
+        }
+        return hashes.back();
+    }
+
     template<class V>
     template<class T> 
     inline T& BasicAData<V>::set() {
+        hash_cache = 0;
         if constexpr(std::is_same_v<T, std::monostate>) {
             return data.template emplace<std::monostate>();
+        } else if constexpr(is_container<T>) {
+            data.template emplace<Shared<T>>(allocator);
+            return std::get_if<Shared<T>>(&data)->unique();
         } else return data.template emplace<T>(allocator);
     }
     
@@ -1699,6 +2651,8 @@ namespace alib5 {
             while(!jobs.empty()) {
                 auto [dest, src] = jobs.back();
                 jobs.pop_back();
+                // 右值的子节点会被移走
+                if constexpr(is_rvalue) src->hash_cache = 0;
 
                 if(dest->is_object() && src->is_object()) {
                     auto& dobj = dest->object();
@@ -1706,9 +2660,9 @@ namespace alib5 {
                     
                     object_nexts.clear();
                     for(auto mit : sobj) {
-                        auto it = dobj.find(mit.first());
+                        auto it = dobj.find(mit.first(), mit.hash());
                         if(it != dobj.end()) {
-                            object_nexts.emplace_back(it.it->second, &mit.second());
+                            object_nexts.emplace_back(it.index(), &mit.second());
                         } else {
                             if constexpr(is_rvalue) {
                                 dobj[mit.first()] = std::move(mit.second());
@@ -1772,7 +2726,7 @@ namespace alib5 {
                     }
 
                     for(auto mit : dobj) {
-                        auto it = sobj.find(mit.first());
+                        auto it = sobj.find(mit.first(), mit.hash());
                         if(it == sobj.end()) {
                             if(!added_or_modified && !src_lack_of) return true;
                             ret = true;
@@ -1781,7 +2735,7 @@ namespace alib5 {
                     }
 
                     for(auto mit : sobj) {
-                        auto it = dobj.find(mit.first());
+                        auto it = dobj.find(mit.first(), mit.hash());
                         if(it != dobj.end()) {
                             jobs.emplace_back(Job{
                                 &mit.second(),
@@ -1835,8 +2789,9 @@ namespace alib5 {
                             if(!d.expanded) frames.emplace_back(Frame{&mit.second(), false});
                         }
                     }
-                    for(auto k : key_rms) {
-                        obj.remove(k);
+                    // 倒序删除: remove会把末尾的键挪到空位,倒序保证还没删除的key_rms不被挪动
+                    for(auto k = key_rms.rbegin(); k != key_rms.rend(); ++k) {
+                        obj.remove(*k);
                     }
                     if(!d.expanded) {
                         if(fn(*d.current)) {
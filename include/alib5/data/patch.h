@@ -0,0 +1,551 @@
+/**
+ * @file patch.h
+ * @brief Structural diff and patch for AData (JSON Patch / Merge Patch) / AData 的结构化差异与补丁
+ *
+ * @details
+ * English: `Patch` computes the difference between two trees as an RFC 6902 JSON Patch (a list of
+ * add / remove / replace operations addressed by JSON pointers) or as an RFC 7396 Merge Patch (a partial
+ * document where null deletes a key), and applies either form to a tree. Applying follows the rules of
+ * `merge`: a `MergeFn` decides whether an existing node is overridden or skipped. Only the parts that
+ * differ end up in a patch, and applying touches only the addressed nodes.
+ *
+ * Chinese: `Patch` 以 RFC 6902 JSON Patch（由 JSON pointer 定位的 add / remove / replace 操作列表）
+ * 或 RFC 7396 Merge Patch（null 表示删除键的局部文档）的形式计算两棵树之间的差异，并能把这两种补丁应用到树上。
+ * 应用时遵循 `merge` 的规则：由 `MergeFn` 决定已有节点是覆盖还是跳过。补丁中只包含不同的部分，应用时也只访问被定位到的节点。
+ */
+
+#ifndef ALIB5_ADATA_PATCH
+#define ALIB5_ADATA_PATCH
+
+#include <alib5/data/kernel.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace alib5::data {
+
+    /**
+     * @brief JSON Patch / Merge Patch generation and application.
+     *
+     * @details
+     * A JSON Patch is an array of objects `{"op": ..., "path": ..., "value": ...}`. `make` only emits
+     * `add`, `remove` and `replace`; `apply` also understands `move`, `copy` and `test`. Array changes are
+     * found by trimming the common head and tail, so a single insertion or removal costs one operation.
+     * Both trees are hashed first (see `structural_hash()`), subtrees that share their payload or whose hashes
+     * match on both sides are skipped without being walked. Hashes stay cached on payloads that are not leaked,
+     * so diffing sealed trees (or copies of them) again only walks what changed in between.
+     * The hashing itself is O(tree) for every payload without a cached hash: a tree that was written through and
+     * never sealed is hashed in full on every call, even if the diff is empty. When the same large tree is
+     * diffed repeatedly, call `seal()` on it after each batch of edits.
+     */
+    struct Patch {
+        /**
+         * @brief Builds the JSON Patch turning `from` into `to`.
+         * @details Both trees are hashed first, which walks every unsealed subtree (see above).
+         * @param patch Receives the operation array, previous contents are dropped.
+         * @param st How values are compared, nodes that compare equal produce no operation.
+         * @return bool True if the trees differ.
+         */
+        template<class V>
+        static bool make(
+            const BasicAData<V>& from,
+            const BasicAData<V>& to,
+            BasicAData<V>& patch,
+            CompareStrategy st = CompareStrategy::Strict
+        );
+
+        /**
+         * @brief Applies a JSON Patch to `target`.
+         *
+         * @details
+         * `add` / `replace` on an existing node asks `fn(existing, value)` first and leaves the node alone on
+         * `MergeOperation::Skip`. Operations are applied in order and the first failing one stops the
+         * process, so `target` may be partially patched on failure (put `test` operations first to guard).
+         *
+         * @return bool False if an operation is malformed, its path does not exist or a `test` failed.
+         */
+        template<class V, IsMergeFn<BasicAData<V>> MergeFn = decltype(BasicAData<V>::__merge__default)>
+        static bool apply(BasicAData<V>& target, const BasicAData<V>& patch, MergeFn&& fn = BasicAData<V>::__merge__default);
+
+        /**
+         * @brief Builds the Merge Patch turning `from` into `to`.
+         *
+         * @details
+         * Merge patches cannot express a null value inside an object (null means "remove"), and arrays are
+         * always replaced as a whole. Subtrees without changes are left out. Hashes both trees first like `make`.
+         *
+         * @return bool True if the trees differ. When false there is nothing to apply: for non-object roots
+         * `patch` is left null, which `apply_merge` would (per RFC 7396) write into the target.
+         */
+        template<class V>
+        static bool make_merge(
+            const BasicAData<V>& from,
+            const BasicAData<V>& to,
+            BasicAData<V>& patch,
+            CompareStrategy st = CompareStrategy::Strict
+        );
+
+        /**
+         * @brief Applies a Merge Patch to `target`, asking `fn` before overriding an existing node.
+         *
+         * @details That includes an existing non-object node an object in the patch would replace, on
+         * `MergeOperation::Skip` it is kept and that part of the patch is dropped.
+         */
+        template<class V, IsMergeFn<BasicAData<V>> MergeFn = decltype(BasicAData<V>::__merge__default)>
+        static void apply_merge(BasicAData<V>& target, const BasicAData<V>& patch, MergeFn&& fn = BasicAData<V>::__merge__default);
+
+        /**
+         * @brief Appends `/token` to a JSON pointer, escaping `~` and `/`.
+         */
+        static void append_token(std::string& path, std::string_view token) {
+            path.push_back('/');
+            for(char c : token) {
+                if(c == '~') path += "~0";
+                else if(c == '/') path += "~1";
+                else path.push_back(c);
+            }
+        }
+
+    private:
+        /**
+         * @brief Splits a JSON pointer into unescaped tokens.
+         */
+        static bool split_pointer(std::string_view pointer, std::vector<std::string>& tokens);
+
+        /**
+         * @brief Parses an array index token, `-` means one past the end.
+         */
+        static bool parse_index(std::string_view token, size_t size, bool allow_end, size_t& out);
+
+        template<class V>
+        static BasicAData<V>* locate(BasicAData<V>& root, const std::vector<std::string>& tokens, size_t count);
+
+        template<class V, class MergeFn>
+        static bool add_at(BasicAData<V>& root, const std::vector<std::string>& tokens, const BasicAData<V>& value, MergeFn& fn);
+
+        template<class V>
+        static bool remove_at(BasicAData<V>& root, const std::vector<std::string>& tokens, BasicAData<V>* removed);
+    };
+
+} // namespace alib5::data
+
+// ----------------------------------------------------------------------------------------------------
+// Inline Implementations
+// ----------------------------------------------------------------------------------------------------
+
+namespace alib5::data {
+
+    inline bool Patch::split_pointer(std::string_view pointer, std::vector<std::string>& tokens) {
+        tokens.clear();
+        if(pointer.empty()) return true;
+        if(pointer[0] != '/') return false;
+        while(!pointer.empty()) {
+            pointer.remove_prefix(1);
+            size_t next = pointer.find('/');
+            std::string_view raw = pointer.substr(0, next);
+            pointer = next == std::string_view::npos ? std::string_view() : pointer.substr(next);
+
+            std::string& token = tokens.emplace_back();
+            for(size_t i = 0; i < raw.size(); ++i) {
+                if(raw[i] != '~') {
+                    token.push_back(raw[i]);
+                    continue;
+                }
+                if(i + 1 >= raw.size() || (raw[i + 1] != '0' && raw[i + 1] != '1')) return false;
+                token.push_back(raw[i + 1] == '0' ? '~' : '/');
+                ++i;
+            }
+        }
+        return true;
+    }
+
+    inline bool Patch::parse_index(std::string_view token, size_t size, bool allow_end, size_t& out) {
+        if(token == "-") {
+            out = size;
+            return allow_end;
+        }
+        // RFC 6901: 不允许前导0和符号
+        if(token.empty() || (token.size() > 1 && token[0] == '0')) return false;
+        auto res = std::from_chars(token.data(), token.data() + token.size(), out);
+        if(res.ec != std::errc() || res.ptr != token.data() + token.size()) return false;
+        return allow_end ? out <= size : out < size;
+    }
+
+    template<class V>
+    inline BasicAData<V>* Patch::locate(BasicAData<V>& root, const std::vector<std::string>& tokens, size_t count) {
+        BasicAData<V>* current = &root;
+        for(size_t i = 0; i < count; ++i) {
+            if(current->is_object()) {
+                current = current->object().at_ptr(tokens[i]);
+            } else if(current->is_array()) {
+                size_t index;
+                auto& arr = current->array();
+                if(!parse_index(tokens[i], arr.size(), false, index)) return nullptr;
+                current = &arr.values[index];
+            } else return nullptr;
+            if(!current) return nullptr;
+        }
+        return current;
+    }
+
+    template<class V, class MergeFn>
+    inline bool Patch::add_at(BasicAData<V>& root, const std::vector<std::string>& tokens, const BasicAData<V>& value, MergeFn& fn) {
+        if(tokens.empty()) {
+            if(fn(root, value) == MergeOperation::Override) root.rewrite(value);
+            return true;
+        }
+        BasicAData<V>* parent = locate(root, tokens, tokens.size() - 1);
+        if(!parent) return false;
+        const std::string& last = tokens.back();
+
+        if(parent->is_object()) {
+            auto& obj = parent->object();
+            if(auto* existing = obj.at_ptr(last)) {
+                if(fn(*existing, value) == MergeOperation::Override) existing->rewrite(value);
+            } else {
+                obj[last].rewrite(value);
+            }
+            return true;
+        } else if(parent->is_array()) {
+            auto& arr = parent->array();
+            size_t index;
+            if(!parse_index(last, arr.size(), true, index)) return false;
+            // 数组的add是插入,不存在覆盖
+            arr.values.insert(arr.values.begin() + index, BasicAData<V>(value, parent->get_allocator()));
+            return true;
+        }
+        return false;
+    }
+
+    template<class V>
+    inline bool Patch::remove_at(BasicAData<V>& root, const std::vector<std::string>& tokens, BasicAData<V>* removed) {
+        if(tokens.empty()) {
+            if(removed) removed->rewrite(std::move(root));
+            root.set_null();
+            return true;
+        }
+        BasicAData<V>* parent = locate(root, tokens, tokens.size() - 1);
+        if(!parent) return false;
+        const std::string& last = tokens.back();
+
+        if(parent->is_object()) {
+            auto& obj = parent->object();
+            auto* node = obj.at_ptr(last);
+            if(!node) return false;
+            if(removed) removed->rewrite(std::move(*node));
+            return obj.remove(last);
+        } else if(parent->is_array()) {
+            auto& arr = parent->array();
+            size_t index;
+            if(!parse_index(last, arr.size(), false, index)) return false;
+            if(removed) removed->rewrite(std::move(arr.values[index]));
+            arr.values.erase(arr.values.begin() + index);
+            return true;
+        }
+        return false;
+    }
+
+    template<class V>
+    inline bool Patch::make(const BasicAData<V>& from, const BasicAData<V>& to, BasicAData<V>& patch, CompareStrategy st) {
+        using data_type = BasicAData<V>;
+        // 路径只在真正产生操作时才拼出来,未变化的节点只记录父节点和自己的token
+        struct Step {
+            const data_type* from;
+            const data_type* to;
+            size_t parent;
+            std::string_view key;
+            size_t index;
+            bool is_index;
+        };
+        constexpr size_t no_parent = (size_t)-1;
+
+        std::vector<Step> steps;
+        std::vector<size_t> pending;
+        std::vector<size_t> chain;
+        std::string path;
+        auto& ops = patch.template set<typename data_type::Array>();
+
+        auto build_path = [&](size_t id) {
+            chain.clear();
+            for(; id != no_parent; id = steps[id].parent) chain.push_back(id);
+            path.clear();
+            // 根节点没有token
+            for(size_t i = chain.size() - 1; i-- > 0;) {
+                const Step& s = steps[chain[i]];
+                if(s.is_index) {
+                    path.push_back('/');
+                    path += ext::to_string<false>(s.index);
+                } else append_token(path, s.key);
+            }
+        };
+        auto emit = [&](std::string_view op, const data_type* value) {
+            auto& o = ops.values.emplace_back(patch.get_allocator());
+            o["op"] = op;
+            o["path"] = std::string_view(path);
+            if(value) o["value"] = *value;
+        };
+        auto child_path = [&](size_t parent, std::string_view key, bool is_index, size_t index) {
+            build_path(parent);
+            if(is_index) {
+                path.push_back('/');
+                path += ext::to_string<false>(index);
+            } else append_token(path, key);
+        };
+
+        // 先把两边的哈希算好:没有泄漏的子树会缓存下来(已经缓存的直接复用),下面遇到哈希相同的子树整棵跳过,
+        // 数组去头尾时的equals也是O(1)的;泄漏的部分不缓存,本来也要逐个比较
+        from.structural_hash();
+        to.structural_hash();
+
+        steps.push_back(Step{&from, &to, no_parent, {}, 0, false});
+        pending.push_back(0);
+
+        while(!pending.empty()) {
+            const size_t id = pending.back();
+            pending.pop_back();
+            const data_type* a = steps[id].from;
+            const data_type* b = steps[id].to;
+            // 哈希已缓存且相同的子树没有变化
+            if(a == b || a->shares_payload(*b) || data_type::same_cached_hash(*a, *b)) continue;
+
+            auto at = a->get_type();
+            auto bt = b->get_type();
+            if(at == data_type::TObject && bt == data_type::TObject) {
+                auto& ao = a->object();
+                auto& bo = b->object();
+                for(auto it : ao) {
+                    if(bo.find(it.first(), it.hash()) == bo.end()) {
+                        child_path(id, it.first(), false, 0);
+                        emit("remove", nullptr);
+                    }
+                }
+                for(auto it : bo) {
+                    auto other = ao.find(it.first(), it.hash());
+                    if(other == ao.end()) {
+                        child_path(id, it.first(), false, 0);
+                        emit("add", &it.second());
+                    } else {
+                        steps.push_back(Step{&other.second(), &it.second(), id, it.first(), 0, false});
+                        pending.push_back(steps.size() - 1);
+                    }
+                }
+            } else if(at == data_type::TArray && bt == data_type::TArray) {
+                auto& aa = a->array();
+                auto& ba = b->array();
+                const size_t n1 = aa.size();
+                const size_t n2 = ba.size();
+                // 去掉相同的头尾,只对中间部分生成操作
+                size_t head = 0;
+                while(head < n1 && head < n2 && data_type::equals(aa.values[head], ba.values[head], st)) ++head;
+                size_t tail = 0;
+                while(tail < n1 - head && tail < n2 - head
+                    && data_type::equals(aa.values[n1 - tail - 1], ba.values[n2 - tail - 1], st)) ++tail;
+
+                const size_t m1 = n1 - head - tail;
+                const size_t m2 = n2 - head - tail;
+                const size_t common = std::min(m1, m2);
+                // 删除从后往前,插入从前往后,都只影响common之后的下标
+                for(size_t i = head + m1; i-- > head + common;) {
+                    child_path(id, {}, true, i);
+                    emit("remove", nullptr);
+                }
+                for(size_t i = head + common; i < head + m2; ++i) {
+                    child_path(id, {}, true, i);
+                    emit("add", &ba.values[i]);
+                }
+                for(size_t i = head; i < head + common; ++i) {
+                    steps.push_back(Step{&aa.values[i], &ba.values[i], id, {}, i, true});
+                    pending.push_back(steps.size() - 1);
+                }
+            } else if(!data_type::equals(*a, *b, st)) {
+                build_path(id);
+                emit("replace", b);
+            }
+        }
+        return !ops.empty();
+    }
+
+    template<class V, IsMergeFn<BasicAData<V>> MergeFn>
+    inline bool Patch::apply(BasicAData<V>& target, const BasicAData<V>& patch, MergeFn&& fn) {
+        using data_type = BasicAData<V>;
+        if(!patch.is_array()) {
+            invoke_error(err_format_error, "JSON Patch must be an array of operations!");
+            return false;
+        }
+
+        std::vector<std::string> tokens;
+        std::vector<std::string> from_tokens;
+        size_t index = 0;
+        for(auto& op_node : patch.array()) {
+            auto fail = [&](std::string_view reason) {
+                invoke_error(err_locate_error, "JSON Patch operation #{} failed: {}", index, reason);
+                return false;
+            };
+            if(!op_node.is_object()) return fail("operation is not an object");
+            auto& op = op_node.object();
+            auto text_of = [&](std::string_view key, std::string_view& out) {
+                auto* node = op.at_ptr(key);
+                if(!node || !node->is_value() || node->value().get_type() != V::STRING) return false;
+                out = node->value().raw_view();
+                return true;
+            };
+            std::string_view name;
+            std::string_view path;
+            if(!text_of("op", name) || !text_of("path", path)) return fail("missing \"op\" or \"path\"");
+            if(!split_pointer(path, tokens)) return fail("malformed path");
+            auto* value = op.at_ptr("value");
+
+            if(name == "add") {
+                if(!value) return fail("missing \"value\"");
+                if(!add_at(target, tokens, *value, fn)) return fail("path not found");
+            } else if(name == "remove") {
+                if(!remove_at<V>(target, tokens, nullptr)) return fail("path not found");
+            } else if(name == "replace") {
+                if(!value) return fail("missing \"value\"");
+                data_type* node = locate(target, tokens, tokens.size());
+                if(!node) return fail("path not found");
+                if(fn(*node, *value) == MergeOperation::Override) node->rewrite(*value);
+            } else if(name == "move" || name == "copy") {
+                std::string_view from_path;
+                if(!text_of("from", from_path) || !split_pointer(from_path, from_tokens)) {
+                    return fail("malformed \"from\"");
+                }
+                data_type moved(target.get_allocator());
+                if(name == "move") {
+                    // 不能把节点移动到它自己的子节点里
+                    if(from_tokens.size() < tokens.size()
+                        && std::equal(from_tokens.begin(), from_tokens.end(), tokens.begin())) {
+                        return fail("cannot move a node into its own child");
+                    }
+                    if(!remove_at(target, from_tokens, &moved)) return fail("\"from\" not found");
+                } else {
+                    data_type* src = locate(target, from_tokens, from_tokens.size());
+                    if(!src) return fail("\"from\" not found");
+                    moved.rewrite(*src);
+                }
+                if(!add_at(target, tokens, moved, fn)) return fail("path not found");
+            } else if(name == "test") {
+                if(!value) return fail("missing \"value\"");
+                data_type* node = locate(target, tokens, tokens.size());
+                if(!node || !data_type::equals(*node, *value)) return fail("test failed");
+            } else {
+                return fail("unknown operation");
+            }
+            ++index;
+        }
+        return true;
+    }
+
+    template<class V>
+    inline bool Patch::make_merge(const BasicAData<V>& from, const BasicAData<V>& to, BasicAData<V>& patch, CompareStrategy st) {
+        using data_type = BasicAData<V>;
+        struct Job {
+            const data_type* from;
+            const data_type* to;
+            data_type* patch;
+        };
+        struct Nested {
+            data_type* parent;
+            std::string_view key;
+        };
+
+        if(!from.is_object() || !to.is_object()) {
+            bool changed = !data_type::equals(from, to, st);
+            if(changed) patch.rewrite(to);
+            else patch.set_null();
+            return changed;
+        }
+
+        std::vector<Job> jobs;
+        std::vector<Nested> nested;
+        patch.set_null();
+        // 与make相同,先算好哈希用来跳过没有变化的子树
+        from.structural_hash();
+        to.structural_hash();
+        jobs.push_back(Job{&from, &to, &patch});
+
+        while(!jobs.empty()) {
+            auto [a, b, p] = jobs.back();
+            jobs.pop_back();
+            auto& ao = a->object();
+            auto& bo = b->object();
+            auto& po = p->template set<typename data_type::Object>();
+            // 之后会持有子节点的指针,预留空间防止扩容
+            po.reserve(ao.size() + bo.size());
+
+            for(auto it : ao) {
+                if(bo.find(it.first(), it.hash()) == bo.end()) po[it.first()].set_null();
+            }
+            for(auto it : bo) {
+                auto other = ao.find(it.first(), it.hash());
+                if(other == ao.end()) {
+                    po[it.first()] = it.second();
+                } else if(&other.second() == &it.second() || other.second().shares_payload(it.second()) || data_type::same_cached_hash(other.second(), it.second())) {
+                    continue;
+                } else if(other.second().is_object() && it.second().is_object()) {
+                    data_type* child = &po[it.first()];
+                    jobs.push_back(Job{&other.second(), &it.second(), child});
+                    nested.push_back(Nested{p, it.first()});
+                } else if(!data_type::equals(other.second(), it.second(), st)) {
+                    po[it.first()] = it.second();
+                }
+            }
+        }
+
+        // 倒序处理,子补丁总是先于父补丁被清理
+        for(auto n = nested.rbegin(); n != nested.rend(); ++n) {
+            auto& po = n->parent->object();
+            auto* child = po.at_ptr(n->key);
+            if(child && child->is_object() && child->object().empty()) po.remove(n->key);
+        }
+        return !patch.object().empty();
+    }
+
+    template<class V, IsMergeFn<BasicAData<V>> MergeFn>
+    inline void Patch::apply_merge(BasicAData<V>& target, const BasicAData<V>& patch, MergeFn&& fn) {
+        using data_type = BasicAData<V>;
+        struct Job {
+            data_type* target;
+            const data_type* patch;
+            bool fresh; ///< 刚为新键创建的节点,没有需要询问的旧值
+        };
+        std::vector<Job> jobs;
+        jobs.push_back(Job{&target, &patch, false});
+
+        while(!jobs.empty()) {
+            auto [t, p, fresh] = jobs.back();
+            jobs.pop_back();
+
+            if(!p->is_object()) {
+                if(fn(*t, *p) == MergeOperation::Override) t->rewrite(*p);
+                continue;
+            }
+            if(!t->is_object()) {
+                // 已有的非对象节点会被整个换成对象,同样先问fn
+                if(!fresh && fn(*t, *p) != MergeOperation::Override) continue;
+                t->template set<typename data_type::Object>();
+            }
+            auto& to = t->object();
+            auto& po = p->object();
+            // 之后会持有子节点的指针,预留空间防止扩容
+            to.reserve(to.size() + po.size());
+
+            for(auto it : po) {
+                const data_type& v = it.second();
+                if(v.is_null()) {
+                    to.remove(it.first());
+                } else if(v.is_object()) {
+                    bool is_new = to.at_ptr(it.first()) == nullptr;
+                    jobs.push_back(Job{&to[it.first()], &v, is_new});
+                } else if(auto* existing = to.at_ptr(it.first())) {
+                    if(fn(*existing, v) == MergeOperation::Override) existing->rewrite(v);
+                } else {
+                    to[it.first()] = v;
+                }
+            }
+        }
+    }
+
+} // namespace alib5::data
+
+#endif
@@ -22,6 +22,8 @@
 #include <alib5/data/reflect/from_adata.h>
 #include <alib5/data/reflect/to_adata.h>
 #include <alib5/data/reflect/gen_schema.h>
+#include <alib5/data/reflect/from_json.h>
+#include <alib5/data/reflect/to_json.h>
 
 namespace alib5 {
 
@@ -64,6 +66,53 @@ namespace alib5 {
     template<class T>
     dadata_t generate_schema();
 
+    /**
+     * @brief Deserializes JSON text straight into an existing C++ data structure.
+     * 
+     * @details Follows the rules of `from_adata` without building an intermediate AData tree.
+     * Errors are reported through `invoke_error` with their line and column.
+     * 
+     * @tparam InT Type of the target data structure.
+     * @param fill_data The data structure to populate.
+     * @param text The JSON text.
+     * @return bool False if the text is malformed or does not fit the structure.
+     */
+    template<class InT>
+    bool from_json(InT & fill_data, std::string_view text);
+
+    /**
+     * @brief Deserializes JSON text and returns a new C++ data structure.
+     * 
+     * @tparam InT Type of the target data structure.
+     * @param text The JSON text.
+     * @return InT The populated data structure, fields that failed to parse keep their defaults.
+     */
+    template<class InT>
+    InT from_json(std::string_view text);
+
+    /**
+     * @brief Serializes a C++ data structure straight to compact JSON text.
+     * 
+     * @details Follows the rules of `to_adata` without building an intermediate AData tree.
+     * 
+     * @tparam InT Type of the source data structure.
+     * @tparam T The target string type (e.g., std::string, std::pmr::string).
+     * @param base The source data structure to serialize.
+     * @param target The string the text is appended to.
+     */
+    template<class InT, class T>
+    void to_json(const InT & base, T & target);
+
+    /**
+     * @brief Serializes a C++ data structure straight to compact JSON text.
+     * 
+     * @tparam InT Type of the source data structure.
+     * @param base The source data structure to serialize.
+     * @return std::string The resulting JSON text.
+     */
+    template<class InT>
+    std::string to_json(const InT & base);
+
 }
 
 // ============================================================================
@@ -94,6 +143,33 @@ namespace alib5 {
         return detail::_generate_schema<T>();
     }
 
+    template<class InT>
+    inline bool from_json(InT & fill_data, std::string_view text) {
+        detail::JSONStreamReader reader(text);
+        if(detail::_from_json(fill_data, reader) && reader.finish()) return true;
+        reader.report();
+        return false;
+    }
+
+    template<class InT>
+    inline InT from_json(std::string_view text) {
+        InT object;
+        from_json(object, text);
+        return object;
+    }
+
+    template<class InT, class T>
+    inline void to_json(const InT & base, T & target) {
+        detail::_to_json(base, target);
+    }
+
+    template<class InT>
+    inline std::string to_json(const InT & base) {
+        std::string out;
+        detail::_to_json(base, out);
+        return out;
+    }
+
 }
 
 #endif
\ No newline at end of file
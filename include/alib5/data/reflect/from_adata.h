@@ -141,51 +141,57 @@ namespace alib5::detail {
                 "Node is not an object!"
             );
 
-            template for(
-                constexpr auto item :
-                std::define_static_array(
-                    std::meta::nonstatic_data_members_of(^^InT, context)
-                )
-            ) {
-                constexpr auto element_type_info = std::meta::type_of(item);
-
-                if constexpr(!std::meta::is_reference_type(element_type_info)) {
-                    constexpr auto original_name = std::meta::identifier_of(item);
-                    std::string_view name = original_name;
-
-                    constexpr static auto child_annotations = std::define_static_array(
-                        std::meta::annotations_of(item)
-                    );
-                    constexpr static auto array_annotations = detail::ranges_to_array<std::meta::info, child_annotations.size()>(
-                        child_annotations
-                    );
-
-                    if constexpr(
-                        !has_annotation_with_trait<attr::AttributeTraits::DeseriSkip, array_annotations.size(), array_annotations>() &&
-                        !has_annotation_with_trait<attr::AttributeTraits::GeneralSkip, array_annotations.size(), array_annotations>()
-                    ) {
-                        // Check annotation. (Original: 检测annotation)
-                        constexpr static auto rename_attr = annotation_do_if_trait<attr::AttributeTraits::Rename, array_annotations.size(), array_annotations>();
-                        if constexpr(!not_found_annotation(rename_attr)) name = rename_attr.new_name();
-
-                        if constexpr(cfg.debug) {
-                            if(debug_logger) [[likely]] {
-                                *debug_logger << "Type         : " << std::meta::display_string_of(^^InT) << fls
-                                              << "OriginalName : " << original_name << fls
-                                              << "MappingName  : " << name << "\n" << fls
-                                              << "ExistInData  : " << root.object().contains(name) << "\n" << fls;
+            using Handler = void(*)(InT &, const Data &, LoggerType *);
+            constexpr static auto items = std::define_static_array(
+                std::meta::nonstatic_data_members_of(^^InT, context)
+            );
+            // 编译期生成的完美哈希,键->成员下标,包括rename后的名字
+            constexpr static auto & table = member_name_table<InT, attr::AttributeTraits::DeseriSkip>;
+            constexpr static auto handlers = [] {
+                std::array<Handler, items.size()> fns {};
+                size_t i = 0;
+                template for(constexpr auto item : items) {
+                    if constexpr(!std::meta::is_reference_type(std::meta::type_of(item))) {
+                        fns[i] = [](InT & fill, const Data & node, LoggerType * logger) {
+                            constexpr static auto child_annotations = std::define_static_array(
+                                std::meta::annotations_of(item)
+                            );
+                            constexpr static auto array_annotations = detail::ranges_to_array<std::meta::info, child_annotations.size()>(
+                                child_annotations
+                            );
+
+                            if constexpr(cfg.debug) {
+                                if(logger) [[likely]] {
+                                    *logger << "OriginalName : " << std::meta::identifier_of(item) << "\n" << fls;
+                                }
                             }
-                        }
 
-                        if(root.object().contains(name)) {
                             _from_adata<
                                 cfg,
                                 array_annotations.size(),
                                 array_annotations
-                            >(fill_data.[: item :], root[name], debug_logger);
-                        }
+                            >(fill.[: item :], node, logger);
+                        };
+                    }
+                    ++i;
+                }
+                return fns;
+            }();
+
+            // 遍历数据中的键而不是结构体的成员,每个键一次哈希一次比较
+            auto & obj = root.object();
+            for(auto it = obj.begin(); it != obj.end(); ++it) {
+                size_t index = table.find(it.first());
+
+                if constexpr(cfg.debug) {
+                    if(debug_logger) [[likely]] {
+                        *debug_logger << "Type         : " << std::meta::display_string_of(^^InT) << fls
+                                      << "MappingName  : " << it.first() << fls
+                                      << "ExistInType  : " << (index != table.npos) << "\n" << fls;
                     }
                 }
+
+                if(index != table.npos) handlers[index](fill_data, it.second(), debug_logger);
             }
 
         } else {
@@ -0,0 +1,161 @@
+/**
+ * @file from_json.h
+ * @author aaaa0ggmc (lovelinux@yslwd.eu.org)
+ * @brief Direct deserialization from JSON text.
+ *
+ * \par Original Comment
+ * English: Same rules as from_adata, but the JSON text is read straight into the fields, no AData tree is built.
+ * Chinese: 规则与from_adata相同,但是JSON文本直接读进字段里,不构建AData树
+ *
+ * @version 5.0
+ * @date 2026-06-10
+ * @copyright Copyright (c) 2026
+ */
+#ifndef ALIB5_ADATA_REFLECT_FROM_JSON
+#define ALIB5_ADATA_REFLECT_FROM_JSON
+#include <alib5/data/reflect/kernel.h>
+#include <alib5/data/reflect/json_stream.h>
+#include <alib5/data/kernel.h>
+
+namespace alib5::detail {
+
+    /**
+     * @brief Reads the next JSON value of `reader` into a C++ object.
+     *
+     * \par Original Comment
+     * English: Keys that map to no member (unknown, skipped or deseri::skip) are skipped, members missing in the text keep their value.
+     * Chinese: 对应不到成员的键(未知的、skip或者deseri::skip的)会被跳过,文本中缺失的成员保持原值
+     *
+     * @tparam N Number of annotations.
+     * @tparam annotations Compile-time array of meta annotations.
+     * @tparam InT Type of the data object to be filled.
+     * @param fill_data The data object to be populated.
+     * @param reader The source, positioned before the value.
+     * @return bool False on malformed text or a value of the wrong kind, the reason is kept in `reader`.
+     */
+    template<
+        size_t N = 0,
+        std::array<std::meta::info, N> annotations = {},
+        class InT
+    >
+    bool _from_json(InT & fill_data, JSONStreamReader & reader);
+
+}
+
+namespace alib5::detail {
+
+    template<
+        size_t N,
+        std::array<std::meta::info, N> annotations,
+        class InT
+    >
+    inline bool _from_json(InT & fill_data, JSONStreamReader & reader) {
+        constexpr std::meta::access_context context = std::meta::access_context::unchecked();
+        using T = std::decay_t<InT>;
+
+        if constexpr(std::is_enum_v<T>) {
+            auto & mapper = get_enum_mapper<T>();
+            std::string_view name;
+
+            if(reader.peek() == 'n') return reader.read_literal("null");
+            if(!reader.read_string(name)) return false;
+            if(auto it = mapper.find(name); it != mapper.end()) {
+                fill_data = it->second;
+            } else {
+                // 与from_adata一样,未知的枚举名啥都不做
+            }
+            return true;
+        } else if constexpr(std::is_arithmetic_v<T>) {
+            return reader.read_arith(fill_data);
+        } else if constexpr(IsNodeValue<T>) {
+            return reader.read_text(fill_data);
+        } else if constexpr(
+            requires {
+                typename T::value_type;
+                typename T::value_type();
+            }
+            &&
+            requires(typename T::value_type & val) {
+                fill_data.clear();
+                fill_data.push_back(val);
+                { fill_data.back() } -> std::convertible_to<typename T::value_type &>;
+            }
+        ) {
+            using ValueType = typename T::value_type;
+            constexpr static auto result = annotation_do_if_trait<
+                attr::AttributeTraits::InnerAttributes,
+                N,
+                annotations
+            >();
+
+            if(reader.peek() == 'n') return reader.read_literal("null");
+            if(!reader.consume('[')) return reader.fail("expected an array");
+
+            fill_data.clear();
+            bool first = true;
+            while(reader.next(']', first)) {
+                fill_data.push_back(ValueType());
+
+                bool ok;
+                if constexpr(not_found_annotation(result)) {
+                    ok = _from_json(fill_data.back(), reader);
+                } else {
+                    constexpr static auto array_annotations = result.to_annotation_array();
+                    ok = _from_json<array_annotations.size(), array_annotations>(fill_data.back(), reader);
+                }
+                if(!ok) return false;
+            }
+            return !reader.failed();
+        } else if constexpr(std::meta::is_class_type(^^T)) {
+            using Handler = bool(*)(T &, JSONStreamReader &);
+            constexpr static auto items = std::define_static_array(
+                std::meta::nonstatic_data_members_of(^^T, context)
+            );
+            constexpr static auto & table = member_name_table<T, attr::AttributeTraits::DeseriSkip>;
+            constexpr static auto handlers = [] {
+                std::array<Handler, items.size()> fns {};
+                size_t i = 0;
+                template for(constexpr auto item : items) {
+                    if constexpr(!std::meta::is_reference_type(std::meta::type_of(item))) {
+                        fns[i] = [](T & fill, JSONStreamReader & r) {
+                            constexpr static auto child_annotations = std::define_static_array(
+                                std::meta::annotations_of(item)
+                            );
+                            constexpr static auto array_annotations = detail::ranges_to_array<std::meta::info, child_annotations.size()>(
+                                child_annotations
+                            );
+                            return _from_json<array_annotations.size(), array_annotations>(fill.[: item :], r);
+                        };
+                    }
+                    ++i;
+                }
+                return fns;
+            }();
+
+            if(reader.peek() == 'n') return reader.read_literal("null");
+            if(!reader.consume('{')) return reader.fail("expected an object");
+
+            bool first = true;
+            std::string_view key;
+            while(reader.next('}', first, &key)) {
+                // key可能位于scratch中,读取值之前先查好下标
+                size_t index = table.find(key);
+                if(index == table.npos) {
+                    if(!reader.skip_value()) return false;
+                } else if(!handlers[index](fill_data, reader)) {
+                    return false;
+                }
+            }
+            return !reader.failed();
+        } else {
+#ifdef ALIB5_ENABLE_STRICT_REFLECTION
+            static_assert(std::meta::is_class_type(^^T), "Unsupported Structure!");
+#else
+            return reader.skip_value();
+#endif
+        }
+    }
+
+}
+
+#endif
@@ -0,0 +1,240 @@
+/**
+ * @file json_stream.h
+ * @author aaaa0ggmc (lovelinux@yslwd.eu.org)
+ * @brief Token level JSON reading and writing for the direct reflection paths.
+ *
+ * \par Original Comment
+ * English: `from_json` / `to_json` walk the JSON text themselves instead of going through an `AData` tree,
+ * this is the part of them that does not depend on reflection.
+ * Chinese: `from_json` / `to_json` 直接处理JSON文本而不经过`AData`树,这里是其中与反射无关的部分
+ *
+ * @version 5.0
+ * @date 2026-06-10
+ * @copyright Copyright (c) 2026
+ */
+#ifndef ALIB5_ADATA_REFLECT_JSON_STREAM
+#define ALIB5_ADATA_REFLECT_JSON_STREAM
+#include <alib5/autil.h>
+#include <alib5/data/data_text.h>
+#include <charconv>
+#include <cmath>
+#include <limits>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace alib5::detail {
+
+    /**
+     * @brief Pull style JSON reader, the caller decides what it expects next.
+     *
+     * @details
+     * Strings without escapes are returned as views into the source, others are decoded into
+     * `scratch`, which stays valid until the next string is read. The first error wins, its message
+     * and offset are kept for `report`.
+     */
+    struct ALIB5_API JSONStreamReader {
+        std::string_view src;
+        size_t pos {0};
+        std::string_view error {};
+        size_t error_pos {0};
+        std::pmr::string scratch;
+
+        explicit JSONStreamReader(std::string_view s, std::pmr::memory_resource* __a = ALIB5_DEFAULT_MEMORY_RESOURCE)
+        : src(s), scratch(__a) {}
+
+        bool fail(std::string_view msg) {
+            if(error.empty()) {
+                error = msg;
+                error_pos = pos;
+            }
+            return false;
+        }
+
+        inline bool failed() const { return !error.empty(); }
+
+        inline void skip_ws() {
+            while(pos < src.size() && (src[pos] == ' ' || src[pos] == '\n' || src[pos] == '\r' || src[pos] == '\t')) ++pos;
+        }
+
+        /// @brief Next significant character, '\0' at the end of the input.
+        inline char peek() {
+            skip_ws();
+            return pos < src.size() ? src[pos] : '\0';
+        }
+
+        inline bool consume(char c) {
+            if(peek() != c) return false;
+            ++pos;
+            return true;
+        }
+
+        /**
+         * @brief Steps to the next element of the array or object opened by `consume('[' / '{')`.
+         *
+         * @details
+         * Returns false on the closing bracket (which is consumed) and on errors, check `failed()`
+         * after the loop. For objects the key and its ':' are read as well.
+         *
+         * @param close ']' or '}'.
+         * @param first Set to true before the loop.
+         * @param key Receives the member key when `close` is '}'.
+         */
+        bool next(char close, bool & first, std::string_view * key = nullptr);
+
+        /// @brief Reads a string token, see the struct notes about the lifetime of `out`.
+        bool read_string(std::string_view & out);
+
+        /**
+         * @brief Reads a number token without converting it.
+         * @param is_float Set if the token has a fraction or an exponent.
+         */
+        bool read_number(std::string_view & out, bool & is_float);
+
+        /// @brief Reads `true`, `false` or `null` if `lit` matches the input.
+        bool read_literal(std::string_view lit);
+
+        /// @brief Skips one value of any kind, nested containers included.
+        bool skip_value();
+
+        /// @brief Only whitespace may follow the document.
+        bool finish();
+
+        /// @brief Reports the stored error through `invoke_error`, with its line and column.
+        void report() const;
+
+        /**
+         * @brief Reads a bool or a number into an arithmetic field.
+         *
+         * @details
+         * Mirrors the conversions `AData::to<T>` does for scalars: numbers may be read into bools
+         * (non zero is true), bools into numbers, floats are truncated for integer fields and quoted
+         * numbers are accepted. `null` leaves the field untouched.
+         */
+        template<class T>
+        requires std::is_arithmetic_v<T>
+        bool read_arith(T & out);
+
+        /**
+         * @brief Reads a scalar into a string field, numbers and bools keep their text form.
+         */
+        template<class T>
+        bool read_text(T & out);
+    };
+
+    /**
+     * @brief Appends a scalar in its JSON form, floats go through `json_write_float`.
+     */
+    template<class Out, class T>
+    requires std::is_arithmetic_v<T>
+    void json_write_number(Out & out, T v);
+
+}
+
+// ============================================================================
+// Implementation
+// ============================================================================
+
+namespace alib5::detail {
+
+    template<class T>
+    requires std::is_arithmetic_v<T>
+    inline bool JSONStreamReader::read_arith(T & out) {
+        std::string_view tok;
+        bool is_float = false;
+        char c = peek();
+
+        if(c == 't' || c == 'f') {
+            bool v = (c == 't');
+            if(!read_literal(v ? "true" : "false")) return false;
+            out = static_cast<T>(v);
+            return true;
+        } else if(c == 'n') {
+            return read_literal("null");
+        } else if(c == '"') {
+            if(!read_string(tok)) return false;
+            // 字符串里的数字,格式放宽一些
+            is_float = tok.find_first_of(".eE") != std::string_view::npos;
+        } else if(!read_number(tok, is_float)) {
+            return false;
+        }
+
+        const char * b = tok.data();
+        const char * e = tok.data() + tok.size();
+        if constexpr(std::is_same_v<T, bool>) {
+            double v = 0;
+            if(std::from_chars(b, e, v).ptr != e || tok.empty()) return fail("expected a number");
+            out = (v != 0);
+        } else if constexpr(std::is_integral_v<T>) {
+            if(is_float) {
+                double v = 0;
+                auto res = std::from_chars(b, e, v);
+                if(res.ec == std::errc::result_out_of_range) return fail("number out of range");
+                if(res.ptr != e) return fail("expected a number");
+                // 超出T范围的浮点转整数是UB,先截断再比较;上界是2^digits,用double可以精确表示
+                constexpr double lower = (double)std::numeric_limits<T>::min();
+                constexpr double upper = 2.0 * (double)(std::numeric_limits<T>::max() / 2 + 1);
+                double t = std::trunc(v);
+                if(!std::isfinite(v) || t < lower || t >= upper) return fail("number out of range");
+                out = static_cast<T>(t);
+            } else {
+                T v {};
+                auto res = std::from_chars(b, e, v);
+                if(res.ec == std::errc::result_out_of_range) return fail("number out of range");
+                if(res.ptr != e || tok.empty()) return fail("expected a number");
+                out = v;
+            }
+        } else {
+            T v {};
+            auto res = std::from_chars(b, e, v);
+            if(res.ptr != e || tok.empty()) return fail("expected a number");
+            out = v;
+        }
+        return true;
+    }
+
+    template<class T>
+    inline bool JSONStreamReader::read_text(T & out) {
+        std::string_view tok;
+        bool is_float = false;
+        char c = peek();
+
+        if(c == '"') {
+            if(!read_string(tok)) return false;
+        } else if(c == 't' || c == 'f') {
+            bool v = (c == 't');
+            if(!read_literal(v ? "true" : "false")) return false;
+            tok = v ? "1" : "0";
+        } else if(c == 'n') {
+            return read_literal("null");
+        } else if(!read_number(tok, is_float)) {
+            return false;
+        }
+
+        if constexpr(requires { out.assign(tok.data(), tok.size()); }) {
+            out.assign(tok.data(), tok.size());
+        } else {
+            out = T(tok);
+        }
+        return true;
+    }
+
+    template<class Out, class T>
+    requires std::is_arithmetic_v<T>
+    inline void json_write_number(Out & out, T v) {
+        if constexpr(std::is_same_v<T, bool>) {
+            if(v) out.append("true", 4);
+            else out.append("false", 5);
+        } else if constexpr(std::is_floating_point_v<T>) {
+            json_write_float(out, v);
+        } else {
+            char buf[32];
+            auto res = std::to_chars(buf, buf + sizeof(buf), v);
+            out.append(buf, res.ptr - buf);
+        }
+    }
+
+}
+
+#endif
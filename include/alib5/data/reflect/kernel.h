@@ -14,9 +14,12 @@
 #ifndef ALIB5_ADATA_REFLECT_KERNEL
 #define ALIB5_ADATA_REFLECT_KERNEL
 #include <alib5/data/reflect/attributes.h>
+#include <alib5/data/kernel.h>
 #include <alib5/autil.h>
 #include <meta>
 #include <utility>
+#include <array>
+#include <bit>
 
 namespace alib5 {
     namespace detail {
@@ -275,6 +278,160 @@ namespace alib5 {
             return data;
         }
 
+        /**
+         * @brief FNV-1a over the bytes of a member name, usable at compile time and at runtime.
+         */
+        constexpr uint64_t member_name_hash(std::string_view name) {
+            uint64_t h = 0xcbf29ce484222325ULL;
+            for(char c : name) {
+                h ^= (uint8_t)c;
+                h *= 0x100000001b3ULL;
+            }
+            return h;
+        }
+
+        /**
+         * @brief Compile-time perfect hash from member names to member indices.
+         * 
+         * \par Original Comment
+         * English: Hash and displace: names are grouped into buckets, each bucket gets a displacement that sends all of its names
+         * to free slots. A lookup is one hash, one mix and one compare, no matter how many members there are.
+         * Chinese: 先把名字分到桶里,再为每个桶找一个位移,让桶里的名字都落到空槽位上。查找只需要一次哈希、一次混合和一次比较,与成员数量无关
+         * 
+         * @tparam N Number of members, empty names are left out of the table.
+         */
+        template<std::size_t N>
+        struct MemberNameTable {
+            static constexpr std::size_t npos = N;
+            static constexpr std::size_t bucket_count = std::bit_ceil((N + 1) / 2);
+            static constexpr std::size_t slot_count = std::bit_ceil(N + N / 2 + 1);
+            static constexpr uint16_t empty_slot = UINT16_MAX;
+            static_assert(N < UINT16_MAX, "Too many members!");
+
+            std::array<std::string_view, N> names {};
+            std::array<uint32_t, bucket_count> displacements {};
+            std::array<uint16_t, slot_count> slots {};
+
+            static constexpr std::size_t bucket_of(uint64_t h) {
+                return (std::size_t)(h ^ (h >> 32)) & (bucket_count - 1);
+            }
+
+            static constexpr std::size_t slot_of(uint64_t h, uint32_t d) {
+                return (std::size_t)hash_mix(h + d * 0x9e3779b97f4a7c15ULL) & (slot_count - 1);
+            }
+
+            consteval MemberNameTable(const std::array<std::string_view, N> & ns) : names(ns) {
+                std::array<uint64_t, N> hashes {};
+                for(std::size_t i = 0; i < N; ++i) {
+                    if(names[i].empty()) continue;
+                    hashes[i] = member_name_hash(names[i]);
+                    for(std::size_t j = 0; j < i; ++j) {
+                        if(names[j].empty()) continue;
+                        if(names[i] == names[j]) throw "Two members are mapped to the same name!";
+                        if(hashes[i] == hashes[j]) throw "Member name hash collision!";
+                    }
+                }
+                slots.fill(empty_slot);
+
+                // 大桶先放,它们最难找到位移
+                std::array<std::size_t, bucket_count> sizes {};
+                for(std::size_t i = 0; i < N; ++i) if(!names[i].empty()) ++sizes[bucket_of(hashes[i])];
+                std::array<bool, bucket_count> placed {};
+                for(std::size_t round = 0; round < bucket_count; ++round) {
+                    std::size_t b = 0;
+                    while(placed[b]) ++b;
+                    for(std::size_t k = b + 1; k < bucket_count; ++k) {
+                        if(!placed[k] && sizes[k] > sizes[b]) b = k;
+                    }
+                    placed[b] = true;
+                    if(!sizes[b]) continue;
+
+                    for(uint32_t d = 0;; ++d) {
+                        if(d == (1u << 20)) throw "Failed to build the member name table!";
+                        std::array<std::size_t, N> taken {};
+                        std::size_t count = 0;
+                        bool ok = true;
+                        for(std::size_t i = 0; i < N && ok; ++i) {
+                            if(names[i].empty() || bucket_of(hashes[i]) != b) continue;
+                            std::size_t s = slot_of(hashes[i], d);
+                            if(slots[s] != empty_slot) ok = false;
+                            for(std::size_t k = 0; k < count && ok; ++k) if(taken[k] == s) ok = false;
+                            taken[count++] = s;
+                        }
+                        if(!ok) continue;
+
+                        displacements[b] = d;
+                        count = 0;
+                        for(std::size_t i = 0; i < N; ++i) {
+                            if(names[i].empty() || bucket_of(hashes[i]) != b) continue;
+                            slots[taken[count++]] = (uint16_t)i;
+                        }
+                        break;
+                    }
+                }
+            }
+
+            /**
+             * @brief Index of the member called `key`, `npos` if there is none.
+             */
+            constexpr std::size_t find(std::string_view key) const {
+                if constexpr(N == 0) {
+                    return npos;
+                } else {
+                    uint64_t h = member_name_hash(key);
+                    uint16_t i = slots[slot_of(h, displacements[bucket_of(h)])];
+                    return (i != empty_slot && names[i] == key) ? i : npos;
+                }
+            }
+        };
+
+        /**
+         * @brief Names of the non-static data members of T as seen by (de)serialization.
+         * 
+         * \par Original Comment
+         * English: attr::rename is applied. Reference members and members skipped by `skip_trait` or attr::skip get an empty name.
+         * Chinese: 已经应用attr::rename。引用成员以及被`skip_trait`或者attr::skip跳过的成员名字为空
+         * 
+         * @tparam T The reflected class.
+         * @tparam skip_trait `DeseriSkip` or `SeriSkip`.
+         */
+        template<class T, attr::AttributeTraits skip_trait>
+        consteval auto reflected_member_names() {
+            constexpr std::meta::access_context context = std::meta::access_context::unchecked();
+            constexpr static auto items = std::define_static_array(
+                std::meta::nonstatic_data_members_of(^^T, context)
+            );
+            std::array<std::string_view, items.size()> names {};
+            std::size_t i = 0;
+
+            template for(constexpr auto item : items) {
+                constexpr static auto child_annotations = std::define_static_array(
+                    std::meta::annotations_of(item)
+                );
+                constexpr static auto array_annotations = ranges_to_array<std::meta::info, child_annotations.size()>(
+                    child_annotations
+                );
+
+                if constexpr(
+                    !std::meta::is_reference_type(std::meta::type_of(item)) &&
+                    !has_annotation_with_trait<skip_trait, array_annotations.size(), array_annotations>() &&
+                    !has_annotation_with_trait<attr::AttributeTraits::GeneralSkip, array_annotations.size(), array_annotations>()
+                ) {
+                    constexpr static auto rename_attr = annotation_do_if_trait<attr::AttributeTraits::Rename, array_annotations.size(), array_annotations>();
+                    if constexpr(!not_found_annotation(rename_attr)) names[i] = rename_attr.new_name();
+                    else names[i] = std::meta::identifier_of(item);
+                }
+                ++i;
+            }
+            return names;
+        }
+
+        /**
+         * @brief The perfect hash of the member names of T, built once per type.
+         */
+        template<class T, attr::AttributeTraits skip_trait>
+        constexpr auto member_name_table = MemberNameTable(reflected_member_names<T, skip_trait>());
+
         /**
          * @brief Checks if a specific type exists in the annotation list.
          * 
@@ -0,0 +1,154 @@
+/**
+ * @file to_json.h
+ * @author aaaa0ggmc (lovelinux@yslwd.eu.org)
+ * @brief Direct serialization to JSON text.
+ *
+ * \par Original Comment
+ * English: Same rules as to_adata, but the fields are written straight into the output, no AData tree is built.
+ * Chinese: 规则与to_adata相同,但是字段直接写入输出,不构建AData树
+ *
+ * @version 5.0
+ * @date 2026-06-10
+ * @copyright Copyright (c) 2026
+ */
+#ifndef ALIB5_ADATA_REFLECT_TO_JSON
+#define ALIB5_ADATA_REFLECT_TO_JSON
+#include <alib5/data/reflect/kernel.h>
+#include <alib5/data/reflect/json_stream.h>
+#include <alib5/data/kernel.h>
+
+namespace alib5::detail {
+
+    /**
+     * @brief Appends the compact JSON form of a C++ object to `out`.
+     *
+     * @tparam N Number of annotations.
+     * @tparam annotations Compile-time array of meta annotations.
+     * @tparam InT Type of the input value.
+     * @tparam Out String-like output with `append(const char*, size_t)` and `push_back`.
+     * @param base The value to write.
+     * @param out The output buffer.
+     */
+    template<
+        size_t N = 0,
+        std::array<std::meta::info, N> annotations = {},
+        class InT,
+        class Out
+    >
+    void _to_json(const InT & base, Out & out);
+
+}
+
+namespace alib5::detail {
+
+    template<
+        size_t N,
+        std::array<std::meta::info, N> annotations,
+        class InT,
+        class Out
+    >
+    inline void _to_json(const InT & base, Out & out) {
+        using T = std::decay_t<InT>;
+        constexpr std::meta::access_context context = std::meta::access_context::unchecked();
+
+        if constexpr(std::is_enum_v<T>) {
+            auto & mapper = get_enum_string_mapper<T>();
+
+            if(auto it = mapper.find(base); it != mapper.end()) {
+                json_write_string(out, it->second);
+            } else {
+                // to_adata在这里留下一个null
+                out.append("null", 4);
+            }
+        } else if constexpr(std::is_arithmetic_v<T>) {
+            json_write_number(out, base);
+        } else if constexpr(IsStringLike<const T &>) {
+            json_write_string(out, std::string_view(base));
+        } else if constexpr(
+            requires {
+                { base.size() } -> std::convertible_to<size_t>;
+                base[0];
+            }
+        ) {
+            constexpr static auto result = annotation_do_if_trait<
+                attr::AttributeTraits::InnerAttributes,
+                N,
+                annotations
+            >();
+            size_t size = base.size();
+
+            out.push_back('[');
+            for(size_t i = 0; i < size; ++i) {
+                if(i) out.push_back(',');
+                if constexpr(not_found_annotation(result)) {
+                    _to_json(base[i], out);
+                } else {
+                    constexpr static auto array_annotations = result.to_annotation_array();
+                    _to_json<array_annotations.size(), array_annotations>(base[i], out);
+                }
+            }
+            out.push_back(']');
+        } else if constexpr(std::meta::is_class_type(^^T)) {
+            bool first = true;
+
+            out.push_back('{');
+            template for(
+                constexpr auto item :
+                std::define_static_array(
+                    std::meta::nonstatic_data_members_of(^^T, context)
+                )
+            ) {
+                constexpr static auto child_annotations = std::define_static_array(
+                    std::meta::annotations_of(item)
+                );
+                constexpr static auto array_annotations = detail::ranges_to_array<std::meta::info, child_annotations.size()>(
+                    child_annotations
+                );
+
+                if constexpr(
+                    !std::meta::is_reference_type(std::meta::type_of(item)) &&
+                    !has_annotation_with_trait<attr::AttributeTraits::SeriSkip, array_annotations.size(), array_annotations>() &&
+                    !has_annotation_with_trait<attr::AttributeTraits::GeneralSkip, array_annotations.size(), array_annotations>()
+                ) {
+                    constexpr static auto rename_attr = annotation_do_if_trait<attr::AttributeTraits::Rename, array_annotations.size(), array_annotations>();
+                    constexpr std::string_view name = [] {
+                        if constexpr(!not_found_annotation(rename_attr)) return rename_attr.new_name();
+                        else return std::meta::identifier_of(item);
+                    }();
+                    constexpr bool need_omit = has_annotation_with_trait<attr::AttributeTraits::OmitEmpty, array_annotations.size(), array_annotations>();
+
+                    const auto & field = base.[: item :];
+                    using FieldType = std::decay_t<decltype(field)>;
+                    bool cond = true;
+
+                    // omit_empty与to_adata一致: 空字符串以及空数组
+                    if constexpr(need_omit) {
+                        if constexpr(IsStringLike<const FieldType &>) {
+                            cond = !std::string_view(field).empty();
+                        } else if constexpr(!std::is_arithmetic_v<FieldType> && requires { { field.size() } -> std::convertible_to<size_t>; field[0]; }) {
+                            cond = field.size() != 0;
+                        }
+                    }
+
+                    if(cond) {
+                        if(!first) out.push_back(',');
+                        first = false;
+                        json_write_string(out, name);
+                        out.push_back(':');
+                        _to_json<array_annotations.size(), array_annotations>(field, out);
+                    }
+                }
+            }
+            out.push_back('}');
+        } else {
+#ifdef ALIB5_ENABLE_STRICT_REFLECTION
+            static_assert(std::meta::is_class_type(^^T), "Unsupported Structure!");
+#else
+            out.append("null", 4);
+#endif
+        }
+    }
+
+}
+
+#endif
@@ -19,6 +19,7 @@
 #include <format>
 #include <optional>
 #include <functional>
+#include <span>
 
 namespace alib5 {
 
@@ -31,6 +32,15 @@ namespace alib5 {
      */
     constexpr std::string_view magic_key_for_schema_restr = "[ALIB5_OBJ]";
 
+    /**
+     * @brief Number of array elements handed to each task by `Validator::Program::validate_parallel`.
+     *
+     * @details
+     * English: Arrays with fewer than twice as many elements are validated by the task that reached them.
+     * Chinese: 元素少于两倍该值的数组由访问到它的任务直接校验
+     */
+    static constexpr size_t conf_parallel_validate_chunk = 4096;
+
     /**
      * @brief AData structure validator.
      * 
@@ -252,8 +262,43 @@ namespace alib5 {
          * Chinese: 记录错误,operations...
          */
         struct ALIB5_API Result {
+            /**
+             * @brief What a compact error is about.
+             */
+            enum ErrorCode : uint8_t {
+                TypeMismatch,
+                NotInEnum,
+                SizeOutOfRange,
+                ValueOutOfRange,
+                ValidationFailed,
+                RequiredMissing
+            };
+
+            /**
+             * @brief An error recorded by a `Program` without formatting anything.
+             *
+             * @details
+             * English: The path is stored as steps in `compact_paths`: a step >= 0 is an array index, a step < 0
+             * is the member `-step - 1` of `Program::members`. `Program::format_error` renders the same text
+             * as the string mode on demand.
+             * Chinese: 路径以步骤的形式存放在`compact_paths`中:>= 0 的步骤是数组下标,< 0 的步骤是`Program::members`中的
+             * 第`-step - 1`个成员。需要时由`Program::format_error`生成与字符串模式相同的文本
+             */
+            struct CompactError {
+                ErrorCode code;
+                uint32_t op;         ///< Rule of the failing node, index into `Program::ops`
+                uint32_t detail;     ///< Actual `TypeRestrict` / failed call / missing member, depending on `code`
+                uint32_t path_begin;
+                uint32_t path_size;
+                double actual;       ///< Actual size or value of the *OutOfRange codes
+            };
+
             bool enable_string_errors;
             bool enable_missing;
+            /// Record `compact_errors`, only compiled programs can.
+            bool enable_compact_errors;
+            /// Stop at the first failure, the document is left partly validated.
+            bool stop_at_first;
             bool success;
             std::pmr::vector<std::pmr::string> recorded_errors;
             
@@ -263,17 +308,43 @@ namespace alib5 {
                 detail::TransparentStringEqual    
             > missings;
 
+            std::pmr::vector<CompactError> compact_errors;
+            std::pmr::vector<int64_t> compact_paths;
+
             Result(std::pmr::memory_resource* __a = ALIB5_DEFAULT_MEMORY_RESOURCE)
-            : recorded_errors(__a), missings(__a) {
+            : recorded_errors(__a), missings(__a), compact_errors(__a), compact_paths(__a) {
                 reset();
                 enable_string_errors = true;
                 enable_missing = true;
+                enable_compact_errors = false;
+                stop_at_first = false;
+            }
+
+            /**
+             * @brief A result for rejecting bad input cheaply: compact errors only, stops at the first one.
+             *
+             * @details Reuse it (with `reset`) across documents, the vectors keep their capacity, so after
+             * the first rejection recording an error does not allocate either.
+             */
+            static Result fast_fail(std::pmr::memory_resource* __a = ALIB5_DEFAULT_MEMORY_RESOURCE) {
+                Result r(__a);
+                r.enable_string_errors = false;
+                r.enable_missing = false;
+                r.enable_compact_errors = true;
+                r.stop_at_first = true;
+                return r;
             }
 
             void reset() {
                 success = true;
                 recorded_errors.clear();
                 missings.clear();
+                compact_errors.clear();
+                compact_paths.clear();
+            }
+
+            inline std::span<const int64_t> path_of(const CompactError& e) const {
+                return std::span<const int64_t>(compact_paths.data() + e.path_begin, e.path_size);
             }
 
             /**
@@ -304,6 +375,149 @@ namespace alib5 {
 
         using ValidateMethod = std::function<bool(dadata_t& node, std::pmr::vector<std::pmr::string>& args)>;
 
+        /**
+         * @brief A schema flattened by `Validator::compile` for repeated validation.
+         *
+         * @details
+         * English: Every `Node` becomes one `Op` in a flat array, children refer to each other by index.
+         * Object keys are copied together with their `Object::hash_key`, MIN / MAX are parsed into numbers,
+         * enums are sorted for binary search and validate methods are bound once. `validate` then walks the
+         * document with a stack no deeper than the schema, kept in an inline buffer, so a document that
+         * already conforms is checked without any allocation (only defaults, errors and user methods allocate).
+         * The program is a snapshot: later changes to the `Validator` are not seen, recompile after them.
+         * Chinese: 每个`Node`变成扁平数组里的一个`Op`,子节点通过下标引用。对象的键连同`Object::hash_key`一起拷贝,
+         * MIN / MAX预先解析成数字,枚举排序后二分查找,校验方法只绑定一次。`validate`遍历文档时栈深度不超过schema,
+         * 放在内联缓冲里,因此已经符合schema的文档校验过程中没有任何分配(只有默认值、错误和用户方法会分配)。
+         * 程序是一份快照,之后对`Validator`的修改不会生效,需要重新编译
+         */
+        struct ALIB5_API Program {
+            /// Bytes of stack reserved for the traversal, deeper schemas fall back to the heap.
+            constexpr static size_t inline_stack_bytes = 4096;
+            /// Marks a member that is not descended into.
+            constexpr static uint32_t skip_slot = UINT32_MAX;
+
+            struct Op {
+                Node::TypeRestrict type;
+                bool required;
+                bool override_if_conflict;
+                bool is_tuple;
+                bool has_min;
+                bool has_max;
+                int64_t min_size;   ///< Bound of string length / array length / member count
+                int64_t max_size;
+                double min_value;   ///< Bound of numeric values
+                double max_value;
+                int32_t default_index; ///< Into `defaults`, -1 if none
+                uint32_t enum_begin, enum_count;
+                uint32_t call_begin, call_count;
+                uint32_t member_begin, member_count;
+                uint32_t sub_begin, sub_count; ///< Element rules, one for a list, one per position for a tuple
+            };
+
+            struct Member {
+                std::pmr::string key;
+                uint32_t hash;
+                uint32_t op;
+            };
+
+            struct Call {
+                std::pmr::string name;
+                ValidateMethod fn; ///< Empty if the method was not registered at compile time
+                std::pmr::vector<std::pmr::string> args;
+            };
+
+            std::pmr::vector<Op> ops; ///< `ops[0]` is the root
+            std::pmr::vector<Member> members;
+            std::pmr::vector<uint32_t> subs;
+            std::pmr::vector<std::pmr::string> enums;
+            /// Methods take their arguments by non-const reference
+            mutable std::pmr::vector<Call> calls;
+            std::pmr::vector<dadata_t> defaults;
+            size_t max_depth { 0 }; ///< Deepest chain of ops
+            size_t max_slots { 0 }; ///< Most member slots alive along one chain
+            std::pmr::memory_resource* allocator;
+
+            Program(std::pmr::memory_resource* __a = ALIB5_DEFAULT_MEMORY_RESOURCE)
+            : ops(__a), members(__a), subs(__a), enums(__a), calls(__a), defaults(__a), allocator(__a) {}
+
+            inline bool empty() const { return ops.empty(); }
+
+            /**
+             * @brief Same checks, defaults and error messages as `Validator::validate`.
+             * @details Also records `Result::compact_errors` if enabled.
+             */
+            bool ALIB5_API validate(dadata_t& doc, Result& result, bool ignore_missing = false) const;
+
+            inline Result validate(dadata_t& doc, bool ignore_missing = false) const {
+                Result r;
+                validate(doc, r, ignore_missing);
+                return r;
+            }
+
+            /**
+             * @brief Validates large documents on several threads.
+             *
+             * @details
+             * English: Arrays with at least `2 * conf_parallel_validate_chunk` elements are cut into chunks,
+             * and container members reached through objects only (the sections of a document) become tasks
+             * of their own. Threads are started on the first split, so documents without large parts stay on
+             * the calling thread. Errors are merged in document order, the result is identical to `validate`.
+             * Validate methods run concurrently and must not modify their arguments, and filling defaults
+             * allocates from the document's memory resource on several threads, which therefore has to be
+             * thread-safe. Materialize lazy documents first.
+             * Chinese: 元素不少于`2 * conf_parallel_validate_chunk`的数组会被切块,只经过对象到达的容器成员(文档的各个部分)
+             * 也各自成为任务。线程在第一次拆分时才启动,没有大块内容的文档仍然在调用线程上完成。错误按文档顺序合并,
+             * 结果与`validate`完全一致。校验方法会被并发调用且不能修改参数,填充默认值时会在多个线程上使用文档的内存资源,
+             * 因此它必须是线程安全的。lazy文档请先materialize
+             * @note With `Result::stop_at_first` every task stops at its own first failure and only the first
+             * error in document order is kept.
+             * @param threads 0 means `std::thread::hardware_concurrency()`, 1 is the same as `validate`.
+             */
+            bool ALIB5_API validate_parallel(dadata_t& doc, Result& result, size_t threads = 0, bool ignore_missing = false) const;
+
+            /**
+             * @brief Subtrees that passed `validate_incremental`, keyed by rule and `structural_hash`.
+             */
+            struct Incremental {
+                std::pmr::unordered_set<uint64_t> validated;
+                const Program* program { nullptr };
+                /// Everything is forgotten (and validated again) once the memo grows past this.
+                size_t max_entries { 1 << 20 };
+
+                Incremental(std::pmr::memory_resource* __a = ALIB5_DEFAULT_MEMORY_RESOURCE) : validated(__a) {}
+
+                void reset() {
+                    validated.clear();
+                    program = nullptr;
+                }
+            };
+
+            /**
+             * @brief Validates only what changed since the last successful call with the same `state`.
+             *
+             * @details
+             * English: After a successful run the structural hashes of the document are computed and every
+             * array / object that was checked is remembered as (rule, hash). Hashes are only cached on payloads that
+             * are not leaked (see `dadata_t::seal()`): the validator's own writes are sealed again after the run, but
+             * containers the caller wrote through are checked again on every run until the caller seals them. On the
+             * next run a container that still carries a cached hash whose (rule, hash) is known is skipped as a whole.
+             * Matching by content also covers subtrees copied from elsewhere. Use const references for reads between
+             * runs, otherwise everything read is checked again. A failed run remembers nothing.
+             * Chinese: 成功之后计算文档的结构哈希,并把检查过的每个数组/对象以(规则,哈希)记下。哈希只缓存在没有泄漏的负载上
+             * (见`dadata_t::seal()`):校验自己的写入在结束后会重新封住,调用者写入过的容器在调用者seal()之前每次都会重新检查。
+             * 下一次遇到仍带有缓存且(规则,哈希)已知的容器时整棵子树跳过。按内容匹配因此从别处拷贝来的子树也适用。
+             * 两次校验之间读取请用const引用,否则读过的部分会被重新检查。失败的校验不会记录任何东西
+             */
+            bool ALIB5_API validate_incremental(dadata_t& doc, Incremental& state, Result& result, bool ignore_missing = false) const;
+
+            /**
+             * @brief Renders a compact error of `result` as the message the string mode would have recorded.
+             *
+             * @details `result` must come from this program. Enum errors miss the actual value, it is not kept.
+             */
+            std::pmr::string ALIB5_API format_error(const Result& result, const Result::CompactError& error) const;
+        };
+
         Node root;
         str::StringPool<std::pmr::string> activated_validates_str_pool;
         std::pmr::unordered_map<std::string_view, ValidateMethod> validates;
@@ -362,7 +576,15 @@ namespace alib5 {
             Result r;
             validate(doc, r, ignore_missing);
             return r;
-        } 
+        }
+
+        /**
+         * @brief Flattens the loaded schema into a `Program`.
+         *
+         * @details Validate methods are resolved now, register them with `emplace_validate_method` first.
+         * @param __a Memory resource of the program, the validator's allocator if null.
+         */
+        Program ALIB5_API compile(std::pmr::memory_resource* __a = nullptr) const;
     };
 
     namespace debug {
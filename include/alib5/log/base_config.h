@@ -22,6 +22,14 @@ namespace alib5{
      */
     constexpr uint32_t log_custom_tag_count = 8;
 
+    /**
+     * @brief Bytes reserved inside every LogMsg for the arguments of a deferred message.
+     * @details Messages whose arguments do not fit are formatted on the producer as usual.
+     * @par Original Comment:
+     * 每条LogMsg里给延迟格式化参数预留的字节数，放不下的消息照常在producer上格式化
+     */
+    constexpr uint32_t log_deferred_arg_capacity = 128;
+
     /**
      * @brief User-defined tag attached to a log message at a specific character position.
      * @par Original Comment:
@@ -126,6 +134,18 @@ namespace alib5{
         unsigned int back_pressure_multiply;
         /// @brief Maximum cached messages; exceeding this triggers a harsh drop-half policy. / 最大能缓存的消息数量,超过时再加入新的消息将会执行一个残酷的策略(drop half)
         unsigned int maximum_message_count;
+        /**
+         * @brief Slots of the lock-free message queue, rounded up to a power of two and preallocated. Defaults to 0, which means
+         *        the smallest power of two above maximum_message_count, so the drop-half policy above still applies first.
+         * @details When the queue is full the producer digests a batch itself if back-pressure is enabled, otherwise it yields to the
+         *          consumers logger_queue_full_retry times and only then drops one fetch_message_count_max batch of the oldest messages.
+         *          Slots are preallocated, lower this (or maximum_message_count) to save memory.
+         * @par Original Comment:
+         * 无锁消息队列的槽位数，向上取整到2的幂并且预先分配，默认为0，表示比maximum_message_count大的最小的2的幂，这样仍然先执行上面的drop half策略。
+         * 队列满时开启了背压就由producer自己消化一批，否则先让出logger_queue_full_retry次时间片等consumer，还是满的才丢掉最旧的一批(fetch_message_count_max条)。
+         * 槽位是预分配的，想省内存可以调小它或者maximum_message_count
+         */
+        unsigned int queue_capacity;
 
         /**
          * @brief Constructs the default configuration.
@@ -158,6 +178,15 @@ namespace alib5{
         std::string_view header;
         /// @brief Default message configuration. / 默认的消息配置信息
         LogMsgConfig msg;
+        /**
+         * @brief Whether log_fast defers formatting to the consumer thread. Defaults to false.
+         * @details Only arithmetic, enum, other trivially copyable non-range types and strings are captured; strings are copied.
+         * Pre-filters see the format string instead of the body. Types that point to memory owned by the caller must not be logged this way.
+         * @par Original Comment:
+         * log_fast是否把格式化推迟到consumer线程，默认为false。只捕获算术、枚举、其他可平凡复制且不是range的类型以及字符串(会复制一份)，
+         * 此时pre_filter看到的是格式字符串而不是body。指向调用者内存的类型不要这样打日志
+         */
+        bool defer_format;
 
         /**
          * @brief Constructs the config with default values.
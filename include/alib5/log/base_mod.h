@@ -13,6 +13,7 @@
 #define ALOG_MOD_INCLUDED
 #include <alib5/log/base_msg.h>
 #include <type_traits>
+#include <span>
 
 namespace alib5{
     /**
@@ -23,6 +24,8 @@ namespace alib5{
     struct ALIB5_API LogTarget{
         /// @brief Toggle used to enable/disable output; usually left untouched. / 用于toggle输出，一般不用管
         bool enabled;
+        /// @brief When true the Logger hands whole batches to write_batch instead of calling write per message. / 为true时Logger把整批消息交给write_batch，而不是逐条调用write
+        bool batch_write;
 
         /**
          * @brief Toggles the enabled state and returns self for chaining.
@@ -41,6 +44,7 @@ namespace alib5{
          */
         inline LogTarget(){
             enabled = true;
+            batch_write = false;
         }
 
         /**
@@ -53,6 +57,20 @@ namespace alib5{
             LogMsg & msg
         ){}
 
+        /**
+         * @brief Writes a batch of messages, used instead of write when batch_write is set.
+         * @note  Every message passed the filters and build_on_consumer has been called; the composed
+         *        string cache is shared per thread, so compose each message on your own (compose_prefix).
+         * @par Original Comment:
+         * 写入一批消息，batch_write为true时代替write。里面的消息都通过了过滤并且已经build_on_consumer，
+         * 组合数据的缓存是每个线程共享的，所以请自己组合每条消息(compose_prefix)
+         */
+        virtual inline void write_batch(
+            std::span<LogMsg> msgs
+        ){
+            for(auto & msg : msgs)write(msg);
+        }
+
         /**
          * @brief Flushes buffered data.
          * @par Original Comment:
@@ -44,6 +44,18 @@ namespace alib5{
         /// @brief User-defined tags. / 用户自定义的tag
         std::pmr::vector<LogCustomTag> tags;
 
+        //// 延迟格式化 ////
+        /// @brief Formats the captured arguments into body; doubles as the id of the argument layout. / 把捕获的参数格式化进body，同时也是参数布局的标识
+        using DeferredFormatFn = void(*)(LogMsg & msg);
+        /// @brief Set while the body is still unformatted. / body尚未格式化时不为空
+        DeferredFormatFn deferred_fn { nullptr };
+        /// @brief Static format string of a deferred message. / 延迟消息的静态格式字符串
+        std::string_view deferred_fmt {};
+        /// @brief Used bytes of deferred_args. / deferred_args用掉的字节数
+        uint32_t deferred_size { 0 };
+        /// @brief Packed raw argument bytes. / 紧凑存放的参数原始字节
+        std::byte deferred_args[log_deferred_arg_capacity];
+
         //// 缓冲 ////
         static std::string& sdate();
         static std::string& scomposed();
@@ -85,6 +97,36 @@ namespace alib5{
          */
         std::string_view gen_composed();
 
+        /**
+         * @brief Appends the composed prefix ("[date][level][header][time][TID]:") to `out`, nothing when extra information is disabled.
+         * @note  Uses the same thread_local date as gen_composed, call after build_on_consumer.
+         * @par Original Comment:
+         * 把组合数据的前缀追加到out，禁用额外信息时什么都不加。与gen_composed使用同一个thread_local日期，需要在build_on_consumer之后调用
+         */
+        void compose_prefix(std::string & out) const;
+
+        /**
+         * @brief What follows the body in the composed string.
+         * @par Original Comment:
+         * 组合数据中跟在body后面的部分
+         */
+        inline std::string_view composed_tail() const {
+            return cfg.disable_extra_information ? std::string_view("\n") : cfg.separator;
+        }
+
+        /**
+         * @brief Formats a deferred body now; does nothing for normal messages.
+         * @par Original Comment:
+         * 把延迟的body现在格式化出来，普通消息什么都不做
+         */
+        inline void materialize(){
+            if(!deferred_fn)return;
+            DeferredFormatFn fn = deferred_fn;
+            deferred_fn = nullptr;
+            body.clear();
+            fn(*this);
+        }
+
         /**
          * @brief Move-constructs the log message; mainly moves pmr objects which should keep a consistent allocator.
          * @par Original Comment:
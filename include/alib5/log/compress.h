@@ -0,0 +1,103 @@
+/**
+ * @file compress.h
+ * @brief Small LZ codec for log segments, no external dependency. / 给日志文件用的简单LZ压缩，不依赖外部库
+ * @author aaaa0ggmc (lovelinux@yslwd.eu.org)
+ * @version 0.1
+ * @date 2026/07/08
+ *
+ * @copyright Copyright(c)2025 aaaa0ggmc
+ *
+ * @start-date 2026/07/08
+ */
+#ifndef ALOG_COMPRESS_INCLUDED
+#define ALOG_COMPRESS_INCLUDED
+#include <alib5/autil.h>
+#include <stdio.h>
+#include <string>
+#include <string_view>
+
+namespace alib5{
+    namespace lot{
+        /// @brief 压缩块的大小，也是匹配窗口的上限(偏移量用2字节存)
+        constexpr size_t lz_block_size = 64 * 1024;
+        /// @brief .lz文件的magic
+        constexpr char lz_file_magic[4] = {'A','L','Z','1'};
+        /// @brief 块头里packed_size的这一位表示块没有压缩，原样存储
+        constexpr uint32_t lz_stored_flag = 0x8000'0000u;
+
+        /**
+         * @brief Worst case output size of lz_compress for `n` input bytes.
+         * @par Original Comment:
+         * n字节输入时lz_compress最坏情况下的输出大小
+         */
+        inline size_t lz_compress_bound(size_t n){
+            return n + n / 255 + 16;
+        }
+
+        /**
+         * @brief Compresses one block (at most lz_block_size bytes) into `dst`.
+         * @details
+         * LZ4 style sequences: a token with literal and match length nibbles, extra length bytes, the literals,
+         * a 2-byte offset and extra match length bytes. The last sequence only has literals. Greedy matching
+         * over a hash of the next 4 bytes, fast enough to keep up with a log writer.
+         * @param dst Must hold lz_compress_bound(n) bytes.
+         * @return Bytes written to `dst`.
+         * @par Original Comment:
+         * 压缩一个块(最多lz_block_size字节)。格式类似LZ4：token的高低4位是字面量和匹配长度，然后是额外长度字节、字面量、2字节偏移和额外匹配长度字节，最后一段只有字面量。
+         * 用接下来4个字节的哈希做贪心匹配，速度足够跟上日志写入
+         */
+        ALIB5_API size_t lz_compress(const char * src,size_t n,char * dst);
+
+        /**
+         * @brief Decompresses one block produced by lz_compress, every read and write is bounds checked.
+         * @return false if the block is corrupt or does not decode to exactly `raw_size` bytes.
+         * @par Original Comment:
+         * 解压lz_compress生成的一个块，读写都做了边界检查。块损坏或者解出来的大小不是raw_size时返回false
+         */
+        ALIB5_API bool lz_decompress(const char * src,size_t n,char * dst,size_t raw_size);
+
+        /**
+         * @brief Writes a .lz file block by block: magic, then per block raw_size, packed_size and the data.
+         * @note  Data is only written in whole blocks, finish() writes the last partial one. After a crash at most
+         *        one block of the active file is lost.
+         * @par Original Comment:
+         * 分块写.lz文件：magic，然后每块是raw_size、packed_size和数据。只有攒满一块才写出去，finish()写出最后不满的一块，
+         * 崩溃时正在写的文件最多丢失一个块
+         */
+        struct ALIB5_API LZStreamWriter{
+            FILE * file {nullptr};
+            /// @brief 尚未压缩的数据
+            std::string raw;
+            /// @brief 压缩缓冲
+            std::string packed;
+            /// @brief 写入文件的字节数
+            uint64_t bytes_out {0};
+
+            /// @brief 开始写一个新文件，写入magic
+            void open(FILE * f);
+            /// @brief 追加数据，攒满一块就压缩写出
+            void write(std::string_view data);
+            /// @brief 写出剩下不满一块的数据，不关闭文件
+            void finish();
+        private:
+            void emit_block();
+        };
+
+        /**
+         * @brief Compresses the file at `src` into a .lz file at `dst`.
+         * @par Original Comment:
+         * 把src文件压缩成dst处的.lz文件
+         */
+        ALIB5_API bool lz_compress_file(std::string_view src,std::string_view dst);
+
+        /**
+         * @brief Reads a .lz file back into `out`.
+         * @details A truncated last block (the active file of a crashed process) is ignored, corrupt blocks are errors.
+         * @par Original Comment:
+         * 把.lz文件解压到out。最后一个被截断的块(崩溃进程正在写的文件)会被忽略，损坏的块报错
+         */
+        ALIB5_API bool lz_decompress_file(std::string_view src,std::string & out);
+    }
+}
+
+#endif
@@ -0,0 +1,116 @@
+/**
+ * @file deferred.h
+ * @brief Capturing log arguments on the producer and formatting them on the consumer. / 在producer上捕获日志参数，在consumer上格式化
+ * @author aaaa0ggmc (lovelinux@yslwd.eu.org)
+ * @version 0.1
+ * @date 2026/07/04
+ *
+ * @copyright Copyright(c)2025 aaaa0ggmc
+ *
+ * @start-date 2026/07/04
+ */
+#ifndef ALOG_DEFERRED_INCLUDED
+#define ALOG_DEFERRED_INCLUDED
+#include <alib5/log/base_msg.h>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <format>
+#include <ranges>
+#include <tuple>
+#include <type_traits>
+
+namespace alib5::detail{
+    /// @brief Arguments captured as text, the characters are copied. / 按文本捕获的参数，字符会被复制
+    template<class T> concept DeferString = std::is_convertible_v<const T &,std::string_view>;
+
+    /// @brief Arguments captured by their bytes. / 按字节捕获的参数
+    template<class T> concept DeferTrivial = !DeferString<T> && (
+        std::is_scalar_v<T> ||
+        (std::is_trivially_copyable_v<T> && !std::ranges::range<T>)
+    );
+
+    /// @brief Whether a log_fast call with these arguments can be deferred. / 这些参数的log_fast能否延迟格式化
+    template<class... Args> concept CanDeferFormat = ((DeferString<std::remove_cvref_t<Args>> || DeferTrivial<std::remove_cvref_t<Args>>) && ...);
+
+    /// @brief What an argument is stored and formatted as. / 参数存储以及格式化时的类型
+    template<class T> using DeferStored = std::conditional_t<
+        DeferString<std::remove_cvref_t<T>>,
+        std::string_view,
+        std::remove_cvref_t<T>
+    >;
+
+    /**
+     * @brief Appends one argument to `buf`, strings as their length followed by the characters.
+     * @return false if it does not fit.
+     * @par Original Comment:
+     * 往buf追加一个参数，字符串存为长度加字符，放不下返回false
+     */
+    template<class T> inline bool defer_put(std::byte * buf,uint32_t & off,const T & v){
+        using S = DeferStored<T>;
+        if constexpr(std::is_same_v<S,std::string_view>){
+            std::string_view sv(v);
+            if(off + sizeof(size_t) + sv.size() > log_deferred_arg_capacity)return false;
+            size_t n = sv.size();
+            memcpy(buf + off,&n,sizeof(n));
+            off += sizeof(n);
+            memcpy(buf + off,sv.data(),n);
+            off += n;
+        }else{
+            if(off + sizeof(S) > log_deferred_arg_capacity)return false;
+            // 紧凑排列不对齐，读的时候也是memcpy
+            memcpy(buf + off,&v,sizeof(S));
+            off += sizeof(S);
+        }
+        return true;
+    }
+
+    /// @brief Reads back what defer_put wrote, strings point into `buf`. / 读出defer_put写入的内容，字符串指向buf内部
+    template<class S> inline S defer_get(const std::byte * buf,uint32_t & off){
+        if constexpr(std::is_same_v<S,std::string_view>){
+            size_t n;
+            memcpy(&n,buf + off,sizeof(n));
+            off += sizeof(n);
+            std::string_view sv(reinterpret_cast<const char*>(buf + off),n);
+            off += n;
+            return sv;
+        }else{
+            std::array<std::byte,sizeof(S)> raw;
+            memcpy(raw.data(),buf + off,sizeof(S));
+            off += sizeof(S);
+            return std::bit_cast<S>(raw);
+        }
+    }
+
+    /**
+     * @brief Consumer side: decodes the arguments and formats them into the body.
+     * @note  One instantiation per argument layout, its address is the format id stored in LogMsg.
+     * @par Original Comment:
+     * consumer端：解出参数并格式化进body，每种参数布局一个实例，它的地址就是LogMsg里存的格式id
+     */
+    template<class... S> void deferred_format(LogMsg & msg){
+        uint32_t off = 0;
+        // 花括号初始化保证从左到右求值
+        std::tuple<S...> values { defer_get<S>(msg.deferred_args,off)... };
+        std::apply([&msg](auto&... v){
+            std::vformat_to(std::back_inserter(msg.body),msg.deferred_fmt,std::make_format_args(v...));
+        },values);
+    }
+
+    /**
+     * @brief Producer side: captures the format string and the raw arguments into `msg`.
+     * @return false if the arguments do not fit, `msg` should then be formatted eagerly.
+     * @par Original Comment:
+     * producer端：把格式字符串和参数原始字节存进msg，放不下返回false，这时候应该直接格式化
+     */
+    template<class... Args> inline bool defer_capture(LogMsg & msg,std::string_view fmt,const Args&... args){
+        uint32_t off = 0;
+        if(!(defer_put(msg.deferred_args,off,args) && ...))return false;
+        msg.deferred_size = off;
+        msg.deferred_fmt = fmt;
+        msg.deferred_fn = &deferred_format<DeferStored<Args>...>;
+        return true;
+    }
+}
+
+#endif
@@ -33,12 +33,16 @@
 #include <alib5/log/base_config.h>
 #include <alib5/log/base_msg.h>
 #include <alib5/log/base_mod.h>
+#include <alib5/log/msg_queue.h>
+#include <alib5/log/deferred.h>
 
 #include <format>
+#include <cstring>
 #include <unordered_map>
 #include <deque>
 #include <thread>
 #include <mutex>
+#include <atomic>
 #include <memory_resource>
 #include <memory>
 #include <span>
@@ -65,6 +69,8 @@
 namespace alib5{
     /// @brief Consumer构建的时候预留多少msg槽位（运行时可对齐到fetch_max_size的）
     constexpr unsigned int consumer_message_default_count = 128;
+    /// @brief 队列满时producer让出时间片等待consumer的次数，之后才丢掉一批最旧的消息
+    constexpr unsigned int logger_queue_full_retry = 64;
     /// @brief 日期字符串预留的空间，一般格式化没问题的
     constexpr unsigned int date_str_resize = 32;
     /// @brief 每个组合字符串预留的空间，1024可满足小内容日志，运行时也可以根据raw数据大小扩展
@@ -107,10 +113,6 @@ namespace alib5{
         /// @brief 过滤对象查找池
         std::unordered_map<std::string,RefWrapper<filters_t>> search_filters;
 
-        /// @brief 锁，目前还是相信std::mutex的力量
-        std::mutex msg_lock;
-        /// @brief 换成CV似乎更好？
-        std::condition_variable cv;
         /// @brief 线程池，用来管理consumer
         std::vector<std::jthread> consumers; 
 
@@ -122,20 +124,16 @@ namespace alib5{
             detail::TransparentStringHash,
             detail::TransparentStringEqual
         > header_pool;
-        /// @brief 专门给消息池的内存池 
-        std::pmr::polymorphic_allocator<LogMsg> msg_alloc;
-        /// @brief 消息池的resource
-        std::pmr::synchronized_pool_resource msg_buf;
         
-        /// @brief 消息池
-        std::pmr::deque<LogMsg> messages;
-        /// @brief 消息池大小，减小size()调用啥的
-        std::atomic<int> message_size;
+        /// @brief 有新消息或者要析构时递增，consumer在上面atomic wait
+        std::atomic<uint32_t> msg_signal {0};
+        /// @brief 正在等待的consumer数量，没人等待时producer不用notify
+        std::atomic<uint32_t> sleeping_consumers {0};
         
         /// @brief 背压阈值
         uint64_t back_pressure_threshold;
         /// @brief 线程能继续运行的flag
-        bool logger_not_on_destroying;
+        std::atomic<bool> logger_not_on_destroying;
         /// @brief 缓存的开始时间
         timespec start_time;
 
@@ -143,6 +141,10 @@ namespace alib5{
         void setup_consumer_threads();
         /// @brief Consumer的运行函数
         void consumer_func();
+        /// @brief 唤醒等待中的consumer，all为true时全部唤醒
+        void wake_consumers(bool all = false);
+        /// @brief 准备一批与队列槽位allocator一致的消息，move出来时不复制字符串
+        void prepare_batch(std::vector<LogMsg> & target);
 
         /// @brief  获取消息链条，不需要clear target
         /// @return 填充了多少项，用于遍历target
@@ -166,6 +168,10 @@ namespace alib5{
 
         /// @brief 内部处理，会直接调用std::move高效交换数据
         bool push_message_pmr(int level,std::string_view head,std::pmr::string & body,const LogMsgConfig & cfg,std::pmr::vector<LogCustomTag> * tags = NULL);
+        /// @brief 推送已经捕获好参数的延迟消息，pre_filter看到的是格式字符串
+        bool push_message_deferred(int level,std::string_view head,LogMsg & msg);
+        /// @brief 把构造好的消息交给队列(异步)或者直接写入(同步)
+        bool submit_message(LogMsg & msg);
     public:
         /// @brief 字符串数据池
         std::pmr::polymorphic_allocator<char> msg_str_alloc;
@@ -175,6 +181,9 @@ namespace alib5{
         std::pmr::polymorphic_allocator<LogCustomTag> tag_alloc;
         /// @brief Tag池resource
         std::pmr::synchronized_pool_resource tag_buf;
+        /// @brief 消息队列，无锁，槽位在构造时按LoggerConfig::queue_capacity分配好
+        /// @note  槽位里的字符串来自上面两个池子，所以必须声明在它们后面，先于它们析构
+        LogMsgQueue msg_queue;
         
         /// @brief 初始化内存池，配置......
         Logger(const LoggerConfig & cfg = LoggerConfig());
@@ -302,9 +311,19 @@ namespace alib5{
             return logger.push_message_pmr(level,cfg.header,str,cfg.msg);
         }
         /// @brief 支持多参数的转发，静态版本
+        /// @note  cfg.defer_format开启时参数会被原样捕获，格式化放到consumer线程上做
         template<class... Args> inline bool log_fast(int level,const std::format_string<Args...>& fmt,Args&&... args){
             if(cfg.level_should_keep && !cfg.level_should_keep(level))return false;
             
+            if constexpr(detail::CanDeferFormat<Args...>){
+                if(cfg.defer_format){
+                    LogMsg msg(logger.msg_str_alloc,logger.tag_alloc,cfg.msg);
+                    if(detail::defer_capture(msg,fmt.get(),args...)){
+                        return logger.push_message_deferred(level,cfg.header,msg);
+                    }
+                    // 参数太大放不下，照常格式化
+                }
+            }
             std::pmr::string str (logger.msg_str_alloc);
             std::vformat_to(std::back_inserter(str),fmt.get(),std::make_format_args(args...));
             return logger.push_message_pmr(level,cfg.header,str,cfg.msg);
@@ -428,32 +447,41 @@ namespace alib5{
         }
     }
 
+    inline void LogMsg::compose_prefix(std::string & out) const {
+        if(cfg.disable_extra_information)return;
+        char buf[64];
+        if(cfg.gen_date){
+            out.push_back('[');
+            out += sdate();
+            out.push_back(']');
+        }
+        if(cfg.out_level && cfg.level_cast){
+            out.push_back('[');
+            out += cfg.level_cast(level);
+            out.push_back(']');
+        }
+        if(cfg.out_header && header.data() != nullptr && header.size()){
+            out.push_back('[');
+            out += header;
+            out.push_back(']');
+        }
+        if(cfg.gen_time)out.append(buf,snprintf(buf,sizeof(buf),"[%.2lfms]",timestamp));
+        if(cfg.gen_thread_id)out.append(buf,snprintf(buf,sizeof(buf),"[TID%lu]",thread_id));
+        out.push_back(':');
+    }
+
     inline std::string_view LogMsg::gen_composed(){
         if(cfg.disable_extra_information){body.push_back('\n');return body;}
         [[maybe_unused]] static thread_local bool inited = [&]{
             scomposed().clear();
-            scomposed().resize(compose_str_resize);
+            scomposed().reserve(compose_str_resize);
             return false;
         }();
         // 只要保证按照LogMsg的顺序递归而不是lot，那么这个就是valid的
         if(generated)return scomposed();
-        size_t beg = 0;
 
         scomposed().clear();
-        scomposed().resize(scomposed().capacity());
-        if(cfg.gen_date)beg += snprintf(scomposed().data() + beg,scomposed().size() - beg,
-            "[%s]",sdate().c_str());
-        if(cfg.out_level && cfg.level_cast)beg += snprintf(scomposed().data() + beg,scomposed().size() - beg,
-            "[%s]",cfg.level_cast(level).data());
-        if(cfg.out_header && header.data() != nullptr && header.size())beg += snprintf(scomposed().data() + beg,scomposed().size() - beg,
-            "[%s]",header.data());
-        if(cfg.gen_time)beg += snprintf(scomposed().data() + beg,scomposed().size() - beg,
-            "[%.2lfms]",timestamp);
-        if(cfg.gen_thread_id)beg += snprintf(scomposed().data() + beg,scomposed().size() - beg,
-            "[TID%lu]",thread_id);
-        scomposed().resize(beg);
-        scomposed().append(":");
-        
+        compose_prefix(scomposed());
         scomposed() += body;
         scomposed().append(cfg.separator);
         generated = true;
@@ -471,6 +499,10 @@ namespace alib5{
         cfg = msg.cfg;
         level = msg.level;
         tags = std::move(msg.tags);
+        deferred_fn = msg.deferred_fn;
+        deferred_fmt = msg.deferred_fmt;
+        deferred_size = msg.deferred_size;
+        if(deferred_fn)memcpy(deferred_args,msg.deferred_args,deferred_size);
     }
 
     inline LoggerConfig::LoggerConfig(){
@@ -480,6 +512,7 @@ namespace alib5{
         back_pressure_multiply = 4; 
         enable_back_pressure = false;
         maximum_message_count = 100'000;
+        queue_capacity = 0;
     }
 
     template<CanAccessItem T> inline bool Logger::safe_remove_mod(
@@ -593,6 +626,7 @@ namespace alib5{
         def_level = idef_level;
         level_should_keep = ilevel_should_keep;
         msg = msg_cfg;
+        defer_format = false;
     }
 }
 
@@ -0,0 +1,207 @@
+/**
+ * @file msg_queue.h
+ * @brief Bounded lock-free message queue between producers and consumers of the Logger. / Logger生产者与消费者之间的有界无锁队列
+ * @author aaaa0ggmc (lovelinux@yslwd.eu.org)
+ * @version 0.1
+ * @date 2026/07/02
+ *
+ * @copyright Copyright(c)2025 aaaa0ggmc
+ *
+ * @start-date 2026/07/02
+ */
+#ifndef ALOG_MSGQUEUE_INCLUDED
+#define ALOG_MSGQUEUE_INCLUDED
+#include <alib5/log/base_msg.h>
+#include <atomic>
+#include <bit>
+#include <new>
+#include <span>
+
+namespace alib5{
+    /**
+     * @brief Bounded multi-producer multi-consumer ring of preallocated LogMsg slots.
+     * @details
+     * Every slot carries a sequence number: `pos` means free for the producer that claims `pos`,
+     * `pos + 1` means filled. Producers claim a position with one CAS, consumers claim a whole
+     * run of filled slots with one CAS. Messages are moved in and out, so as long as the slots
+     * share the allocators of the messages no string is copied.
+     * @par Original Comment:
+     * 预分配LogMsg槽位的有界多生产者多消费者环形队列，每个槽位带一个序号：等于pos表示可以被占用pos的producer写入，等于pos+1表示已经写好。
+     * producer用一次CAS占一个位置，consumer用一次CAS拿走一串写好的槽位。消息是move进出的，只要槽位和消息的allocator一致就不会复制字符串
+     */
+    struct ALIB5_API LogMsgQueue{
+        /// @brief One slot of the ring. / 环上的一个槽位
+        struct Slot{
+            std::atomic<uint64_t> seq;
+            LogMsg msg;
+
+            inline Slot(uint64_t s,const std::pmr::polymorphic_allocator<char> & __a,const std::pmr::polymorphic_allocator<LogCustomTag> & __tg)
+            :seq(s)
+            ,msg(__a,__tg,LogMsgConfig()){}
+        };
+    private:
+        /// @brief 槽位数组，容量为2的幂
+        Slot * slots {nullptr};
+        /// @brief capacity - 1
+        uint64_t mask {0};
+        /// @brief 下一个producer占用的位置，和dequeue_pos分开放防止伪共享
+        alignas(64) std::atomic<uint64_t> enqueue_pos {0};
+        /// @brief 下一个consumer读取的位置
+        alignas(64) std::atomic<uint64_t> dequeue_pos {0};
+
+        /// @brief 占用从头开始最多max个写好的槽位，返回占用的开始位置，count为0表示队列为空
+        uint64_t claim(size_t max,size_t & count);
+    public:
+        inline LogMsgQueue(){}
+        LogMsgQueue(const LogMsgQueue&) = delete;
+        LogMsgQueue& operator=(const LogMsgQueue&) = delete;
+
+        /**
+         * @brief Allocates the slots, `capacity` is rounded up to a power of two.
+         * @par Original Comment:
+         * 分配槽位，容量向上取整到2的幂。只能在没有其他线程访问的时候调用
+         */
+        void init(size_t capacity,const std::pmr::polymorphic_allocator<char> & __a,const std::pmr::polymorphic_allocator<LogCustomTag> & __tg);
+
+        /**
+         * @brief Moves `msg` into a free slot.
+         * @return false if the ring is full, `msg` is untouched then.
+         * @par Original Comment:
+         * 把msg移动进空闲槽位，队列满时返回false并且不动msg
+         */
+        bool try_push(LogMsg & msg);
+
+        /**
+         * @brief Moves up to `out.size()` messages out, oldest first.
+         * @note  `out` should use the same allocators as the slots, otherwise the bodies are copied.
+         * @return Number of messages written to the front of `out`.
+         * @par Original Comment:
+         * 按先进先出取出最多out.size()条消息，返回写入out前部的数量。out最好与槽位使用同一套allocator，不然会复制body
+         */
+        size_t try_pop(std::span<LogMsg> out);
+
+        /**
+         * @brief Throws away up to `count` of the oldest messages.
+         * @return Number of messages dropped.
+         * @par Original Comment:
+         * 丢弃最多count条最旧的消息，返回实际丢弃的数量
+         */
+        size_t discard(size_t count);
+
+        /// @brief Whether the oldest slot is not filled yet. / 最旧的槽位是否还没写好
+        inline bool empty() const {
+            uint64_t pos = dequeue_pos.load(std::memory_order::acquire);
+            return slots[pos & mask].seq.load(std::memory_order::acquire) != pos + 1;
+        }
+
+        /// @brief Claimed but not yet consumed positions, only a hint under concurrency. / 已占用但尚未消费的数量，并发下只是估计值
+        inline size_t size() const {
+            uint64_t deq = dequeue_pos.load(std::memory_order::relaxed);
+            uint64_t enq = enqueue_pos.load(std::memory_order::relaxed);
+            return enq > deq ? enq - deq : 0;
+        }
+
+        inline size_t capacity() const {
+            return slots ? mask + 1 : 0;
+        }
+
+        ~LogMsgQueue();
+    };
+}
+
+//// inline实现 ////
+namespace alib5{
+    inline void LogMsgQueue::init(size_t capacity,const std::pmr::polymorphic_allocator<char> & __a,const std::pmr::polymorphic_allocator<LogCustomTag> & __tg){
+        capacity = std::bit_ceil(capacity < 2 ? size_t(2) : capacity);
+        // Slot里面有atomic，不能放进vector，只好手动构造
+        slots = static_cast<Slot*>(::operator new(sizeof(Slot) * capacity,std::align_val_t(alignof(Slot))));
+        for(size_t i = 0;i < capacity;++i){
+            new(slots + i) Slot(i,__a,__tg);
+        }
+        mask = capacity - 1;
+        enqueue_pos.store(0,std::memory_order::relaxed);
+        dequeue_pos.store(0,std::memory_order::relaxed);
+    }
+
+    inline LogMsgQueue::~LogMsgQueue(){
+        if(!slots)return;
+        for(size_t i = 0;i <= mask;++i){
+            slots[i].~Slot();
+        }
+        ::operator delete(slots,std::align_val_t(alignof(Slot)));
+    }
+
+    inline bool LogMsgQueue::try_push(LogMsg & msg){
+        uint64_t pos = enqueue_pos.load(std::memory_order::relaxed);
+        Slot * slot;
+        while(true){
+            slot = slots + (pos & mask);
+            uint64_t seq = slot->seq.load(std::memory_order::acquire);
+            int64_t diff = (int64_t)seq - (int64_t)pos;
+            if(diff == 0){
+                if(enqueue_pos.compare_exchange_weak(pos,pos + 1,std::memory_order::relaxed))break;
+            }else if(diff < 0){
+                // 这个槽位还没被上一圈的consumer取走
+                return false;
+            }else pos = enqueue_pos.load(std::memory_order::relaxed);
+        }
+        slot->msg = std::move(msg);
+        slot->seq.store(pos + 1,std::memory_order::release);
+        return true;
+    }
+
+    inline uint64_t LogMsgQueue::claim(size_t max,size_t & count){
+        uint64_t pos = dequeue_pos.load(std::memory_order::relaxed);
+        while(true){
+            // 数一数从pos开始连续写好了多少个
+            size_t ready = 0;
+            while(ready < max && slots[(pos + ready) & mask].seq.load(std::memory_order::acquire) == pos + ready + 1){
+                ++ready;
+            }
+            if(!ready){
+                int64_t diff = (int64_t)slots[pos & mask].seq.load(std::memory_order::acquire) - (int64_t)(pos + 1);
+                uint64_t now = dequeue_pos.load(std::memory_order::relaxed);
+                // 头部还没写好并且也没有被别的consumer拿走，就是空的
+                if(diff < 0 && now == pos){
+                    count = 0;
+                    return pos;
+                }
+                pos = now;
+                continue;
+            }
+            // 只要dequeue_pos还是pos，看到的这些槽位就不会被别人动
+            if(dequeue_pos.compare_exchange_weak(pos,pos + ready,std::memory_order::relaxed)){
+                count = ready;
+                return pos;
+            }
+        }
+    }
+
+    inline size_t LogMsgQueue::try_pop(std::span<LogMsg> out){
+        if(out.empty())return 0;
+        size_t count = 0;
+        uint64_t pos = claim(out.size(),count);
+        for(size_t i = 0;i < count;++i){
+            Slot & slot = slots[(pos + i) & mask];
+            out[i] = std::move(slot.msg);
+            slot.seq.store(pos + i + mask + 1,std::memory_order::release);
+        }
+        return count;
+    }
+
+    inline size_t LogMsgQueue::discard(size_t count){
+        if(!count)return 0;
+        size_t got = 0;
+        uint64_t pos = claim(count,got);
+        for(size_t i = 0;i < got;++i){
+            Slot & slot = slots[(pos + i) & mask];
+            // 保留容量，下次move进来时直接换掉
+            slot.msg.body.clear();
+            slot.msg.tags.clear();
+            slot.seq.store(pos + i + mask + 1,std::memory_order::release);
+        }
+        return got;
+    }
+}
+
+#endif
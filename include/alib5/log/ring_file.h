@@ -0,0 +1,128 @@
+/**
+ * @file ring_file.h
+ * @brief Crash resilient log target: a fixed-size memory-mapped file used as a ring. / 崩溃后也能留下日志的输出对象：把固定大小的映射文件当环形缓冲用
+ * @author aaaa0ggmc (lovelinux@yslwd.eu.org)
+ * @version 0.1
+ * @date 2026/07/06
+ *
+ * @copyright Copyright(c)2025 aaaa0ggmc
+ *
+ * @start-date 2026/07/06
+ */
+#ifndef ALOG_PREFAB_RINGFILE
+#define ALOG_PREFAB_RINGFILE
+#include <alib5/log/targets.h>
+#include <functional>
+#include <mutex>
+
+namespace alib5{
+    namespace lot{
+        /// @brief RingFile默认的数据区大小
+        constexpr uint64_t ring_file_default_capacity = 4 * 1024 * 1024;
+        /// @brief 文件头的magic
+        constexpr char ring_file_magic[8] = {'A','L','O','G','R','N','G','1'};
+
+        /**
+         * @brief File header of a RingFile, followed by `capacity` bytes of records.
+         * @details
+         * `head`, `tail` and `seq` only grow, the physical position is `offset % capacity`. Records live in
+         * [tail,head), each is a RingFileRecord followed by its text, padded to 8 bytes. A record never crosses
+         * the end of the data area, the rest of the lap is skipped with a wrap record (or silently when less
+         * than a record header is left). A snapshot can still see a `tail` older than the bytes it points at,
+         * so every record carries a checksum and readers verify it instead of trusting the header alone.
+         * @par Original Comment:
+         * RingFile的文件头，后面跟着capacity字节的记录区。head、tail、seq只增不减，物理位置为offset % capacity。
+         * 有效记录位于[tail,head)，每条是RingFileRecord加上文本，补齐到8字节。记录不会跨过数据区末尾，剩下的部分用wrap记录跳过(不够一个记录头时直接跳过)。
+         * 快照里的tail仍可能比它指向的内容旧，所以每条记录都带校验和，读取时逐条校验而不是只相信文件头
+         */
+        struct RingFileHeader{
+            char magic[8];
+            uint32_t version;
+            uint32_t header_size;
+            /// @brief 数据区大小，8的倍数
+            uint64_t capacity;
+            /// @brief 下一条记录写入的位置，记录写完之后才更新
+            uint64_t head;
+            /// @brief 最旧的有效记录的位置
+            uint64_t tail;
+            /// @brief 下一条记录的序号
+            uint64_t seq;
+            uint64_t reserved[2];
+        };
+        static_assert(sizeof(RingFileHeader) == 64);
+
+        /// @brief Header of one record. / 单条记录的头
+        struct RingFileRecord{
+            /// @brief 文本的字节数
+            uint32_t size;
+            /// @brief 0为普通记录，1为wrap记录
+            uint32_t flags;
+            /// @brief 记录序号，连续递增
+            uint64_t seq;
+            /// @brief 覆盖size、flags、seq和文本的校验和
+            uint32_t checksum;
+            uint32_t reserved;
+        };
+        static_assert(sizeof(RingFileRecord) == 24);
+
+        /**
+         * @brief Writes composed messages into a memory-mapped ring file.
+         * @details
+         * The mapping is shared with the OS page cache, so everything written survives a crash or kill of the
+         * process without any flush. A record is published by moving `head` after its bytes are in place, a
+         * message torn by a crash is simply not part of the ring. An existing file with the same capacity is
+         * continued instead of cleared, read it with read_ring_file after a restart.
+         * @par Original Comment:
+         * 把组合好的消息写入映射成环形缓冲的文件。映射和系统页缓存共享，进程崩溃或者被kill之后已经写进去的内容都还在，不需要flush。
+         * 记录的内容写好之后才移动head发布，崩溃时写了一半的消息不会算进环里。已经存在并且容量相同的文件会接着写而不是清空，重启后可以用read_ring_file读出来
+         */
+        struct ALIB5_API RingFile : public LogTarget{
+        private:
+            /// @brief 多个consumer同时写入时上锁
+            std::mutex ring_lock;
+            RingFileHeader * header {nullptr};
+            char * records {nullptr};
+            size_t mapped_size {0};
+            #ifdef _WIN32
+            void * mapping_handle {nullptr};
+            #endif
+
+            /// @brief 为need字节腾出空间，必要时推进tail
+            void reserve(uint64_t need);
+            /// @brief 追加一条记录，pieces首尾相接作为文本
+            void append(std::string_view prefix,std::string_view body,std::string_view tail);
+        public:
+            /**
+             * @brief Maps `path`, creating or resizing it when it does not hold a ring of `capacity` bytes.
+             * @param capacity Bytes of the data area, rounded up to a multiple of 8.
+             */
+            RingFile(std::string_view path,uint64_t capacity = ring_file_default_capacity);
+
+            /// @brief Whether the file is mapped. / 文件是否映射成功
+            inline bool valid() const { return header != nullptr; }
+
+            void write(LogMsg & msg) override;
+            void write_batch(std::span<LogMsg> msgs) override;
+            /// @brief 页缓存里的内容由系统负责落盘，这里什么都不用做
+            inline void flush() override {}
+            void close() override;
+
+            inline ~RingFile(){
+                close();
+            }
+        };
+
+        /**
+         * @brief Reads the messages of a ring file in order, oldest first.
+         * @details Works on a snapshot of the file and verifies the checksum of every record. Records at the start that were
+         *          being overwritten when the snapshot was taken are skipped, reading stops at the first invalid record after that.
+         * @param fn Receives the sequence number and the composed text of each message.
+         * @return false if the file cannot be read or has no valid header.
+         * @par Original Comment:
+         * 按从旧到新的顺序读出环形文件中的消息。读取的是文件的快照，逐条检查校验和：开头正在被覆盖的记录会被跳过，之后遇到第一条不合法的记录就停止。文件无法读取或者文件头不合法时返回false
+         */
+        ALIB5_API bool read_ring_file(std::string_view path,const std::function<void(uint64_t seq,std::string_view text)> & fn);
+    }
+}
+
+#endif
@@ -12,9 +12,16 @@
 #ifndef ALOG_PREFAB_TARGETS
 #define ALOG_PREFAB_TARGETS
 #include <alib5/log/kernel.h>
+#include <alib5/log/compress.h>
 #include <alib5/adebug.h>
+#include <condition_variable>
+#include <deque>
 #include <functional>
 #include <future>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
 #include <stdio.h>
 
 #ifdef __linux__
@@ -46,6 +53,84 @@
 namespace alib5{
     namespace lot{
         constexpr const char * rotate_file_def_fmt = "log{1}.txt";
+        /// @brief 一次writev最多提交的iovec数量，每条消息最多占3个
+        constexpr size_t batch_iov_max = 1024;
+
+        namespace detail{
+            /**
+             * @brief Composed form of a batch: prefixes packed in one buffer, bodies are not copied.
+             * @details Built once per batch, then any range of it can be submitted with one writev.
+             * @par Original Comment:
+             * 一批消息的组合结果，前缀集中放在一块内存里，body不复制。每批构建一次，之后任意一段都可以用一次writev提交
+             */
+            struct ALIB5_API ComposedBatch{
+                /// @brief 所有前缀首尾相接
+                std::string prefixes;
+                /// @brief 第i条消息的前缀在prefixes中的结束位置
+                std::vector<size_t> prefix_end;
+                /// @brief 第i条消息组合之后的总长度
+                std::vector<size_t> sizes;
+
+                /// @brief 为整批消息生成前缀，需要在build_on_consumer之后调用
+                void build(std::span<LogMsg> msgs);
+                /// @brief 把[begin,end)这一段写入f，POSIX下是一次writev(短写时继续)，返回写入的字节数
+                size_t write(FILE * f,std::span<LogMsg> msgs,size_t begin,size_t end) const;
+                /// @brief 把[begin,end)这一段交给压缩流，返回未压缩的字节数
+                size_t write(LZStreamWriter & out,std::span<LogMsg> msgs,size_t begin,size_t end) const;
+            };
+
+            /**
+             * @brief Background worker of RotateFile: compresses finished segments and applies the retention policy.
+             * @details The thread is started on the first finished segment, stop() handles what is still queued and joins it.
+             *          seed() picks up the segments earlier runs left behind, so the limits hold across restarts.
+             * @par Original Comment:
+             * RotateFile的后台线程：压缩写完的文件并执行保留策略。第一个文件写完时才启动线程，stop()处理完排队的文件后再join。
+             * seed()找到之前运行留下的文件，保留策略在重启之后依旧有效
+             */
+            struct ALIB5_API SegmentJanitor{
+                struct Segment{
+                    std::string path;
+                    uint64_t size;
+                };
+                /// @brief 是否压缩成.lz
+                bool compress {false};
+                /// @brief 最多保留的文件数，0表示不限制
+                unsigned int retain_count {0};
+                /// @brief 最多占用的字节数，0表示不限制
+                uint64_t retain_bytes {0};
+
+                /// @brief 有没有需要做的事
+                inline bool active() const {
+                    return compress || retain_count || retain_bytes;
+                }
+                /// @brief 扫描filepath_fmt所在的目录，把符合格式的文件按修改时间从旧到新登记，需要压缩的交给后台线程
+                void seed(std::string_view filepath_fmt);
+                /// @brief 当前正在写入的文件，不会被删除
+                void set_active(std::string path);
+                /// @brief 交给后台线程处理一个写完的文件
+                void submit(std::string path);
+                /// @brief 处理完排队的文件，结束线程
+                void stop();
+            private:
+                std::mutex lock;
+                std::condition_variable cv;
+                std::deque<std::string> pending;
+                bool stopping {false};
+                std::string current;
+                /// @brief 已经处理完保留下来的文件，从旧到新
+                std::deque<Segment> kept;
+                uint64_t kept_bytes {0};
+                std::jthread worker;
+
+                void run();
+                /// @brief 需要持有lock
+                void keep(std::string path);
+                /// @brief 需要持有lock
+                void forget(std::string_view path);
+                /// @brief 需要持有lock
+                void enforce_retention();
+            };
+        }
 
         /// @brief 标准与亮色颜色枚举
         enum class Color : uint8_t {
@@ -149,10 +234,12 @@ namespace alib5{
             }
 
             inline File(std::string_view fpath){
+                batch_write = true;
                 open_file(fpath);
             }
 
             inline File(FILE * f){
+                batch_write = true;
                 file = f;
                 need_close = false;
             }
@@ -162,6 +249,14 @@ namespace alib5{
                 fwrite(p.data(),sizeof(decltype(p)::value_type),p.size(),file);
             }
 
+            /// @brief 整批一次writev写入
+            inline void write_batch(std::span<LogMsg> msgs) override{
+                if(!file)return;
+                static thread_local detail::ComposedBatch batch;
+                batch.build(msgs);
+                batch.write(file,msgs,0,msgs.size());
+            }
+
             inline void flush() override{
                 fflush(file);
             }
@@ -185,6 +280,14 @@ namespace alib5{
             long int rotate_time;
             /// @brief 当打开文件失败后的通知，默认为空
             IOFailedCallbackFN failed_open_fn;
+            /// @brief 轮换出去的文件在后台线程压缩成"文件名.lz"并删除原文件，默认false
+            bool compress_rotated;
+            /// @brief 当前文件直接流式压缩写入"文件名.lz"，崩溃时最多丢失lz_block_size字节未压缩的内容，默认false
+            bool stream_compress;
+            /// @brief 最多保留多少个轮换出去的文件，更旧的会被删除，0表示不限制，默认0；启动时目录里符合filepath_fmt的旧文件也算在内
+            unsigned int retain_count;
+            /// @brief 轮换出去的文件(压缩后)最多占用多少字节，0表示不限制，默认0；同样包括之前运行留下的文件
+            uint64_t retain_bytes;
 
             /// @brief 初始化输出对象
             inline RotateFileConfig(
@@ -197,6 +300,10 @@ namespace alib5{
                 rotate_size = ro_size;
                 rotate_time = ro_time;
                 failed_open_fn = fn;
+                compress_rotated = false;
+                stream_compress = false;
+                retain_count = 0;
+                retain_bytes = 0;
             }
         };
 
@@ -210,10 +317,17 @@ namespace alib5{
             std::string current_fp_delayed;
             RotateFileConfig config;
             timespec last_expire {-1,-1};
+            /// @brief stream_compress时的压缩流
+            LZStreamWriter stream;
+            detail::SegmentJanitor janitor;
 
             inline bool expires(){
                 timespec tm;
                 clock_gettime(time_clock_source,&tm);
+                return expires(tm);
+            }
+
+            inline bool expires(const timespec & tm){
                 // 大小超了
                 bool opt = config.rotate_size && (bytes_written >= config.rotate_size);
                 $defer{
@@ -233,6 +347,27 @@ namespace alib5{
                 return false;
             }
 
+            /// @brief 关掉当前文件，打开下一个
+            inline void open_next(){
+                // 刚写完的文件，之后交给后台线程
+                std::string finished;
+                if(f && janitor.active())finished = current_fp_delayed;
+                close();
+                noneed_update = false;
+                f = fopen(get_current_filepath().data(),config.stream_compress ? "wb" : "w");
+                // 重置写入量
+                panicf_debug(!f,"Cannot open file {}!",get_current_filepath());
+                if(!f && config.failed_open_fn){
+                    config.failed_open_fn(get_current_filepath(),*this);
+                }else{
+                    ++rotate_index;
+                }
+                if(f && config.stream_compress)stream.open(f);
+                if(f && janitor.active())janitor.set_active(std::string(get_current_filepath()));
+                // 文件名没变说明旧文件已经被截断重用了
+                if(!finished.empty() && finished != get_current_filepath())janitor.submit(std::move(finished));
+            }
+
         public:
             inline std::string_view get_current_filepath(){
                 if(noneed_update)return current_fp_delayed;
@@ -243,29 +378,23 @@ namespace alib5{
 
                 std::vformat_to(std::back_inserter(current_fp_delayed),
                 config.filepath_fmt,std::make_format_args(curtime,rotate_index));
+                if(config.stream_compress)current_fp_delayed += ".lz";
                 return current_fp_delayed;
             }
 
+            /// @brief 压缩流只在攒满一块时写出，flush不会强行切块
             inline void flush() override{
                 if(f)fflush(f);
             }
 
             inline void try_open(){
                 if(f && !expires())return;
-                close();
-                noneed_update = false;
-                f = fopen(get_current_filepath().data(),"w");
-                // 重置写入量
-                panicf_debug(!f,"Cannot open file {}!",get_current_filepath());
-                if(!f && config.failed_open_fn){
-                    config.failed_open_fn(get_current_filepath(),*this);
-                }else{
-                    ++rotate_index;
-                }
+                open_next();
             }
 
             inline void close() override{
                 if(f){
+                    if(config.stream_compress)stream.finish();
                     fclose(f);
                     bytes_written = 0;
                     f = nullptr;
@@ -276,13 +405,63 @@ namespace alib5{
                 try_open();
                 if(f){
                     auto p = msg.gen_composed();
-                    bytes_written += fwrite(p.data(),sizeof(decltype(p)::value_type),p.size(),f);
+                    if(config.stream_compress){
+                        // 轮换大小按未压缩的字节数算
+                        stream.write(p);
+                        bytes_written += p.size();
+                    }else bytes_written += fwrite(p.data(),sizeof(decltype(p)::value_type),p.size(),f);
+                }
+            }
+
+            /// @brief 整批写入，时间每批只检查一次，大小超了就在那条消息之后切开换文件
+            inline void write_batch(std::span<LogMsg> msgs) override{
+                static thread_local detail::ComposedBatch batch;
+                batch.build(msgs);
+
+                timespec now;
+                clock_gettime(time_clock_source,&now);
+                if(!f || expires(now))open_next();
+
+                auto flush_range = [this](std::span<LogMsg> m,size_t b,size_t e){
+                    if(!f)return;
+                    if(config.stream_compress)bytes_written += batch.write(stream,m,b,e);
+                    else bytes_written += batch.write(f,m,b,e);
+                };
+                size_t begin = 0;
+                uint64_t pending = 0;
+                for(size_t i = 0;i < msgs.size();++i){
+                    pending += batch.sizes[i];
+                    if(!config.rotate_size || bytes_written + pending < config.rotate_size)continue;
+                    flush_range(msgs,begin,i + 1);
+                    begin = i + 1;
+                    pending = 0;
+                    if(begin < msgs.size()){
+                        last_expire = now;
+                        open_next();
+                    }
                 }
+                flush_range(msgs,begin,msgs.size());
             }
 
             inline RotateFile(RotateFileConfig cfg = RotateFileConfig()){
+                batch_write = true;
                 config = cfg;
+                // 流式压缩的文件已经是.lz了，后台只需要执行保留策略
+                janitor.compress = config.compress_rotated && !config.stream_compress;
+                janitor.retain_count = config.retain_count;
+                janitor.retain_bytes = config.retain_bytes;
                 try_open();
+                // 先打开当前文件，扫描时才能把它排除掉
+                if(janitor.active())janitor.seed(config.filepath_fmt);
+            }
+
+            /// @brief 写完最后一个压缩块，最后一个文件同样交给后台线程，等它处理完排队的文件
+            inline ~RotateFile(){
+                std::string last;
+                if(f && janitor.active())last = current_fp_delayed;
+                close();
+                if(!last.empty())janitor.submit(std::move(last));
+                janitor.stop();
             }
 
         };
@@ -1,6 +1,11 @@
 #include <alib5/alogger.h>
+#include <bit>
 #include <climits>
+#include <cerrno>
 #include <stacktrace>
+#ifndef _WIN32
+#include <sys/uio.h>
+#endif
 
 using namespace alib5;
 
@@ -16,6 +21,86 @@ std::string& LogMsg::scomposed(){
     return scomposed;
 }
 
+void lot::detail::ComposedBatch::build(std::span<LogMsg> msgs){
+    prefixes.clear();
+    prefix_end.clear();
+    sizes.clear();
+    prefix_end.reserve(msgs.size());
+    sizes.reserve(msgs.size());
+    for(auto & msg : msgs){
+        size_t beg = prefixes.size();
+        msg.compose_prefix(prefixes);
+        prefix_end.push_back(prefixes.size());
+        sizes.push_back(prefixes.size() - beg + msg.body.size() + msg.composed_tail().size());
+    }
+}
+
+size_t lot::detail::ComposedBatch::write(FILE * f,std::span<LogMsg> msgs,size_t begin,size_t end) const {
+    if(begin >= end)return 0;
+#ifdef _WIN32
+    // 没有writev，拼成一块再写
+    static thread_local std::string joined;
+    joined.clear();
+    for(size_t i = begin;i < end;++i){
+        size_t pb = i ? prefix_end[i - 1] : 0;
+        joined.append(prefixes,pb,prefix_end[i] - pb);
+        joined += msgs[i].body;
+        joined += msgs[i].composed_tail();
+    }
+    return __internal_alib_fw(joined.data(),1,joined.size(),f);
+#else
+    static thread_local std::vector<iovec> iov;
+    iov.clear();
+    auto push = [](std::string_view sv){
+        if(sv.empty())return;
+        iov.push_back(iovec{const_cast<char*>(sv.data()),sv.size()});
+    };
+    for(size_t i = begin;i < end;++i){
+        size_t pb = i ? prefix_end[i - 1] : 0;
+        push(std::string_view(prefixes).substr(pb,prefix_end[i] - pb));
+        push(msgs[i].body);
+        push(msgs[i].composed_tail());
+    }
+    // 之前可能有人直接往FILE里写过，先把stdio缓冲推下去保证顺序
+    fflush(f);
+
+    int fd = FILENO(f);
+    size_t written = 0;
+    size_t idx = 0;
+    while(idx < iov.size()){
+        int cnt = (int)std::min<size_t>(iov.size() - idx,batch_iov_max);
+        ssize_t n = ::writev(fd,iov.data() + idx,cnt);
+        if(n < 0 && errno == EINTR)continue;
+        if(n <= 0)break;
+        written += n;
+        // 跳过已经写完的部分，剩下的是短写
+        while(n > 0){
+            if((size_t)n >= iov[idx].iov_len){
+                n -= iov[idx].iov_len;
+                ++idx;
+            }else{
+                iov[idx].iov_base = (char*)iov[idx].iov_base + n;
+                iov[idx].iov_len -= n;
+                n = 0;
+            }
+        }
+    }
+    return written;
+#endif
+}
+
+size_t lot::detail::ComposedBatch::write(LZStreamWriter & out,std::span<LogMsg> msgs,size_t begin,size_t end) const {
+    size_t written = 0;
+    for(size_t i = begin;i < end;++i){
+        size_t pb = i ? prefix_end[i - 1] : 0;
+        out.write(std::string_view(prefixes).substr(pb,prefix_end[i] - pb));
+        out.write(msgs[i].body);
+        out.write(msgs[i].composed_tail());
+        written += sizes[i];
+    }
+    return written;
+}
+
 void log_stacktrace::write_to_log(std::pmr::string & str){
     int index = -1;
     for(auto & entry : std::stacktrace::current()){
@@ -171,41 +256,57 @@ void Logger::setup_consumer_threads(){
     }
 }
 
+void Logger::wake_consumers(bool all){
+    msg_signal.fetch_add(1,std::memory_order::release);
+    if(all)msg_signal.notify_all();
+    else msg_signal.notify_one();
+}
+
+void Logger::prepare_batch(std::vector<LogMsg> & target){
+    static LogMsgConfig default_fetch_cfg;
+    // 与槽位使用同一套allocator，move的时候直接交换指针
+    target.reserve(config.fetch_message_count_max);
+    while(target.size() < config.fetch_message_count_max){
+        target.emplace_back(msg_str_alloc,tag_alloc,default_fetch_cfg);
+    }
+}
+
 void Logger::consumer_func(){
     std::vector<LogMsg> target;
-    // 提前分配好内存，避免锁内分配
-    target.reserve(config.fetch_message_count_max); 
+    // 提前分配好内存
+    prepare_batch(target);
 
     while(true){
-        {
-            std::unique_lock<std::mutex> lock(msg_lock);
-            cv.wait(lock, [this]{
-                return !messages.empty() || !logger_not_on_destroying;
-            });
-            if(!logger_not_on_destroying && messages.empty()){
-                return; 
+        // 批量拉取数据，一次CAS拿走一串
+        size_t count = msg_queue.try_pop(std::span(target));
+        if(count){
+            // 拿满了说明还有剩的，叫醒下一个consumer一起干
+            if(count == target.size() && sleeping_consumers.load(std::memory_order::relaxed)){
+                wake_consumers();
             }
-            
-            // 批量拉取数据
-            size_t fetch_size = std::min((size_t)config.fetch_message_count_max, messages.size());
-            target.clear();
-            for(size_t i = 0; i < fetch_size; ++i){
-                target.push_back(std::move(messages.front()));
-                messages.pop_front();
-            }
-            message_size.fetch_sub(fetch_size, std::memory_order::relaxed);
+            write_messages(std::span(target).subspan(0,count));
+            continue;
+        }
+        if(!logger_not_on_destroying.load(std::memory_order::acquire)){
+            return;
+        }
 
-            if(config.consumer_count > 1 && !messages.empty()){
-                cv.notify_one();
-            }
+        // 先拿到signal再登记等待，之后再确认一次队列，producer只在有人等待时才notify
+        uint32_t signal = msg_signal.load(std::memory_order::acquire);
+        sleeping_consumers.fetch_add(1,std::memory_order::seq_cst);
+        std::atomic_thread_fence(std::memory_order::seq_cst);
+        if(msg_queue.empty() && logger_not_on_destroying.load(std::memory_order::acquire)){
+            msg_signal.wait(signal,std::memory_order::acquire);
         }
-        
-        // 在锁外无阻塞输出数据
-        write_messages(std::span(target));
+        sleeping_consumers.fetch_sub(1,std::memory_order::relaxed);
     }
 }
 
 void Logger::write_messages(std::span<LogMsg> msgs,bool autoflush){
+    // 延迟格式化的消息在这里生成body，filter和target看到的都是完整的消息
+    for(auto & msg : msgs){
+        msg.materialize();
+    }
     if(!filters.empty()){
         for(auto & msg : msgs){
             if(!msg.m_nice_one)continue;
@@ -217,6 +318,7 @@ void Logger::write_messages(std::span<LogMsg> msgs,bool autoflush){
             }
         }
     }
+    bool has_batch = false;
     for(size_t i = 0;i < msgs.size();++i){
         auto& t = msgs[i];
         if(!t.m_nice_one)continue;
@@ -226,49 +328,42 @@ void Logger::write_messages(std::span<LogMsg> msgs,bool autoflush){
             // 不选择&了
             auto target = targets[i];
             if(!target->enabled)continue;
+            if(target->batch_write){
+                has_batch = true;
+                continue;
+            }
             target->write(t);
         }
     }
+    if(has_batch){
+        // 通过过滤的消息挪到前面，整批交出去
+        size_t kept = 0;
+        for(size_t i = 0;i < msgs.size();++i){
+            if(!msgs[i].m_nice_one)continue;
+            if(i != kept)msgs[kept] = std::move(msgs[i]);
+            ++kept;
+        }
+        for(size_t i = 0;i < targets.size();++i){
+            auto target = targets[i];
+            if(!target->enabled || !target->batch_write)continue;
+            target->write_batch(msgs.subspan(0,kept));
+        }
+    }
     if(autoflush){
         flush_targets();
     }
 }
 
 size_t Logger::fetch_messages(std::vector<LogMsg> & target){
-    static LogMsgConfig default_fetch_cfg;
-    // 一次性拿完
-    size_t i = 0;
-    size_t fetch_size;
     // 对target进行扩容
-    target.resize(config.fetch_message_count_max);
-    {
-        std::lock_guard<std::mutex> lock(msg_lock);
-
-        size_t cur_size = messages.size();
-        if(!cur_size){
-            return 0;
-        }
-        fetch_size = config.fetch_message_count_max<cur_size?
-                                config.fetch_message_count_max:cur_size;
-        for(;i < fetch_size;++i){
-            /// @NOTE 加message请往后面加
-            auto & msg = messages.front();
-            // 调用move构造从而降低调用
-            target[i] = std::move(msg);
-            messages.pop_front();
-        }
-        message_size.fetch_sub(fetch_size,std::memory_order::relaxed);
-    }
-    return fetch_size;
+    prepare_batch(target);
+    if(!msg_queue.capacity())return 0;
+    return msg_queue.try_pop(std::span(target).subspan(0,config.fetch_message_count_max));
 }
 
 Logger::Logger(const LoggerConfig & cfg)
-:msg_buf()
-,msg_alloc(&msg_buf)
-,messages(msg_alloc)
-,msg_str_buf()
+:msg_str_buf()
 ,msg_str_alloc(&msg_str_buf)
-,cv()
 ,config(cfg)
 ,tag_buf()
 ,tag_alloc(&tag_buf)
@@ -277,12 +372,22 @@ Logger::Logger(const LoggerConfig & cfg)
     back_pressure_threshold = cfg.back_pressure_multiply * 
                 cfg.fetch_message_count_max * cfg.consumer_count;
     clock_gettime(time_clock_source,&start_time);
+    // 同步模式用不到队列
+    if(config.consumer_count){
+        // 默认比maximum_message_count多一点，超过上限时的drop half策略照旧生效
+        size_t capacity = config.queue_capacity ? config.queue_capacity : std::bit_ceil((size_t)config.maximum_message_count + 1);
+        msg_queue.init(capacity,msg_str_alloc,tag_alloc);
+    }
     setup_consumer_threads();
 }
 
 Logger::~Logger(){
-    logger_not_on_destroying = false;
-    cv.notify_all();
+    logger_not_on_destroying.store(false,std::memory_order::seq_cst);
+    wake_consumers(true);
+    // consumer先退出，队列和内存池才能安全析构
+    for(auto & consumer : consumers){
+        if(consumer.joinable())consumer.join();
+    }
     flush();
 }
 
@@ -304,40 +409,76 @@ bool Logger::push_message_pmr(int level,std::string_view head,std::pmr::string &
         if(!filter->enabled)continue;
         if(!filter->pre_filter(level,body,cfg))return false;
     }
-    LogMsg msg(msg_alloc,tag_alloc,cfg);
-    size_t msg_sz = 0;
+    LogMsg msg(msg_str_alloc,tag_alloc,cfg);
 
     msg.header = head;
     msg.level = level;
     msg.body = std::move(body);
     if(tags)msg.tags = std::move(*tags);
     msg.build_on_producer(start_time);
-   
-    if(config.consumer_count){ // 异步模式
-        {
-            std::lock_guard<std::mutex> lock(msg_lock);
-            messages.emplace_back(std::move(msg));
-            msg_sz = message_size.fetch_add(1,std::memory_order::relaxed) + 1;
-
-            /// 开启drop策略
-            if(msg_sz > config.maximum_message_count) [[unlikely]] {
-                messages.erase(messages.begin(),messages.begin() + config.maximum_message_count / 2);
-                message_size.store(messages.size());
-                msg_sz = messages.size();
-            }
-        }
-        cv.notify_one(); 
+    return submit_message(msg);
+}
 
-        bool should_digest = (config.enable_back_pressure && (msg_sz >= back_pressure_threshold));
-        // 没有线程就别吃了
-        if(should_digest){
+bool Logger::push_message_deferred(int level,std::string_view head,LogMsg & msg){
+    // pre filter，此时还没有body，只能给格式字符串
+    for(auto & filter : filters){
+        if(!filter->enabled)continue;
+        if(!filter->pre_filter(level,msg.deferred_fmt,msg.cfg))return false;
+    }
+    msg.header = head;
+    msg.level = level;
+    msg.build_on_producer(start_time);
+    return submit_message(msg);
+}
+
+bool Logger::submit_message(LogMsg & msg){
+    size_t msg_sz = 0;
+    if(config.consumer_count){ // 异步模式
+        // 吃掉一批消息，背压和队列满的时候用
+        auto digest = [this]{
             static thread_local std::vector<LogMsg> msgs;
             size_t count = fetch_messages(msgs);
             // 没取出一个，说明可能算错了啥的，基本不会发生
             if(count){
                 write_messages(std::span(msgs).subspan(0,count));
-                msgs.clear();
             }
+            // 里面的字符串来自当前Logger的池子，不能留到线程退出
+            msgs.clear();
+        };
+        unsigned int retry = 0;
+        while(!msg_queue.try_push(msg)) [[unlikely]] {
+            /// 队列满了，背压就自己消化
+            if(config.enable_back_pressure){
+                digest();
+                continue;
+            }
+            // 多半只是consumer暂时没跟上，叫醒它并让出时间片
+            if(retry++ < logger_queue_full_retry){
+                wake_consumers();
+                std::this_thread::yield();
+                continue;
+            }
+            // 一直满着才丢掉最旧的一批
+            msg_queue.discard(config.fetch_message_count_max);
+            retry = 0;
+        }
+        msg_sz = msg_queue.size();
+        /// 开启drop策略
+        if(msg_sz > config.maximum_message_count) [[unlikely]] {
+            msg_queue.discard(config.maximum_message_count / 2);
+            msg_sz = msg_queue.size();
+        }
+
+        // 与consumer登记等待的过程配对，两边都有fence才不会漏掉唤醒
+        std::atomic_thread_fence(std::memory_order::seq_cst);
+        if(sleeping_consumers.load(std::memory_order::relaxed)){
+            wake_consumers();
+        }
+
+        bool should_digest = (config.enable_back_pressure && (msg_sz >= back_pressure_threshold));
+        // 没有线程就别吃了
+        if(should_digest){
+            digest();
         }
     }else{ // 同步模式
         // 不自动刷新从而节省性能
@@ -0,0 +1,400 @@
+#include <alib5/adata.h>
+#include <alib5/data/data_binary.h>
+#include <bit>
+#include <cstring>
+
+using namespace alib5;
+using namespace alib5::data;
+
+namespace {
+    template<class T>
+    inline T to_le(T v){
+        if constexpr(std::endian::native == std::endian::big)return std::byteswap(v);
+        else return v;
+    }
+
+    template<class Out>
+    struct BinaryWriter{
+        Out& out;
+
+        inline void put_u8(uint8_t v){ out.push_back((char)v); }
+
+        template<class T>
+        inline void put_raw(T v){
+            auto u = to_le(std::bit_cast<std::conditional_t<sizeof(T) == 8, uint64_t, uint32_t>>(v));
+            out.append(reinterpret_cast<const char*>(&u), sizeof(u));
+        }
+
+        inline void put_varint(uint64_t v){
+            char tmp[10];
+            size_t n = 0;
+            while(v >= 0x80){
+                tmp[n++] = (char)(v | 0x80);
+                v >>= 7;
+            }
+            tmp[n++] = (char)v;
+            out.append(tmp, n);
+        }
+
+        inline void put_string(std::string_view s){
+            put_varint(s.size());
+            out.append(s);
+        }
+
+        /// 回填容器长度,超过4GB时原地扩成64位
+        void patch_length(size_t len_pos, size_t body_start){
+            uint64_t len = out.size() - body_start;
+            if(len <= UINT32_MAX){
+                uint32_t v = to_le((uint32_t)len);
+                std::memcpy(out.data() + len_pos, &v, sizeof(v));
+                return;
+            }
+            out.insert(len_pos + 4, 4, '\0');
+            uint8_t& tag = reinterpret_cast<uint8_t&>(out[len_pos - 1]);
+            tag = tag == Binary::TagObject ? Binary::TagObject64 : Binary::TagArray64;
+            uint64_t v = to_le(len);
+            std::memcpy(out.data() + len_pos, &v, sizeof(v));
+        }
+    };
+
+    template<class Out>
+    void dump_impl(Out& out, const dadata_t& root){
+        struct Frame{
+            const dadata_t* node;
+            std::string_view key;
+            bool has_key;
+            bool close;
+            size_t len_pos;
+            size_t body_start;
+        };
+        BinaryWriter<Out> w { out };
+        std::vector<Frame> stack;
+
+        out.append(Binary::magic);
+        w.put_u8(Binary::version);
+        stack.push_back({&root, {}, false, false, 0, 0});
+
+        while(!stack.empty()){
+            Frame f = stack.back();
+            stack.pop_back();
+
+            if(f.close){
+                w.patch_length(f.len_pos, f.body_start);
+                continue;
+            }
+            if(f.has_key)w.put_string(f.key);
+
+            switch(f.node->get_type()){
+            case dadata_t::TNull:
+                w.put_u8(Binary::TagNull);
+                break;
+            case dadata_t::TValue: {
+                const dvalue_t& v = f.node->value();
+                switch(v.get_type()){
+                case dvalue_t::BOOL:
+                    w.put_u8(v.to<bool>() ? Binary::TagTrue : Binary::TagFalse);
+                    break;
+                case dvalue_t::INT:
+                    w.put_u8(Binary::TagInt);
+                    w.put_raw(v.to<int64_t>());
+                    break;
+                case dvalue_t::FLOATING:
+                    w.put_u8(Binary::TagDouble);
+                    w.put_raw(v.to<double>());
+                    break;
+                case dvalue_t::STRING:
+                    w.put_u8(Binary::TagString);
+                    w.put_string(v.raw_view());
+                    break;
+                }
+                break;
+            }
+            case dadata_t::TObject:
+            case dadata_t::TArray: {
+                bool is_obj = f.node->is_object();
+                w.put_u8(is_obj ? Binary::TagObject : Binary::TagArray);
+                size_t len_pos = out.size();
+                w.put_raw((uint32_t)0);
+                size_t body_start = out.size();
+                stack.push_back({nullptr, {}, false, true, len_pos, body_start});
+
+                if(is_obj){
+                    auto& obj = f.node->object();
+                    w.put_varint(obj.size());
+                    // 倒序入栈,保证写出顺序与迭代顺序一致
+                    size_t base = stack.size();
+                    for(auto proxy : obj){
+                        stack.push_back({&proxy.second(), proxy.first(), true, false, 0, 0});
+                    }
+                    std::reverse(stack.begin() + base, stack.end());
+                }else{
+                    auto& arr = f.node->array();
+                    w.put_varint(arr.size());
+                    for(size_t i = arr.size();i > 0;--i){
+                        stack.push_back({&arr[i - 1], {}, false, false, 0, 0});
+                    }
+                }
+                break;
+            }
+            }
+        }
+    }
+
+    struct BinaryReader{
+        const char* p;
+        const char* end;
+
+        inline bool u8(uint8_t& v){
+            if(p >= end)return false;
+            v = (uint8_t)*p++;
+            return true;
+        }
+
+        template<class T>
+        inline bool raw(T& v){
+            using U = std::conditional_t<sizeof(T) == 8, uint64_t, uint32_t>;
+            if((size_t)(end - p) < sizeof(U))return false;
+            U u;
+            std::memcpy(&u, p, sizeof(u));
+            p += sizeof(u);
+            v = std::bit_cast<T>(to_le(u));
+            return true;
+        }
+
+        inline bool varint(uint64_t& v){
+            v = 0;
+            for(int shift = 0;shift < 64;shift += 7){
+                uint8_t b;
+                if(!u8(b))return false;
+                v |= (uint64_t)(b & 0x7F) << shift;
+                if(!(b & 0x80))return true;
+            }
+            return false;
+        }
+
+        inline bool string(std::string_view& s){
+            uint64_t n;
+            if(!varint(n) || n > (uint64_t)(end - p))return false;
+            s = std::string_view(p, n);
+            p += n;
+            return true;
+        }
+
+        /// 读取容器头,返回body结尾与元素个数
+        inline bool container(uint8_t tag, const char*& body_end, uint64_t& count){
+            uint64_t len;
+            if(tag == Binary::TagObject || tag == Binary::TagArray){
+                uint32_t l;
+                if(!raw(l))return false;
+                len = l;
+            }else if(!raw(len))return false;
+            if(len > (uint64_t)(end - p))return false;
+            body_end = p + len;
+            if(!varint(count))return false;
+            // 每个元素至少一个字节,防止恶意的count导致巨量reserve
+            return count <= (uint64_t)(body_end - p);
+        }
+
+        /// 跳过一个完整的值,容器直接按长度跳过
+        bool skip(){
+            uint8_t tag;
+            if(!u8(tag))return false;
+            switch(tag){
+            case Binary::TagNull:
+            case Binary::TagFalse:
+            case Binary::TagTrue:
+                return true;
+            case Binary::TagInt:
+            case Binary::TagDouble:
+                if(end - p < 8)return false;
+                p += 8;
+                return true;
+            case Binary::TagString: {
+                std::string_view s;
+                return string(s);
+            }
+            case Binary::TagObject:
+            case Binary::TagArray:
+            case Binary::TagObject64:
+            case Binary::TagArray64: {
+                const char* body_end;
+                uint64_t count;
+                if(!container(tag, body_end, count))return false;
+                p = body_end;
+                return true;
+            }
+            default:
+                return false;
+            }
+        }
+    };
+
+    bool parse_value(BinaryReader& r, dadata_t& root, size_t max_depth){
+        struct Frame{
+            dadata_t* node;
+            uint64_t remaining;
+            const char* body_end;
+            bool is_object;
+        };
+        std::vector<Frame> stack;
+
+        auto read_value = [&](dadata_t& node) -> bool {
+            uint8_t tag;
+            if(!r.u8(tag))return false;
+            switch(tag){
+            case Binary::TagNull:
+                node.set_null();
+                return true;
+            case Binary::TagFalse:
+            case Binary::TagTrue:
+                node = (tag == Binary::TagTrue);
+                return true;
+            case Binary::TagInt: {
+                int64_t v;
+                if(!r.raw(v))return false;
+                node = v;
+                return true;
+            }
+            case Binary::TagDouble: {
+                double v;
+                if(!r.raw(v))return false;
+                node = v;
+                return true;
+            }
+            case Binary::TagString: {
+                std::string_view s;
+                if(!r.string(s))return false;
+                node = s;
+                return true;
+            }
+            case Binary::TagObject:
+            case Binary::TagObject64:
+            case Binary::TagArray:
+            case Binary::TagArray64: {
+                const char* body_end;
+                uint64_t count;
+                if(stack.size() >= max_depth || !r.container(tag, body_end, count))return false;
+                bool is_obj = tag == Binary::TagObject || tag == Binary::TagObject64;
+                if(is_obj)node.set<dadata_t::Object>().reserve(count);
+                else node.set<dadata_t::Array>().reserve(count);
+                stack.push_back({&node, count, body_end, is_obj});
+                return true;
+            }
+            default:
+                return false;
+            }
+        };
+
+        if(!read_value(root))return false;
+        while(!stack.empty()){
+            Frame& f = stack.back();
+            if(!f.remaining){
+                if(r.p != f.body_end)return false;
+                stack.pop_back();
+                continue;
+            }
+            --f.remaining;
+
+            dadata_t* node;
+            if(f.is_object){
+                std::string_view key;
+                if(!r.string(key))return false;
+                node = &f.node->object()[key];
+                if(!node->is_null())node->set_null();
+            }else{
+                node = &f.node->array().values.emplace_back(f.node->get_allocator());
+            }
+            // 注意read_value可能push导致f失效,之后不要再使用f
+            if(!read_value(*node))return false;
+        }
+        return true;
+    }
+
+    bool read_header(BinaryReader& r){
+        if((size_t)(r.end - r.p) < Binary::magic.size() + 1)return false;
+        if(std::string_view(r.p, Binary::magic.size()) != Binary::magic)return false;
+        r.p += Binary::magic.size();
+        uint8_t ver;
+        return r.u8(ver) && ver == Binary::version;
+    }
+}
+
+bool Binary::parse(std::string_view data, dadata_t& root){
+    root.set_null();
+    BinaryReader r { data.data(), data.data() + data.size() };
+    if(!read_header(r))return false;
+    return parse_value(r, root, cfg.max_depth) && r.p == r.end;
+}
+
+bool Binary::parse_at(std::string_view data, std::string_view pointer, dadata_t& node){
+    node.set_null();
+    BinaryReader r { data.data(), data.data() + data.size() };
+    if(!read_header(r))return false;
+    if(!pointer.empty() && pointer[0] != '/'){
+        invoke_error(err_locate_error, "Failed to parse pointer which isn't begin with '/'!PATH:{}", pointer);
+        return false;
+    }
+
+    std::string token;
+    while(!pointer.empty()){
+        pointer.remove_prefix(1);
+        size_t next = pointer.find('/');
+        std::string_view raw = pointer.substr(0, next);
+        pointer = next == std::string_view::npos ? std::string_view() : pointer.substr(next);
+
+        token.clear();
+        for(size_t i = 0;i < raw.size();++i){
+            if(raw[i] == '~' && i + 1 < raw.size() && (raw[i + 1] == '0' || raw[i + 1] == '1')){
+                token.push_back(raw[i + 1] == '0' ? '~' : '/');
+                ++i;
+            }else token.push_back(raw[i]);
+        }
+
+        uint8_t tag;
+        if(!r.u8(tag))return false;
+        const char* body_end;
+        uint64_t count;
+        if(tag == TagObject || tag == TagObject64){
+            if(!r.container(tag, body_end, count))return false;
+            bool found = false;
+            for(uint64_t i = 0;i < count;++i){
+                std::string_view key;
+                if(!r.string(key))return false;
+                if(key == token){
+                    found = true;
+                    break;
+                }
+                if(!r.skip())return false;
+            }
+            if(!found)return false;
+        }else if(tag == TagArray || tag == TagArray64){
+            if(!r.container(tag, body_end, count))return false;
+            uint64_t index;
+            auto res = std::from_chars(token.data(), token.data() + token.size(), index);
+            if(res.ec != std::errc() || res.ptr != token.data() + token.size() || index >= count)return false;
+            for(uint64_t i = 0;i < index;++i){
+                if(!r.skip())return false;
+            }
+        }else return false;
+        r.end = body_end;
+    }
+    return parse_value(r, node, cfg.max_depth);
+}
+
+bool Binary::__internal_dump(__dump_fn fn, void* p, const dadata_t& root){
+    // 容器长度要回填,只能整份写完再交出去;缓冲属于这次调用,可以重入,写完就释放
+    std::pmr::string buffer (ALIB5_DEFAULT_MEMORY_RESOURCE);
+    dump_impl(buffer, root);
+    fn(buffer, p);
+    return true;
+}
+
+bool Binary::__internal_dump(std::string& out, const dadata_t& root){
+    dump_impl(out, root);
+    return true;
+}
+
+bool Binary::__internal_dump(std::pmr::string& out, const dadata_t& root){
+    dump_impl(out, root);
+    return true;
+}
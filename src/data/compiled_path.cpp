@@ -0,0 +1,51 @@
+#include <alib5/data/compiled_path.h>
+#include <atomic>
+
+using namespace alib5;
+using namespace alib5::data;
+
+uint64_t alib5::next_layout_stamp(){
+    // 每个线程一次领取一批,避免每次都做原子操作
+    constexpr uint64_t batch = 1 << 16;
+    static std::atomic<uint64_t> global { 1 };
+    thread_local uint64_t next = 0;
+    thread_local uint64_t end = 0;
+    if(next == end){
+        next = global.fetch_add(batch, std::memory_order_relaxed);
+        end = next + batch;
+    }
+    return next++;
+}
+
+CompiledPath::CompiledPath(std::string_view pointer, bool invoke_err, std::pmr::memory_resource* __a)
+: source(pointer, __a), steps(__a), cache(__a) {
+    if(!pointer.empty() && pointer[0] != '/'){
+        if(invoke_err)invoke_error(err_locate_error, "Failed to parse pointer which isn't begin with '/'!PATH:{}", pointer);
+        return;
+    }
+
+    while(!pointer.empty()){
+        pointer.remove_prefix(1);
+        size_t next = pointer.find('/');
+        std::string_view raw = pointer.substr(0, next);
+        pointer = next == std::string_view::npos ? std::string_view() : pointer.substr(next);
+
+        Step& s = steps.emplace_back(Step{std::pmr::string(__a), 0, false, 0});
+        for(size_t i = 0;i < raw.size();++i){
+            if(raw[i] == '~' && i + 1 < raw.size() && (raw[i + 1] == '0' || raw[i + 1] == '1')){
+                s.key.push_back(raw[i + 1] == '0' ? '~' : '/');
+                ++i;
+            }else s.key.push_back(raw[i]);
+        }
+        s.hash = dobject_t::hash_key(s.key);
+
+        auto res = std::from_chars(raw.data(), raw.data() + raw.size(), s.index);
+        s.has_index = !raw.empty() && res.ec == std::errc() && res.ptr == raw.data() + raw.size();
+    }
+    cache.resize(steps.size(), Cache{0, 0});
+    ok = true;
+}
+
+void CompiledPath::reset_cache() const {
+    for(auto& c : cache)c = Cache{0, 0};
+}
@@ -0,0 +1,923 @@
+#include <alib5/adata.h>
+#include <alib5/data/data_fastjson.h>
+#include <alib5/data/data_text.h>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <charconv>
+#include <limits>
+#include <atomic>
+#include <thread>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define ALIB5_FASTJSON_X86 1
+#include <immintrin.h>
+#else
+#define ALIB5_FASTJSON_X86 0
+#endif
+
+using namespace alib5;
+using namespace alib5::data;
+
+namespace {
+    /// 一个64字节块内各类字符的位图
+    struct BlockMasks{
+        uint64_t backslash;
+        uint64_t quote;
+        uint64_t op;
+        uint64_t ws;
+    };
+
+    using ClassifyFn = void(const char*, BlockMasks&);
+
+    enum CharClass : uint8_t {
+        CBackslash = 1,
+        CQuote = 2,
+        COp = 4,
+        CWs = 8
+    };
+
+    constexpr auto char_classes = []{
+        std::array<uint8_t,256> t {};
+        t[(uint8_t)'\\'] = CBackslash;
+        t[(uint8_t)'"'] = CQuote;
+        for(char c : std::string_view("{}[]:,"))t[(uint8_t)c] = COp;
+        for(char c : std::string_view(" \t\n\r"))t[(uint8_t)c] = CWs;
+        return t;
+    }();
+
+    void classify_scalar(const char* p, BlockMasks& m){
+        m = {};
+        for(int i = 0;i < 64;++i){
+            uint8_t c = char_classes[(uint8_t)p[i]];
+            uint64_t bit = uint64_t(1) << i;
+            if(c & CBackslash)m.backslash |= bit;
+            if(c & CQuote)m.quote |= bit;
+            if(c & COp)m.op |= bit;
+            if(c & CWs)m.ws |= bit;
+        }
+    }
+
+#if ALIB5_FASTJSON_X86
+    // lambda不会继承target属性,所以这里都写成函数
+    __attribute__((target("avx2")))
+    inline __m256i avx2_eq(__m256i v, char c){ return _mm256_cmpeq_epi8(v, _mm256_set1_epi8(c)); }
+
+    __attribute__((target("avx2")))
+    inline uint64_t avx2_bits(__m256i lo, __m256i hi){
+        return (uint64_t)(uint32_t)_mm256_movemask_epi8(lo) | ((uint64_t)(uint32_t)_mm256_movemask_epi8(hi) << 32);
+    }
+
+    // '[' 0x5b / ']' 0x5d 或上0x20 之后正好是 '{' / '}',省两次比较
+    __attribute__((target("avx2")))
+    inline __m256i avx2_op(__m256i v){
+        const __m256i vc = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+        return _mm256_or_si256(
+            _mm256_or_si256(avx2_eq(vc, '{'), avx2_eq(vc, '}')),
+            _mm256_or_si256(avx2_eq(v, ':'), avx2_eq(v, ','))
+        );
+    }
+
+    __attribute__((target("avx2")))
+    inline __m256i avx2_ws(__m256i v){
+        return _mm256_or_si256(
+            _mm256_or_si256(avx2_eq(v, ' '), avx2_eq(v, '\t')),
+            _mm256_or_si256(avx2_eq(v, '\n'), avx2_eq(v, '\r'))
+        );
+    }
+
+    __attribute__((target("avx2")))
+    void classify_avx2(const char* p, BlockMasks& m){
+        const __m256i lo = _mm256_loadu_si256((const __m256i*)p);
+        const __m256i hi = _mm256_loadu_si256((const __m256i*)(p + 32));
+        m.backslash = avx2_bits(avx2_eq(lo, '\\'), avx2_eq(hi, '\\'));
+        m.quote = avx2_bits(avx2_eq(lo, '"'), avx2_eq(hi, '"'));
+        m.op = avx2_bits(avx2_op(lo), avx2_op(hi));
+        m.ws = avx2_bits(avx2_ws(lo), avx2_ws(hi));
+    }
+
+    __attribute__((target("sse2")))
+    inline __m128i sse2_eq(__m128i v, char c){ return _mm_cmpeq_epi8(v, _mm_set1_epi8(c)); }
+
+    __attribute__((target("sse2")))
+    inline uint64_t sse2_bits(__m128i r, int shift){
+        return (uint64_t)(uint16_t)_mm_movemask_epi8(r) << shift;
+    }
+
+    __attribute__((target("sse2")))
+    void classify_sse2(const char* p, BlockMasks& m){
+        m = {};
+        for(int i = 0;i < 4;++i){
+            const __m128i v = _mm_loadu_si128((const __m128i*)(p + i * 16));
+            const __m128i vc = _mm_or_si128(v, _mm_set1_epi8(0x20));
+            const int shift = i * 16;
+            m.backslash |= sse2_bits(sse2_eq(v, '\\'), shift);
+            m.quote |= sse2_bits(sse2_eq(v, '"'), shift);
+            m.op |= sse2_bits(_mm_or_si128(
+                _mm_or_si128(sse2_eq(vc, '{'), sse2_eq(vc, '}')),
+                _mm_or_si128(sse2_eq(v, ':'), sse2_eq(v, ','))
+            ), shift);
+            m.ws |= sse2_bits(_mm_or_si128(
+                _mm_or_si128(sse2_eq(v, ' '), sse2_eq(v, '\t')),
+                _mm_or_si128(sse2_eq(v, '\n'), sse2_eq(v, '\r'))
+            ), shift);
+        }
+    }
+#endif
+
+    struct Kernel{
+        ClassifyFn* fn;
+        std::string_view name;
+    };
+
+    const Kernel& pick_kernel(){
+        static const Kernel kernel = []() -> Kernel {
+#if ALIB5_FASTJSON_X86
+            __builtin_cpu_init();
+            if(__builtin_cpu_supports("avx2"))return {classify_avx2, "avx2"};
+            if(__builtin_cpu_supports("sse2"))return {classify_sse2, "sse2"};
+#endif
+            return {classify_scalar, "scalar"};
+        }();
+        return kernel;
+    }
+
+    inline bool add_overflow(uint64_t a, uint64_t b, uint64_t* out){
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_add_overflow(a, b, out);
+#else
+        *out = a + b;
+        return *out < a;
+#endif
+    }
+
+    /// 被反斜杠转义的字符位图,奇数长度的反斜杠序列会转义下一个字符
+    inline uint64_t find_escaped(uint64_t backslash, uint64_t& prev_escaped){
+        constexpr uint64_t even_bits = 0x5555555555555555ULL;
+        backslash &= ~prev_escaped;
+        uint64_t follows_escape = (backslash << 1) | prev_escaped;
+        uint64_t odd_sequence_starts = backslash & ~even_bits & ~follows_escape;
+        uint64_t sequences_starting_on_even_bits;
+        prev_escaped = add_overflow(odd_sequence_starts, backslash, &sequences_starting_on_even_bits);
+        uint64_t invert_mask = sequences_starting_on_even_bits << 1;
+        return (even_bits ^ invert_mask) & follows_escape;
+    }
+
+    /// 前缀异或,得到字符串内部(包括开引号,不包括闭引号)的位图
+    inline uint64_t prefix_xor(uint64_t x){
+        x ^= x << 1;
+        x ^= x << 2;
+        x ^= x << 4;
+        x ^= x << 8;
+        x ^= x << 16;
+        x ^= x << 32;
+        return x;
+    }
+
+    // ---------------------------------------------------------
+    // Stage 2
+    // ---------------------------------------------------------
+
+    constexpr auto delimiters = []{
+        std::array<bool,256> t {};
+        for(char c : std::string_view("{}[]:, \t\n\r"))t[(uint8_t)c] = true;
+        return t;
+    }();
+
+    inline bool read_hex4(std::string_view src, size_t pos, uint32_t& out){
+        if(pos + 4 > src.size())return false;
+        out = 0;
+        for(size_t i = 0;i < 4;++i){
+            int h = detail::text_hex_value(src[pos + i]);
+            if(h < 0)return false;
+            out = (out << 4) | (uint32_t)h;
+        }
+        return true;
+    }
+
+    /// pos指向开引号,没有转义时直接返回原文的view,否则反转义进scratch
+    bool read_string(std::string_view src, size_t pos, std::string_view& out, std::string& scratch){
+        size_t i = pos + 1;
+        const size_t n = src.size();
+        while(i < n){
+            char c = src[i];
+            if(c == '"'){
+                out = src.substr(pos + 1, i - pos - 1);
+                return true;
+            }
+            if(c == '\\')break;
+            if((uint8_t)c < 0x20)return false;
+            ++i;
+        }
+        if(i >= n)return false;
+
+        scratch.assign(src.data() + pos + 1, i - pos - 1);
+        while(i < n){
+            char c = src[i];
+            if(c == '"'){
+                out = scratch;
+                return true;
+            }
+            if((uint8_t)c < 0x20)return false;
+            if(c != '\\'){
+                scratch.push_back(c);
+                ++i;
+                continue;
+            }
+            if(i + 1 >= n)return false;
+            char e = src[i + 1];
+            i += 2;
+            switch(e){
+            case '"': scratch.push_back('"'); break;
+            case '\\': scratch.push_back('\\'); break;
+            case '/': scratch.push_back('/'); break;
+            case 'b': scratch.push_back('\b'); break;
+            case 'f': scratch.push_back('\f'); break;
+            case 'n': scratch.push_back('\n'); break;
+            case 'r': scratch.push_back('\r'); break;
+            case 't': scratch.push_back('\t'); break;
+            case 'u': {
+                uint32_t cp;
+                if(!read_hex4(src, i, cp))return false;
+                i += 4;
+                if(cp >= 0xD800 && cp <= 0xDBFF){
+                    uint32_t low;
+                    if(i + 1 >= n || src[i] != '\\' || src[i + 1] != 'u')return false;
+                    if(!read_hex4(src, i + 2, low) || low < 0xDC00 || low > 0xDFFF)return false;
+                    i += 6;
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                }else if(cp >= 0xDC00 && cp <= 0xDFFF){
+                    return false;
+                }
+                detail::text_append_utf8(scratch, cp);
+                break;
+            }
+            default:
+                return false;
+            }
+        }
+        return false;
+    }
+
+    /// -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+    bool check_number(std::string_view tok, bool& is_float){
+        size_t i = 0;
+        const size_t n = tok.size();
+        auto digits = [&]{
+            size_t b = i;
+            while(i < n && tok[i] >= '0' && tok[i] <= '9')++i;
+            return i - b;
+        };
+        is_float = false;
+        if(i < n && tok[i] == '-')++i;
+        if(i >= n)return false;
+        if(tok[i] == '0')++i;
+        else if(!digits())return false;
+        if(i < n && tok[i] == '.'){
+            ++i;
+            is_float = true;
+            if(!digits())return false;
+        }
+        if(i < n && (tok[i] == 'e' || tok[i] == 'E')){
+            ++i;
+            is_float = true;
+            if(i < n && (tok[i] == '+' || tok[i] == '-'))++i;
+            if(!digits())return false;
+        }
+        return i == n;
+    }
+
+    bool read_primitive(std::string_view src, size_t pos, AData& node){
+        size_t end = pos;
+        while(end < src.size() && !delimiters[(uint8_t)src[end]])++end;
+        std::string_view tok = src.substr(pos, end - pos);
+
+        switch(tok[0]){
+        case 't':
+            if(tok != "true")return false;
+            node = true;
+            return true;
+        case 'f':
+            if(tok != "false")return false;
+            node = false;
+            return true;
+        case 'n':
+            if(tok != "null")return false;
+            node.set<std::monostate>();
+            return true;
+        default:
+            break;
+        }
+
+        bool is_float;
+        if(!check_number(tok, is_float))return false;
+        const char* b = tok.data();
+        const char* e = tok.data() + tok.size();
+        if(!is_float){
+            int64_t i;
+            auto res = std::from_chars(b, e, i);
+            if(res.ec == std::errc()){
+                node = i;
+                return true;
+            }
+            // 与rapidjson的Uint64行为保持一致
+            if(tok[0] != '-'){
+                uint64_t u;
+                res = std::from_chars(b, e, u);
+                if(res.ec == std::errc()){
+                    node = (int64_t)u;
+                    return true;
+                }
+            }
+        }
+        double d;
+        auto res = std::from_chars(b, e, d);
+        if(res.ec != std::errc() || !std::isfinite(d))return false;
+        node = d;
+        return true;
+    }
+
+    bool build_tree(std::string_view src, std::span<const uint32_t> index, AData& root){
+        enum State {
+            Value,
+            ValueOrClose,
+            Key,
+            KeyOrClose,
+            Colon,
+            CommaOrClose,
+            Done
+        };
+
+        static thread_local std::string value_scratch;
+        static thread_local std::string key_scratch;
+        std::vector<AData*> stack;
+        std::string_view key;
+        State state = Value;
+
+        auto close = [&](char c) -> bool {
+            AData* top = stack.back();
+            if(c == '}' ? !top->is_object() : !top->is_array())return false;
+            stack.pop_back();
+            state = stack.empty() ? Done : CommaOrClose;
+            return true;
+        };
+
+        for(uint32_t pos : index){
+            const char c = src[pos];
+            switch(state){
+            case ValueOrClose:
+                if(c == ']'){
+                    if(!close(c))return false;
+                    break;
+                }
+                [[fallthrough]];
+            case Value: {
+                AData* node = &root;
+                if(!stack.empty()){
+                    AData& top = *stack.back();
+                    if(top.is_object()){
+                        node = &top.object()[key];
+                        // 重复的key以后出现的为准
+                        if(!node->is_null())node->set_null();
+                    }else node = &top.array().values.emplace_back(top.get_allocator());
+                }
+
+                if(c == '{'){
+                    node->set<AData::Object>();
+                    stack.push_back(node);
+                    state = KeyOrClose;
+                    break;
+                }else if(c == '['){
+                    node->set<AData::Array>();
+                    stack.push_back(node);
+                    state = ValueOrClose;
+                    break;
+                }else if(c == '"'){
+                    std::string_view s;
+                    if(!read_string(src, pos, s, value_scratch))return false;
+                    *node = s;
+                }else if(delimiters[(uint8_t)c] || !read_primitive(src, pos, *node)){
+                    return false;
+                }
+                state = stack.empty() ? Done : CommaOrClose;
+                break;
+            }
+            case KeyOrClose:
+                if(c == '}'){
+                    if(!close(c))return false;
+                    break;
+                }
+                [[fallthrough]];
+            case Key:
+                if(c != '"' || !read_string(src, pos, key, key_scratch))return false;
+                state = Colon;
+                break;
+            case Colon:
+                if(c != ':')return false;
+                state = Value;
+                break;
+            case CommaOrClose:
+                if(c == ','){
+                    state = stack.back()->is_object() ? Key : Value;
+                }else if(c == '}' || c == ']'){
+                    if(!close(c))return false;
+                }else return false;
+                break;
+            case Done:
+                return false;
+            }
+        }
+        return state == Done;
+    }
+
+    /// 不转换数值,只检查是否能被read_primitive接受
+    bool check_primitive(std::string_view src, size_t pos){
+        size_t end = pos;
+        while(end < src.size() && !delimiters[(uint8_t)src[end]])++end;
+        std::string_view tok = src.substr(pos, end - pos);
+        if(tok == "true" || tok == "false" || tok == "null")return true;
+
+        bool is_float;
+        if(!check_number(tok, is_float))return false;
+        if(!is_float)return true;
+        double d;
+        auto res = std::from_chars(tok.data(), tok.data() + tok.size(), d);
+        return res.ec == std::errc() && std::isfinite(d);
+    }
+
+    /// 与build_tree相同的语法检查,但不构建节点,只为每个开括号记录对应闭括号在index中的位置
+    bool index_structure(std::string_view src, std::span<const uint32_t> index, std::vector<uint32_t>& jumps){
+        enum State {
+            Value,
+            ValueOrClose,
+            Key,
+            KeyOrClose,
+            Colon,
+            CommaOrClose,
+            Done
+        };
+
+        static thread_local std::string scratch;
+        std::vector<uint32_t> stack;
+        State state = Value;
+        jumps.assign(index.size(), 0);
+
+        auto close = [&](uint32_t i, char c) -> bool {
+            if(src[index[stack.back()]] != (c == '}' ? '{' : '['))return false;
+            jumps[stack.back()] = i;
+            stack.pop_back();
+            state = stack.empty() ? Done : CommaOrClose;
+            return true;
+        };
+
+        for(uint32_t i = 0;i < index.size();++i){
+            const uint32_t pos = index[i];
+            const char c = src[pos];
+            switch(state){
+            case ValueOrClose:
+                if(c == ']'){
+                    if(!close(i, c))return false;
+                    break;
+                }
+                [[fallthrough]];
+            case Value:
+                if(c == '{' || c == '['){
+                    stack.push_back(i);
+                    state = c == '{' ? KeyOrClose : ValueOrClose;
+                    break;
+                }else if(c == '"'){
+                    std::string_view s;
+                    if(!read_string(src, pos, s, scratch))return false;
+                }else if(delimiters[(uint8_t)c] || !check_primitive(src, pos)){
+                    return false;
+                }
+                state = stack.empty() ? Done : CommaOrClose;
+                break;
+            case KeyOrClose:
+                if(c == '}'){
+                    if(!close(i, c))return false;
+                    break;
+                }
+                [[fallthrough]];
+            case Key: {
+                std::string_view s;
+                if(c != '"' || !read_string(src, pos, s, scratch))return false;
+                state = Colon;
+                break;
+            }
+            case Colon:
+                if(c != ':')return false;
+                state = Value;
+                break;
+            case CommaOrClose:
+                if(c == ','){
+                    state = src[index[stack.back()]] == '{' ? Key : Value;
+                }else if(c == '}' || c == ']'){
+                    if(!close(i, c))return false;
+                }else return false;
+                break;
+            case Done:
+                return false;
+            }
+        }
+        return state == Done;
+    }
+}
+
+namespace {
+    /// 第一阶段扫描器跨块携带的状态,分块并行扫描时由调用者给出每块的初始值
+    struct ScanState{
+        uint64_t escaped;
+        uint64_t in_string;
+        uint64_t scalar;
+    };
+
+    /// 扫描data,把结构字符的位置加上offset追加到out
+    bool scan_structural(std::string_view data, uint32_t offset, ScanState st, std::vector<uint32_t>& out){
+        ClassifyFn* classify = pick_kernel().fn;
+        uint64_t prev_escaped = st.escaped;
+        uint64_t prev_in_string = st.in_string;
+        uint64_t prev_scalar = st.scalar;
+        alignas(64) char tail[64];
+
+        const char* p = data.data();
+        const size_t n = data.size();
+        for(size_t base = 0;base < n;base += 64){
+            const char* block = p + base;
+            if(n - base < 64){
+                std::memset(tail, ' ', sizeof(tail));
+                std::memcpy(tail, block, n - base);
+                block = tail;
+            }
+
+            BlockMasks m;
+            classify(block, m);
+
+            uint64_t escaped = find_escaped(m.backslash, prev_escaped);
+            uint64_t quote = m.quote & ~escaped;
+            uint64_t in_string = prefix_xor(quote) ^ prev_in_string;
+            prev_in_string = (uint64_t)((int64_t)in_string >> 63);
+
+            uint64_t scalar = ~(m.op | m.ws);
+            uint64_t nonquote_scalar = scalar & ~quote;
+            uint64_t follows_scalar = (nonquote_scalar << 1) | prev_scalar;
+            prev_scalar = nonquote_scalar >> 63;
+
+            // 字符串内部(包括闭引号)的一切都不是结构字符
+            uint64_t string_tail = in_string ^ quote;
+            uint64_t structural = (m.op | (scalar & ~follows_scalar)) & ~string_tail;
+
+            while(structural){
+                out.push_back(offset + (uint32_t)(base + std::countr_zero(structural)));
+                structural &= structural - 1;
+            }
+        }
+        return prev_in_string == 0;
+    }
+}
+
+bool alib5::detail::fastjson_structural_index(std::string_view data, std::vector<uint32_t>& out){
+    out.clear();
+    // 经验值,大多数json大约每4~8个字节一个结构字符
+    out.reserve(data.size() / 4 + 8);
+    return scan_structural(data, 0, ScanState{0, 0, 0}, out);
+}
+
+std::string_view alib5::detail::fastjson_kernel_name(){
+    return pick_kernel().name;
+}
+
+bool FastJSON::parse(std::string_view data, dadata_t& root){
+    if(cfg.allow_comments || data.size() >= std::numeric_limits<uint32_t>::max()){
+        return JSON(cfg).parse(data, root);
+    }
+    root.set<std::monostate>();
+
+    static thread_local std::vector<uint32_t> index;
+    if(!detail::fastjson_structural_index(data, index))return false;
+    return build_tree(data, index, root);
+}
+
+LazyJSONDocument::LazyJSONDocument(std::pmr::memory_resource* __a)
+: text(__a), root(__a) {}
+
+void LazyJSONDocument::clear(){
+    root.set_null();
+    text.clear();
+    index.clear();
+    jumps.clear();
+}
+
+void LazyJSONDocument::materialize(LazyNode node, void* target) const {
+    // 文本与结构都已经在parse_lazy中校验过,这里不会失败
+    static thread_local std::string value_scratch;
+    static thread_local std::string key_scratch;
+    dadata_t& self = *static_cast<dadata_t*>(target);
+    std::string_view src = text;
+    uint32_t i = node.position + 1;
+    const uint32_t close = jumps[node.position];
+
+    auto read_value = [&](dadata_t& child) {
+        const uint32_t pos = index[i];
+        const char c = src[pos];
+        if(c == '{' || c == '['){
+            child.set_lazy(LazyNode{this, i, c == '{'});
+            i = jumps[i] + 1;
+            return;
+        }
+        if(c == '"'){
+            std::string_view s;
+            read_string(src, pos, s, value_scratch);
+            child = s;
+        }else read_primitive(src, pos, child);
+        ++i;
+    };
+
+    if(node.is_object){
+        auto& obj = self.set<dadata_t::Object>();
+        while(i < close){
+            std::string_view key;
+            read_string(src, index[i], key, key_scratch);
+            i += 2;
+            dadata_t* child = &obj[key];
+            if(!child->is_null())child->set_null();
+            read_value(*child);
+            // 跳过逗号
+            if(i < close)++i;
+        }
+    }else{
+        auto& arr = self.set<dadata_t::Array>();
+        while(i < close){
+            read_value(arr.values.emplace_back(self.get_allocator()));
+            if(i < close)++i;
+        }
+    }
+}
+
+bool FastJSON::parse_lazy(std::pmr::string&& data, LazyJSONDocument& doc){
+    doc.clear();
+    doc.text = std::move(data);
+    if(cfg.allow_comments || doc.text.size() >= std::numeric_limits<uint32_t>::max()){
+        return JSON(cfg).parse(doc.text, doc.root);
+    }
+    std::string_view src = doc.text;
+    if(!detail::fastjson_structural_index(src, doc.index))return false;
+    if(!index_structure(src, doc.index, doc.jumps)){
+        doc.clear();
+        return false;
+    }
+
+    const char c = src[doc.index[0]];
+    if(c == '{' || c == '['){
+        doc.root.set_lazy(LazyNode{&doc, 0, c == '{'});
+    }else if(c == '"'){
+        std::string scratch;
+        std::string_view s;
+        read_string(src, doc.index[0], s, scratch);
+        doc.root = s;
+    }else read_primitive(src, doc.index[0], doc.root);
+    return true;
+}
+
+namespace {
+    // ---------------------------------------------------------
+    // Parallel ingestion
+    // ---------------------------------------------------------
+
+    /// 在workers个线程上运行fn(worker),0号在调用线程上执行
+    template<class Fn>
+    void run_workers(size_t workers, Fn&& fn){
+        std::vector<std::jthread> threads;
+        threads.reserve(workers - 1);
+        for(size_t w = 1;w < workers;++w){
+            threads.emplace_back([&fn, w]{ fn(w); });
+        }
+        fn(0);
+    }
+
+    /// data[pos]是否被前面奇数个连续的反斜杠转义
+    bool escaped_at(std::string_view data, size_t pos){
+        size_t n = 0;
+        while(n < pos && data[pos - n - 1] == '\\')++n;
+        return n & 1;
+    }
+
+    /// [b, e)中未被转义的引号个数是否为奇数
+    bool odd_quotes(std::string_view data, size_t b, size_t e){
+        bool odd = false;
+        bool esc = escaped_at(data, b);
+        for(size_t i = b;i < e;++i){
+            const char c = data[i];
+            if(esc){
+                esc = false;
+                continue;
+            }
+            if(c == '\\')esc = true;
+            else if(c == '"')odd = !odd;
+        }
+        return odd;
+    }
+
+    /// 按输入大小决定线程数,每个线程至少分到conf_parallel_parse_chunk字节
+    size_t pick_workers(size_t bytes, size_t threads){
+        if(!threads)threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+        return std::clamp<size_t>(bytes / conf_parallel_parse_chunk, 1, threads);
+    }
+
+    /// 分块并行建立整个文本的结构索引
+    bool parallel_structural_index(std::string_view data, size_t workers, std::vector<uint32_t>& index){
+        const size_t n = data.size();
+        std::vector<size_t> bounds(workers + 1);
+        for(size_t w = 0;w <= workers;++w)bounds[w] = n * w / workers;
+
+        // 先统计每块的引号奇偶,得到每块开头是否处于字符串中
+        std::vector<char> odd(workers);
+        run_workers(workers, [&](size_t w){
+            odd[w] = odd_quotes(data, bounds[w], bounds[w + 1]);
+        });
+        std::vector<ScanState> states(workers);
+        bool in_string = false;
+        for(size_t w = 0;w < workers;++w){
+            const size_t b = bounds[w];
+            const uint8_t before = b ? (uint8_t)data[b - 1] : ' ';
+            states[w] = ScanState{
+                escaped_at(data, b) ? 1ULL : 0ULL,
+                in_string ? ~0ULL : 0ULL,
+                (char_classes[before] & (COp | CWs | CQuote)) ? 0ULL : 1ULL
+            };
+            in_string ^= (bool)odd[w];
+        }
+        if(in_string)return false;
+
+        std::vector<std::vector<uint32_t>> parts(workers);
+        run_workers(workers, [&](size_t w){
+            auto& part = parts[w];
+            part.reserve((bounds[w + 1] - bounds[w]) / 4 + 8);
+            scan_structural(data.substr(bounds[w], bounds[w + 1] - bounds[w]), (uint32_t)bounds[w], states[w], part);
+        });
+
+        size_t total = 0;
+        for(auto& part : parts)total += part.size();
+        index.clear();
+        index.reserve(total);
+        for(auto& part : parts){
+            index.insert(index.end(), part.begin(), part.end());
+            std::vector<uint32_t>().swap(part);
+        }
+        return true;
+    }
+
+    /// 找出顶层数组的元素分隔位置:seps[0]为开括号,之后是每个顶层逗号,最后是闭括号
+    bool split_top_level(std::string_view src, std::span<const uint32_t> index, size_t workers, std::vector<uint32_t>& seps){
+        if(index.size() < 2 || src[index.front()] != '[' || src[index.back()] != ']')return false;
+        const size_t last = index.size() - 1;
+        std::vector<size_t> bounds(workers + 1);
+        for(size_t w = 0;w <= workers;++w)bounds[w] = 1 + (last - 1) * w / workers;
+
+        auto delta = [&](char c) -> ptrdiff_t {
+            if(c == '{' || c == '[')return 1;
+            if(c == '}' || c == ']')return -1;
+            return 0;
+        };
+
+        std::vector<ptrdiff_t> depth(workers + 1, 0);
+        run_workers(workers, [&](size_t w){
+            ptrdiff_t d = 0;
+            for(size_t i = bounds[w];i < bounds[w + 1];++i)d += delta(src[index[i]]);
+            depth[w + 1] = d;
+        });
+        for(size_t w = 0;w < workers;++w)depth[w + 1] += depth[w];
+        if(depth[workers] != 0)return false;
+
+        std::vector<std::vector<uint32_t>> parts(workers);
+        std::atomic<bool> ok { true };
+        run_workers(workers, [&](size_t w){
+            ptrdiff_t d = depth[w];
+            for(size_t i = bounds[w];i < bounds[w + 1];++i){
+                const char c = src[index[i]];
+                if(c == ',' && d == 0)parts[w].push_back((uint32_t)i);
+                d += delta(c);
+                // 深度回到负数说明外层数组提前闭合了
+                if(d < 0){
+                    ok.store(false, std::memory_order_relaxed);
+                    return;
+                }
+            }
+        });
+        if(!ok)return false;
+
+        seps.clear();
+        seps.push_back(0);
+        for(auto& part : parts)seps.insert(seps.end(), part.begin(), part.end());
+        seps.push_back((uint32_t)last);
+        return true;
+    }
+
+    /// 一段连续记录的解析结果,元素使用解析它的线程的arena
+    using RecordBatch = std::vector<dadata_t>;
+
+    template<class ParseGroup>
+    bool parse_groups(dadata_t& root, std::pmr::memory_resource* upstream,
+                      size_t workers, size_t groups, size_t arena_hint,
+                      std::vector<std::unique_ptr<std::pmr::monotonic_buffer_resource>>& arenas,
+                      ParseGroup&& parse_group){
+        arenas.clear();
+        for(size_t w = 0;w < workers;++w){
+            arenas.push_back(std::make_unique<std::pmr::monotonic_buffer_resource>(arena_hint, upstream));
+        }
+
+        std::vector<RecordBatch> batches(groups);
+        std::atomic<size_t> next { 0 };
+        std::atomic<bool> ok { true };
+        run_workers(workers, [&](size_t w){
+            std::pmr::memory_resource* arena = arenas[w].get();
+            for(size_t g;(g = next.fetch_add(1, std::memory_order_relaxed)) < groups;){
+                if(!ok.load(std::memory_order_relaxed))return;
+                if(!parse_group(g, batches[g], arena)){
+                    ok.store(false, std::memory_order_relaxed);
+                    return;
+                }
+            }
+        });
+        if(!ok)return false;
+
+        // 按输入顺序拼接,移动不会改变元素所属的arena
+        size_t total = 0;
+        for(auto& b : batches)total += b.size();
+        auto& arr = root.set<dadata_t::Array>();
+        arr.reserve(total);
+        for(auto& b : batches){
+            for(auto& v : b)arr.values.emplace_back(std::move(v));
+            RecordBatch().swap(b);
+        }
+        return true;
+    }
+}
+
+bool FastJSON::parse_parallel(std::string_view data, ParallelJSONDocument& doc, ParallelInput input, size_t threads){
+    doc.clear();
+    const size_t workers = pick_workers(data.size(), threads);
+    // 多分几组,让快的线程多干一些
+    const size_t groups = workers == 1 ? 1 : workers * 4;
+    const size_t arena_hint = std::max<size_t>(data.size() / workers, 4096);
+
+    bool ok;
+    if(input == Lines){
+        std::vector<size_t> bounds { 0 };
+        for(size_t g = 1;g < groups;++g){
+            size_t pos = data.find('\n', std::max(data.size() * g / groups, bounds.back()));
+            pos = pos == std::string_view::npos ? data.size() : pos + 1;
+            if(pos > bounds.back() && pos < data.size())bounds.push_back(pos);
+        }
+        bounds.push_back(data.size());
+
+        ok = parse_groups(doc.root, doc.upstream, workers, bounds.size() - 1, arena_hint, doc.arenas,
+            [&](size_t g, RecordBatch& out, std::pmr::memory_resource* arena){
+                static thread_local std::vector<uint32_t> index;
+                std::string_view chunk = data.substr(bounds[g], bounds[g + 1] - bounds[g]);
+                while(!chunk.empty()){
+                    size_t eol = chunk.find('\n');
+                    std::string_view line = chunk.substr(0, eol);
+                    chunk = eol == std::string_view::npos ? std::string_view() : chunk.substr(eol + 1);
+
+                    if(cfg.allow_comments || line.size() >= std::numeric_limits<uint32_t>::max()){
+                        if(line.find_first_not_of(" \t\r") == std::string_view::npos)continue;
+                        if(!JSON(cfg).parse(line, out.emplace_back(arena)))return false;
+                        continue;
+                    }
+                    if(!detail::fastjson_structural_index(line, index))return false;
+                    // 空行
+                    if(index.empty())continue;
+                    if(!build_tree(line, index, out.emplace_back(arena)))return false;
+                }
+                return true;
+            });
+    }else{
+        if(cfg.allow_comments || data.size() >= std::numeric_limits<uint32_t>::max()){
+            return JSON(cfg).parse(data, doc.root);
+        }
+        std::vector<uint32_t> index;
+        std::vector<uint32_t> seps;
+        if(!parallel_structural_index(data, workers, index) || !split_top_level(data, index, workers, seps)){
+            doc.clear();
+            return false;
+        }
+        // "[]"没有元素,其他情况下每两个分隔之间都必须有一个值
+        const size_t count = (seps.size() == 2 && seps[1] == 1) ? 0 : seps.size() - 1;
+        const size_t used_groups = std::min(groups, std::max<size_t>(count, 1));
+
+        ok = parse_groups(doc.root, doc.upstream, workers, used_groups, arena_hint, doc.arenas,
+            [&](size_t g, RecordBatch& out, std::pmr::memory_resource* arena){
+                const size_t b = count * g / used_groups;
+                const size_t e = count * (g + 1) / used_groups;
+                out.reserve(e - b);
+                for(size_t k = b;k < e;++k){
+                    std::span<const uint32_t> element(index.data() + seps[k] + 1, seps[k + 1] - seps[k] - 1);
+                    if(!build_tree(data, element, out.emplace_back(arena)))return false;
+                }
+                return true;
+            });
+    }
+    if(!ok)doc.clear();
+    return ok;
+}
@@ -0,0 +1,488 @@
+#include <alib5/adata.h>
+#include <alib5/data/frozen.h>
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <unordered_map>
+#include <utility>
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+using namespace alib5;
+using namespace alib5::data;
+using namespace alib5::data::frozen;
+
+namespace {
+    struct FrozenWriter{
+        std::pmr::string& out;
+        size_t start;
+        std::string blob;
+        /// 相同字符串(尤其是键)只写一份
+        std::unordered_map<std::string_view, uint64_t> interned;
+
+        uint64_t intern(std::string_view s){
+            auto it = interned.find(s);
+            if(it != interned.end())return it->second;
+            uint64_t off = blob.size();
+            blob.append(s);
+            interned.emplace(s, off);
+            return off;
+        }
+
+        /// 在末尾分配n字节(内容清零),返回相对镜像起点的偏移;分配的大小都是16的倍数,偏移也就保持16字节对齐
+        uint64_t alloc(size_t n){
+            uint64_t off = out.size() - start;
+            out.append(n, '\0');
+            return off;
+        }
+
+        template<class T>
+        void store(uint64_t off, const T& v){
+            std::memcpy(out.data() + start + off, &v, sizeof(T));
+        }
+    };
+
+    struct KeyEntry{
+        uint32_t hash;
+        std::string_view key;
+        const dadata_t* node;
+    };
+}
+
+dtype_t FrozenView::get_type() const {
+    if(!node)return dadata_t::TNull;
+    switch(node->type){
+    case FObject: return dadata_t::TObject;
+    case FArray: return dadata_t::TArray;
+    case FNull: return dadata_t::TNull;
+    default: return dadata_t::TValue;
+    }
+}
+
+dvalue_type_t FrozenView::value_type() const {
+    switch(node ? node->type : FNull){
+    case FBool: return dvalue_t::BOOL;
+    case FInt: return dvalue_t::INT;
+    case FDouble: return dvalue_t::FLOATING;
+    default: return dvalue_t::STRING;
+    }
+}
+
+FrozenView FrozenView::at_ptr(std::string_view key) const {
+    if(!node || node->type != FObject)return {};
+    uint32_t h = hash_key(key);
+    const KeyRef* beg = keys();
+    const KeyRef* end = beg + node->count;
+    const KeyRef* it = std::lower_bound(beg, end, h, [](const KeyRef& k, uint32_t v){
+        return k.hash < v;
+    });
+    const char* b = blob();
+    for(;it != end && it->hash == h;++it){
+        if(std::string_view(b + it->offset, it->length) == key){
+            return child_at(it - beg);
+        }
+    }
+    return {};
+}
+
+FrozenView FrozenView::at_ptr(std::ptrdiff_t index) const {
+    if(!node || node->type != FArray)return {};
+    std::ptrdiff_t n = node->count;
+    if(index < 0)index += n;
+    if(index < 0 || index >= n)return {};
+    return child_at((size_t)index);
+}
+
+FrozenView FrozenView::jump_ptr(std::string_view path, bool err) const {
+    if(path.empty())return *this;
+    if(path[0] != '/'){
+        if(err)invoke_error(err_locate_error, "Failed to parse pointer which isn't begin with '/'!PATH:{}", path);
+        return {};
+    }
+
+    FrozenView current = *this;
+    std::string token;
+    while(!path.empty()){
+        path.remove_prefix(1);
+        size_t next = path.find('/');
+        std::string_view raw = path.substr(0, next);
+        path = next == std::string_view::npos ? std::string_view() : path.substr(next);
+
+        if(current.is_array()){
+            std::ptrdiff_t index;
+            auto res = std::from_chars(raw.data(), raw.data() + raw.size(), index);
+            FrozenView v;
+            if(res.ec == std::errc() && res.ptr == raw.data() + raw.size())v = current.at_ptr(index);
+            if(!v){
+                if(err)invoke_error(err_locate_error, "Locate failed when finding array index {}!", raw);
+                return {};
+            }
+            current = v;
+            continue;
+        }
+
+        token.clear();
+        for(size_t i = 0;i < raw.size();++i){
+            if(raw[i] == '~' && i + 1 < raw.size() && (raw[i + 1] == '0' || raw[i + 1] == '1')){
+                token.push_back(raw[i + 1] == '0' ? '~' : '/');
+                ++i;
+            }else token.push_back(raw[i]);
+        }
+        FrozenView v = current.at_ptr(token);
+        if(!v){
+            if(err)invoke_error(err_locate_error, "Locate failed when finding object name {}!", token);
+            return {};
+        }
+        current = v;
+    }
+    return current;
+}
+
+void FrozenView::thaw(dadata_t& out) const {
+    struct Frame{
+        FrozenView view;
+        dadata_t* node;
+    };
+    std::vector<Frame> stack;
+    stack.push_back({*this, &out});
+
+    while(!stack.empty()){
+        Frame f = stack.back();
+        stack.pop_back();
+        const Node* n = f.view.node;
+        if(!n){
+            f.node->set_null();
+            continue;
+        }
+
+        switch(n->type){
+        case FNull: f.node->set_null(); break;
+        case FBool: *f.node = (n->payload != 0); break;
+        case FInt: *f.node = std::bit_cast<int64_t>(n->payload); break;
+        case FDouble: *f.node = std::bit_cast<double>(n->payload); break;
+        case FString: *f.node = std::string_view(f.view.blob() + n->payload, n->count); break;
+        case FObject: {
+            auto& obj = f.node->set<dadata_t::Object>();
+            obj.reserve(n->count);
+            // 先创建全部子节点再入栈,之后父容器不会再扩容,指针保持有效
+            size_t base = stack.size();
+            for(size_t i = 0;i < n->count;++i){
+                stack.push_back({f.view.child_at(i), &obj[f.view.key_at(i)]});
+            }
+            std::reverse(stack.begin() + base, stack.end());
+            break;
+        }
+        case FArray: {
+            auto& arr = f.node->set<dadata_t::Array>();
+            arr.values.reserve(n->count);
+            for(size_t i = 0;i < n->count;++i){
+                arr.values.emplace_back(f.node->get_allocator());
+            }
+            for(size_t i = n->count;i > 0;--i){
+                stack.push_back({f.view.child_at(i - 1), &arr.values[i - 1]});
+            }
+            break;
+        }
+        }
+    }
+}
+
+FrozenAData& FrozenAData::operator=(FrozenAData&& o) ALIB5_NOEXCEPT {
+    if(this == &o)return *this;
+    close();
+    data = std::exchange(o.data, nullptr);
+    length = std::exchange(o.length, 0);
+    mapped = std::exchange(o.mapped, false);
+#ifdef _WIN32
+    mapping_handle = std::exchange(o.mapping_handle, nullptr);
+#endif
+    return *this;
+}
+
+size_t FrozenAData::freeze(const dadata_t& root, std::pmr::string& out){
+    struct Pending{
+        const dadata_t* data;
+        uint64_t node_off;
+    };
+    // out里已经有内容时补零,让镜像从alignof(Node)的倍数处开始
+    out.append((alignof(Node) - out.size() % alignof(Node)) % alignof(Node), '\0');
+    FrozenWriter w { out, out.size() };
+    std::vector<Pending> queue;
+    std::vector<KeyEntry> entries;
+
+    uint64_t header_off = w.alloc(sizeof(Header));
+    uint64_t root_off = w.alloc(sizeof(Node));
+    queue.push_back({&root, root_off});
+
+    // 广度优先,子节点区总是分配在父节点之后,verify依赖这一点排除环
+    for(size_t qi = 0;qi < queue.size();++qi){
+        Pending p = queue[qi];
+        Node n {};
+        switch(p.data->get_type()){
+        case dadata_t::TNull:
+            n.type = FNull;
+            break;
+        case dadata_t::TValue: {
+            auto& v = p.data->value();
+            switch(v.get_type()){
+            case dvalue_t::BOOL:
+                n.type = FBool;
+                n.payload = v.to<bool>();
+                break;
+            case dvalue_t::INT:
+                n.type = FInt;
+                n.payload = std::bit_cast<uint64_t>(v.to<int64_t>());
+                break;
+            case dvalue_t::FLOATING:
+                n.type = FDouble;
+                n.payload = std::bit_cast<uint64_t>(v.to<double>());
+                break;
+            case dvalue_t::STRING: {
+                auto s = v.raw_view();
+                panic_if(s.size() > UINT32_MAX, "String is too long to be frozen!");
+                n.type = FString;
+                n.count = (uint32_t)s.size();
+                n.payload = w.intern(s);
+                break;
+            }
+            }
+            break;
+        }
+        case dadata_t::TObject: {
+            auto& obj = p.data->object();
+            panic_if(obj.size() > UINT32_MAX, "Object is too large to be frozen!");
+            entries.clear();
+            for(auto proxy : obj){
+                entries.push_back({hash_key(proxy.first()), proxy.first(), &proxy.second()});
+            }
+            std::sort(entries.begin(), entries.end(), [](const KeyEntry& a, const KeyEntry& b){
+                return a.hash != b.hash ? a.hash < b.hash : a.key < b.key;
+            });
+
+            n.type = FObject;
+            n.count = (uint32_t)entries.size();
+            n.payload = w.alloc(entries.size() * (sizeof(KeyRef) + sizeof(Node)));
+            uint64_t child_off = n.payload + entries.size() * sizeof(KeyRef);
+            for(size_t i = 0;i < entries.size();++i){
+                auto& e = entries[i];
+                panic_if(e.key.size() > UINT32_MAX, "Key is too long to be frozen!");
+                KeyRef k { e.hash, (uint32_t)e.key.size(), w.intern(e.key) };
+                w.store(n.payload + i * sizeof(KeyRef), k);
+                queue.push_back({e.node, child_off + i * sizeof(Node)});
+            }
+            break;
+        }
+        case dadata_t::TArray: {
+            auto& arr = p.data->array();
+            panic_if(arr.size() > UINT32_MAX, "Array is too large to be frozen!");
+            n.type = FArray;
+            n.count = (uint32_t)arr.size();
+            n.payload = w.alloc(arr.size() * sizeof(Node));
+            for(size_t i = 0;i < arr.size();++i){
+                queue.push_back({&arr[i], n.payload + i * sizeof(Node)});
+            }
+            break;
+        }
+        }
+        w.store(p.node_off, n);
+    }
+
+    Header h {};
+    std::memcpy(h.magic, frozen::magic, sizeof(h.magic));
+    h.version = frozen::version;
+    h.root = root_off;
+    h.blob = out.size() - w.start;
+    out.append(w.blob);
+    h.size = out.size() - w.start;
+    w.store(header_off, h);
+    return w.start;
+}
+
+bool FrozenAData::freeze_to_file(const dadata_t& root, std::string_view path){
+    std::pmr::string buffer (ALIB5_DEFAULT_MEMORY_RESOURCE);
+    freeze(root, buffer);
+    return io::write_all(path, buffer) == buffer.size();
+}
+
+bool FrozenAData::check_header(){
+    if constexpr(std::endian::native != std::endian::little){
+        invoke_error(err_format_error, "Frozen AData is only supported on little-endian hosts!");
+        return false;
+    }
+    if(reinterpret_cast<uintptr_t>(data) % alignof(Header)){
+        invoke_error(err_format_error, "Frozen AData buffer must be 8-byte aligned!");
+        return false;
+    }
+    if(length < sizeof(Header)){
+        invoke_error(err_format_error, "Frozen AData is truncated!");
+        return false;
+    }
+    auto* h = reinterpret_cast<const Header*>(data);
+    if(std::memcmp(h->magic, frozen::magic, sizeof(h->magic)) || h->version != frozen::version){
+        invoke_error(err_format_error, "Bad frozen AData header!");
+        return false;
+    }
+    if(h->size > length || h->root < sizeof(Header) || h->root % alignof(Node)
+       || h->root + sizeof(Node) > h->size || h->blob > h->size){
+        invoke_error(err_format_error, "Frozen AData header is inconsistent with the data size!");
+        return false;
+    }
+    return true;
+}
+
+bool FrozenAData::open_memory(std::string_view buffer){
+    close();
+    data = buffer.data();
+    length = buffer.size();
+    mapped = false;
+    if(!check_header()){
+        data = nullptr;
+        length = 0;
+        return false;
+    }
+    return true;
+}
+
+bool FrozenAData::open(std::string_view path){
+    close();
+    std::string p (path);
+#ifdef _WIN32
+    HANDLE file = CreateFileA(p.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if(file == INVALID_HANDLE_VALUE){
+        invoke_error(err_io_error, "Failed to open file {}!", path);
+        return false;
+    }
+    LARGE_INTEGER sz;
+    if(!GetFileSizeEx(file, &sz) || sz.QuadPart == 0){
+        CloseHandle(file);
+        invoke_error(err_io_error, "Failed to map empty or unreadable file {}!", path);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    // 映射对象持有文件的引用,文件句柄可以直接关闭
+    CloseHandle(file);
+    if(!mapping){
+        invoke_error(err_io_error, "Failed to map file {}!", path);
+        return false;
+    }
+    const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if(!view){
+        CloseHandle(mapping);
+        invoke_error(err_io_error, "Failed to map file {}!", path);
+        return false;
+    }
+    mapping_handle = mapping;
+    data = static_cast<const char*>(view);
+    length = (size_t)sz.QuadPart;
+#else
+    int fd = ::open(p.c_str(), O_RDONLY);
+    if(fd < 0){
+        invoke_error(err_io_error, "Failed to open file {}: {}", path, std::strerror(errno));
+        return false;
+    }
+    struct stat st;
+    if(::fstat(fd, &st) || st.st_size == 0){
+        ::close(fd);
+        invoke_error(err_io_error, "Failed to map empty or unreadable file {}!", path);
+        return false;
+    }
+    void* view = ::mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    // mmap之后fd可以关闭,映射仍然有效
+    ::close(fd);
+    if(view == MAP_FAILED){
+        invoke_error(err_io_error, "Failed to map file {}: {}", path, std::strerror(errno));
+        return false;
+    }
+    data = static_cast<const char*>(view);
+    length = (size_t)st.st_size;
+#endif
+    mapped = true;
+    if(!check_header()){
+        close();
+        return false;
+    }
+    return true;
+}
+
+void FrozenAData::close(){
+    if(data && mapped){
+#ifdef _WIN32
+        UnmapViewOfFile(data);
+        CloseHandle(mapping_handle);
+        mapping_handle = nullptr;
+#else
+        ::munmap(const_cast<char*>(data), length);
+#endif
+    }
+    data = nullptr;
+    length = 0;
+    mapped = false;
+}
+
+bool FrozenAData::verify() const {
+    if(!data)return false;
+    auto* h = reinterpret_cast<const Header*>(data);
+    const uint64_t size = h->size;
+    const uint64_t blob_size = size - h->blob;
+    // 每个节点至少占16字节,合法文件的节点总数不会超过这个值
+    uint64_t budget = size / sizeof(Node);
+
+    std::vector<uint64_t> stack;
+    stack.push_back(h->root);
+    while(!stack.empty()){
+        uint64_t off = stack.back();
+        stack.pop_back();
+        if(!budget--)return false;
+
+        auto* n = reinterpret_cast<const Node*>(data + off);
+        switch(n->type){
+        case FNull:
+        case FBool:
+        case FInt:
+        case FDouble:
+            break;
+        case FString:
+            if(n->payload > blob_size || n->count > blob_size - n->payload)return false;
+            break;
+        case FObject:
+        case FArray: {
+            bool is_obj = n->type == FObject;
+            uint64_t stride = is_obj ? sizeof(KeyRef) + sizeof(Node) : sizeof(Node);
+            // 子节点区必须在父节点之后,这样偏移严格递增,不会成环
+            if(n->payload <= off || n->payload % alignof(Node) || n->payload > h->blob
+               || n->count > (h->blob - n->payload) / stride){
+                return false;
+            }
+            uint64_t child = n->payload;
+            if(is_obj){
+                auto* keys = reinterpret_cast<const KeyRef*>(data + n->payload);
+                for(uint32_t i = 0;i < n->count;++i){
+                    auto& k = keys[i];
+                    if(k.offset > blob_size || k.length > blob_size - k.offset)return false;
+                    std::string_view key (data + h->blob + k.offset, k.length);
+                    if(hash_key(key) != k.hash)return false;
+                    if(i && (keys[i - 1].hash > k.hash ||
+                             (keys[i - 1].hash == k.hash &&
+                              std::string_view(data + h->blob + keys[i - 1].offset, keys[i - 1].length) >= key))){
+                        return false;
+                    }
+                }
+                child += n->count * sizeof(KeyRef);
+            }
+            for(uint32_t i = 0;i < n->count;++i){
+                stack.push_back(child + i * sizeof(Node));
+            }
+            break;
+        }
+        default:
+            return false;
+        }
+    }
+    return true;
+}
@@ -1,14 +1,27 @@
 #include <alib5/adata.h>
+#include <alib5/data/data_text.h>
 #include <rapidjson/rapidjson.h>
 #include <rapidjson/reader.h>
 #include <cmath>
+#include <array>
+#include <charconv>
+#include <cerrno>
+#include <cstring>
+#ifdef _WIN32
+    #include <io.h>
+#else
+    #include <unistd.h>
+#endif
 
 using namespace alib5;
 using namespace alib5::data;
 
+/// KeyType为std::string_view时要求key在整个解析过程中有效(insitu模式)
+/// borrow_keys时长键直接引用输入,要求输入比整棵树活得久(JSONDocument)
+template<class KeyType = std::string,bool borrow_keys = false>
 struct ADataHandler{
     std::vector<AData*> stack;
-    std::string last_key;
+    KeyType last_key;
 
     ADataHandler(AData& root){
         stack.push_back(&root);
@@ -19,7 +32,8 @@ struct ADataHandler{
     AData& prepare_node() {
         AData& c = current();
         if(c.get_type() == AData::TObject){
-            return c[last_key];
+            if constexpr(borrow_keys)return *c.object().ensure_node_borrowed(last_key).first;
+            else return c[last_key];
         }else if(c.get_type() == AData::TArray){
             return c.array().values.emplace_back(c.get_allocator());
         }
@@ -27,7 +41,7 @@ struct ADataHandler{
     }
 
     // --- RapidJSON Events ---
-    bool Null() { prepare_node().set<std::monostate>(); return true; }
+    bool Null() { prepare_node().set_null(); return true; }
     bool Bool(bool b){ prepare_node() = b; return true; }
     bool Int(int i){ prepare_node() = (int64_t)i; return true; }
     bool Uint(unsigned u){ prepare_node() = (int64_t)u; return true; }
@@ -75,29 +89,190 @@ struct ADataHandler{
     }
 };
 
-bool JSON::parse(std::string_view v,dadata_t & root){
-    root.set<std::monostate>();
+/// 带边界的insitu流,rapidjson自带的InsituStringStream要求以'\0'结尾,mmap进来的文件做不到
+struct BoundedInsituStream{
+    typedef char Ch;
+
+    Ch* src;
+    Ch* dst;
+    Ch* head;
+    Ch* end;
+
+    BoundedInsituStream(std::span<char> buf)
+    : src(buf.data()), dst(nullptr), head(buf.data()), end(buf.data() + buf.size()) {}
+
+    Ch Peek() const { return src < end ? *src : '\0'; }
+    Ch Take() { return src < end ? *src++ : '\0'; }
+    size_t Tell() const { return static_cast<size_t>(src - head); }
+
+    Ch* PutBegin() { return dst = src; }
+    void Put(Ch c) { *dst++ = c; }
+    size_t PutEnd(Ch* begin) { return static_cast<size_t>(dst - begin); }
+    void Flush() {}
+
+    Ch* Push(size_t count) { Ch* begin = dst; dst += count; return begin; }
+    void Pop(size_t count) { dst -= count; }
+};
+
+namespace rapidjson {
+    template<>
+    struct StreamTraits<BoundedInsituStream> {
+        enum { copyOptimization = 1 };
+    };
+}
+
+template<unsigned flags, class Stream, class Handler>
+static bool parse_with(const JSONConfig& cfg, Stream& ss, Handler& handler){
     using namespace rapidjson;
 
     char localBuffer[16 * 1024];
     MemoryPoolAllocator<> stackAlloc(localBuffer, sizeof(localBuffer));
-
     GenericReader<UTF8<>,UTF8<>,MemoryPoolAllocator<>> reader(&stackAlloc);
-    MemoryStream ss(v.data(), v.size());
-    ADataHandler handler(root);
 
     ParseResult res;
     if(cfg.rapidjson_recursive){
-        if(cfg.allow_comments)res = reader.Parse<kParseDefaultFlags | rapidjson::kParseCommentsFlag>(ss, handler);
-        else res = reader.Parse<kParseDefaultFlags>(ss, handler);
+        if(cfg.allow_comments)res = reader.Parse<flags | kParseDefaultFlags | kParseCommentsFlag>(ss, handler);
+        else res = reader.Parse<flags | kParseDefaultFlags>(ss, handler);
     }else{
-        if(cfg.allow_comments)res = reader.Parse<kParseIterativeFlag | rapidjson::kParseCommentsFlag>(ss, handler);
-        else res = reader.Parse<kParseIterativeFlag >(ss, handler);
+        if(cfg.allow_comments)res = reader.Parse<flags | kParseIterativeFlag | kParseCommentsFlag>(ss, handler);
+        else res = reader.Parse<flags | kParseIterativeFlag>(ss, handler);
     }
     return (bool)res;
 }
 
-JSON::DumpResult JSON::__internal_dump(__dump_fn fn,void * p, const dadata_t & root){
+bool JSON::parse(std::string_view v,dadata_t & root){
+    root.set<std::monostate>();
+    rapidjson::MemoryStream ss(v.data(), v.size());
+    ADataHandler<> handler(root);
+    return parse_with<rapidjson::kParseNoFlags>(cfg, ss, handler);
+}
+
+template<bool borrow_keys>
+static bool parse_insitu_with(const JSONConfig& cfg, std::span<char> data, dadata_t & root){
+    root.set<std::monostate>();
+    BoundedInsituStream ss(data);
+    // key直接指向buffer内部,不再拷贝到临时的std::string
+    ADataHandler<std::string_view,borrow_keys> handler(root);
+    return parse_with<rapidjson::kParseInsituFlag>(cfg, ss, handler);
+}
+
+bool JSON::parse_insitu(std::span<char> data,dadata_t & root){
+    return parse_insitu_with<false>(cfg, data, root);
+}
+
+bool JSON::parse_insitu(std::pmr::string&& text,JSONDocument & doc){
+    doc.clear();
+    doc.buffer = std::move(text);
+    // buffer和arena一起存活,键反转义之后留在buffer里,直接引用
+    return parse_insitu_with<true>(cfg, std::span<char>(doc.buffer.data(), doc.buffer.size()), doc.root);
+}
+
+namespace {
+    /// 输出缓冲,fn为空时直接写入目标字符串,否则攒够chunk再回调一次
+    template<class Out>
+    struct JSONWriter{
+        Out& out;
+        JSON::__dump_fn* fn;
+        void* p;
+        size_t chunk;
+
+        inline void put(std::string_view s){ out.append(s); }
+        inline void put(char c){ out.push_back(c); }
+
+        inline void commit(){
+            if(fn && out.size() >= chunk){
+                fn(out, p);
+                out.clear();
+            }
+        }
+
+        inline void finish(){
+            if(fn && !out.empty()){
+                fn(out, p);
+                out.clear();
+            }
+        }
+
+        void put_int(int64_t v){
+            char tmp[24];
+            auto r = std::to_chars(tmp, tmp + sizeof(tmp), v);
+            out.append(tmp, r.ptr);
+        }
+
+        void put_double(double v, int precision){
+            // 与反射的to_json共用,nan/inf写成null
+            detail::json_write_float(out, v, precision);
+        }
+
+        void put_unicode(uint32_t cp){
+            static constexpr char hex[] = "0123456789abcdef";
+            char tmp[6] = {'\\', 'u', hex[(cp >> 12) & 0xF], hex[(cp >> 8) & 0xF], hex[(cp >> 4) & 0xF], hex[cp & 0xF]};
+            out.append(tmp, 6);
+        }
+
+        /// 直接在输出缓冲里转义,不经过临时字符串
+        void put_escaped(std::string_view s, bool ensure_ascii){
+            static constexpr auto needs_escape = []{
+                std::array<uint8_t,256> t {};
+                for(int i = 0;i < 0x20;++i)t[i] = 1;
+                t[(uint8_t)'"'] = 1;
+                t[(uint8_t)'\\'] = 1;
+                for(int i = 0x80;i < 0x100;++i)t[i] = 2;
+                return t;
+            }();
+            const uint8_t mask = ensure_ascii ? 3 : 1;
+
+            size_t run = 0;
+            for(size_t i = 0;i < s.size();){
+                uint8_t c = (uint8_t)s[i];
+                if(!(needs_escape[c] & mask)) [[likely]] {
+                    ++i;
+                    continue;
+                }
+                out.append(s.data() + run, i - run);
+                if(c < 0x80){
+                    switch(c){
+                    case '"': put("\\\""); break;
+                    case '\\': put("\\\\"); break;
+                    case '\b': put("\\b"); break;
+                    case '\f': put("\\f"); break;
+                    case '\n': put("\\n"); break;
+                    case '\r': put("\\r"); break;
+                    case '\t': put("\\t"); break;
+                    default: put_unicode(c); break;
+                    }
+                    ++i;
+                }else{
+                    // ensure_ascii: 解码utf8,超出BMP的使用代理对
+                    size_t len = (c & 0xE0) == 0xC0 ? 2 : (c & 0xF0) == 0xE0 ? 3 : (c & 0xF8) == 0xF0 ? 4 : 0;
+                    uint32_t cp = len == 2 ? (c & 0x1F) : len == 3 ? (c & 0x0F) : (c & 0x07);
+                    bool valid = len && i + len <= s.size();
+                    for(size_t k = 1;valid && k < len;++k){
+                        uint8_t cc = (uint8_t)s[i + k];
+                        if((cc & 0xC0) != 0x80)valid = false;
+                        cp = (cp << 6) | (cc & 0x3F);
+                    }
+                    if(!valid){
+                        put_unicode(0xFFFD);
+                        ++i;
+                    }else{
+                        if(cp >= 0x10000){
+                            cp -= 0x10000;
+                            put_unicode(0xD800 + (cp >> 10));
+                            put_unicode(0xDC00 + (cp & 0x3FF));
+                        }else put_unicode(cp);
+                        i += len;
+                    }
+                }
+                run = i;
+            }
+            out.append(s.data() + run, s.size() - run);
+        }
+    };
+}
+
+template<class Out>
+static JSON::DumpResult dump_impl(const JSONConfig& cfg, JSONWriter<Out>& w, const dadata_t& root){
     struct Frame{
         const dadata_t* data;
         int depth;
@@ -115,7 +290,7 @@ JSON::DumpResult JSON::__internal_dump(__dump_fn fn,void * p, const dadata_t & r
     std::vector<Frame> queue;
     /// SSO
     std::string indents = "";
-    DumpResult rt = Success;
+    JSON::DumpResult rt = JSON::Success;
 
     std::string_view place_comma = cfg.compact_lines ? "," : ",\n";
     std::string_view place_next = cfg.compact_lines ? (cfg.compact_spaces?"":" ") : "\n";
@@ -135,7 +310,7 @@ JSON::DumpResult JSON::__internal_dump(__dump_fn fn,void * p, const dadata_t & r
         obj_new = "{\n";
     }
 
-    auto get_indent = [this,&indents](int indent) -> std::string_view{
+    auto get_indent = [&cfg,&indents](int indent) -> std::string_view{
         if(indent < 0)indent = 0;
         if(indents.size() < indent){
             indents.resize(indent,cfg.dump_indent_char);
@@ -155,9 +330,9 @@ JSON::DumpResult JSON::__internal_dump(__dump_fn fn,void * p, const dadata_t & r
         /// 最后一行不处理
         if(queue.empty())return;
         if(!current.last_child){
-            fn(place_comma, p);
+            w.put(place_comma);
         }else{
-            fn(place_next, p);
+            w.put(place_next);
         }
     };
 
@@ -172,69 +347,68 @@ JSON::DumpResult JSON::__internal_dump(__dump_fn fn,void * p, const dadata_t & r
         queue.pop_back();
 
         if(current.action == Frame::WRITE_CLOSE_OBJ){
-            if(!cfg.compact_lines)fn(get_indent(current.depth * cfg.dump_indent),p);
+            if(!cfg.compact_lines)w.put(get_indent(current.depth * cfg.dump_indent));
             
-            fn("}",p);
+            w.put('}');
             place(current);
+            w.commit();
             continue;
         }else if(current.action == Frame::WRITE_CLOSE_ARR){
-            if(!cfg.compact_lines)fn(get_indent(current.depth * cfg.dump_indent),p);
-            fn("]",p);
+            if(!cfg.compact_lines)w.put(get_indent(current.depth * cfg.dump_indent));
+            w.put(']');
             place(current);
+            w.commit();
             continue;
         }
 
         // 先到达indent
-        if(!cfg.compact_lines)fn(get_indent(current.depth * cfg.dump_indent),p);
+        if(!cfg.compact_lines)w.put(get_indent(current.depth * cfg.dump_indent));
         if(current.name){
             // object 处理逻辑
-            fn("\"",p);
-            fn(*current.name,p);
-            if(cfg.compact_spaces) fn("\":",p);
-            else fn("\" : ",p);
+            w.put('"');
+            w.put_escaped(*current.name,cfg.ensure_ascii);
+            if(cfg.compact_spaces) w.put("\":");
+            else w.put("\" : ");
         }
         if(current.data->is_null()){
-            fn("null",p);
+            w.put("null");
             place(current);
+            w.commit();
         }else if(current.data->is_value()){
-            auto & v = current.data->value();
-            if(v.get_type() != v.STRING){
-                if(cfg.warn_when_nan && v.get_type() == v.FLOATING){
-                    double val = v.to<float>();
+            const dvalue_t & v = current.data->value();
+            switch(v.get_type()){
+            case dvalue_t::INT:
+                w.put_int(v.to<int64_t>());
+                break;
+            case dvalue_t::BOOL:
+                w.put(v.to<bool>() ? "true" : "false");
+                break;
+            case dvalue_t::FLOATING: {
+                double val = v.to<double>();
+                if(cfg.warn_when_nan && !std::isfinite(val)){
                     if(std::isnan(val)){
                         invoke_error(err_dump_error,"Encountered nan when dumping!");
-                        if(!rt)rt = EncounteredNAN;
+                        if(!rt)rt = JSON::EncounteredNAN;
                     }else{
                         invoke_error(err_dump_error,"Encountered inf when dumping!");
-                        if(!rt)rt = EncounteredINF;
-                    }
-                    if(cfg.float_precision >= 0){
-                        static thread_local std::pmr::string double_cache (ALIB5_DEFAULT_MEMORY_RESOURCE);
-                        if(double_cache.capacity() < 16)double_cache.reserve(16);
-                        double_cache.clear();
-
-                        std::vformat_to(
-                            std::back_inserter(double_cache),
-                            "{:.{}f}",
-                            std::make_format_args(
-                                val,
-                                cfg.float_precision
-                            )
-                        );
-                        fn(double_cache,p);
+                        if(!rt)rt = JSON::EncounteredINF;
                     }
                 }
-                if(cfg.float_precision < 0)fn(v.to<std::string>(),p);
-            }else{
-                fn("\"",p);
-                fn(str::escape(v.to<std::string>(),cfg.ensure_ascii),p);
-                fn("\"",p);
+                w.put_double(val,cfg.float_precision);
+                break;
+            }
+            case dvalue_t::STRING:
+                w.put('"');
+                w.put_escaped(v.raw_view(),cfg.ensure_ascii);
+                w.put('"');
+                break;
             }
             place(current);
+            w.commit();
         }else if(current.data->is_array()){
             int index = 0;
             size_t sz = current.data->array().size();
-            fn(arr_new,p);
+            w.put(arr_new);
             queue.push_back({
                 nullptr,
                 current.depth,
@@ -257,7 +431,7 @@ JSON::DumpResult JSON::__internal_dump(__dump_fn fn,void * p, const dadata_t & r
         }else if(current.data->is_object()){
             size_t sz = current.data->object().size();
             int index = sz;
-            fn(obj_new,p);
+            w.put(obj_new);
             queue.push_back({
                 nullptr,
                 current.depth,
@@ -277,7 +451,7 @@ JSON::DumpResult JSON::__internal_dump(__dump_fn fn,void * p, const dadata_t & r
                         &proxy.second()
                     });
                 }
-                std::sort(frames.begin(),frames.end(),[this](const ObjFrame & a,const ObjFrame & b){
+                std::sort(frames.begin(),frames.end(),[&cfg](const ObjFrame & a,const ObjFrame & b){
                     return !cfg.sort_object(a.name,b.name);
                 });
                 /// 倒着插入
@@ -312,5 +486,50 @@ JSON::DumpResult JSON::__internal_dump(__dump_fn fn,void * p, const dadata_t & r
             }
         }
     }
+    w.finish();
     return rt;
-}
\ No newline at end of file
+}
+
+JSON::DumpResult JSON::__internal_dump(__dump_fn fn,void * p, const dadata_t & root){
+    // 每次dump一个缓冲,回调里再dump也不会互相覆盖;写满dump_chunk_size就交出去,不会继续增长
+    std::pmr::string chunk (ALIB5_DEFAULT_MEMORY_RESOURCE);
+    chunk.reserve(cfg.dump_chunk_size);
+    JSONWriter<std::pmr::string> w { chunk, fn, p, cfg.dump_chunk_size };
+    return dump_impl(cfg, w, root);
+}
+
+JSON::DumpResult JSON::__internal_dump(std::string & out, const dadata_t & root){
+    JSONWriter<std::string> w { out, nullptr, nullptr, 0 };
+    return dump_impl(cfg, w, root);
+}
+
+JSON::DumpResult JSON::__internal_dump(std::pmr::string & out, const dadata_t & root){
+    JSONWriter<std::pmr::string> w { out, nullptr, nullptr, 0 };
+    return dump_impl(cfg, w, root);
+}
+
+JSON::DumpResult JSON::dump_to_fd(int fd, const dadata_t & root){
+    struct FdSink{
+        int fd;
+        bool failed;
+    } sink { fd, false };
+
+    auto fn = [](std::string_view sv, void* ag){
+        FdSink& s = *static_cast<FdSink*>(ag);
+        while(!sv.empty() && !s.failed){
+#ifdef _WIN32
+            auto n = ::_write(s.fd, sv.data(), (unsigned int)sv.size());
+#else
+            auto n = ::write(s.fd, sv.data(), sv.size());
+#endif
+            if(n < 0){
+                if(errno == EINTR)continue;
+                s.failed = true;
+                invoke_error(err_io_error,"Failed to write json to fd {}: {}",s.fd,std::strerror(errno));
+                return;
+            }
+            sv.remove_prefix((size_t)n);
+        }
+    };
+    return __internal_dump(fn, &sink, root);
+}
@@ -0,0 +1,32 @@
+#include <alib5/data/kernel.h>
+
+using namespace alib5;
+using namespace alib5::data;
+
+void KeyPool::grow(){
+    std::pmr::vector<Slot> next (table.empty() ? 64 : table.size() * 2, Slot{nullptr, 0, 0}, upstream);
+    size_t mask = next.size() - 1;
+    for(auto& s : table){
+        if(!s.data)continue;
+        size_t i = s.hash & mask;
+        while(next[i].data)i = (i + 1) & mask;
+        next[i] = s;
+    }
+    table.swap(next);
+}
+
+const char* KeyPool::intern(std::string_view key, uint32_t hash){
+    // 负载因子保持在1/2以下
+    if((count + 1) * 2 > table.size())grow();
+    size_t mask = table.size() - 1;
+    size_t i = hash & mask;
+    for(;table[i].data;i = (i + 1) & mask){
+        auto& s = table[i];
+        if(s.hash == hash && std::string_view(s.data, s.length) == key)return s.data;
+    }
+    char* p = static_cast<char*>(arena.allocate(key.size(), 1));
+    std::memcpy(p, key.data(), key.size());
+    table[i] = Slot{p, (uint32_t)key.size(), hash};
+    ++count;
+    return p;
+}
@@ -0,0 +1,187 @@
+#include <alib5/data/reflect/json_stream.h>
+#include <string>
+
+using namespace alib5;
+using namespace alib5::detail;
+
+namespace {
+    inline bool is_digit(char c){ return c >= '0' && c <= '9'; }
+}
+
+bool JSONStreamReader::next(char close,bool & first,std::string_view * key){
+    if(consume(close))return false;
+    if(!first){
+        if(!consume(','))return fail(close == '}' ? "expected ',' or '}'" : "expected ',' or ']'");
+        if(peek() == close)return fail("trailing comma");
+    }
+    first = false;
+    if(key){
+        if(!read_string(*key))return false;
+        if(!consume(':'))return fail("expected ':'");
+    }
+    return true;
+}
+
+bool JSONStreamReader::read_string(std::string_view & out){
+    if(peek() != '"')return fail("expected a string");
+    size_t begin = ++pos;
+
+    // 没有转义的字符串直接引用原文
+    while(pos < src.size()){
+        char c = src[pos];
+        if(c == '"'){
+            out = src.substr(begin,pos - begin);
+            ++pos;
+            return true;
+        }
+        if(c == '\\')break;
+        if((uint8_t)c < 0x20)return fail("control character in string");
+        ++pos;
+    }
+    if(pos >= src.size())return fail("unterminated string");
+
+    scratch.assign(src.substr(begin,pos - begin));
+    while(pos < src.size()){
+        char c = src[pos];
+        if(c == '"'){
+            ++pos;
+            out = scratch;
+            return true;
+        }
+        if((uint8_t)c < 0x20)return fail("control character in string");
+        if(c != '\\'){
+            scratch.push_back(c);
+            ++pos;
+            continue;
+        }
+        if(++pos >= src.size())break;
+        switch(src[pos++]){
+            case '"':  scratch.push_back('"'); break;
+            case '\\': scratch.push_back('\\'); break;
+            case '/':  scratch.push_back('/'); break;
+            case 'b':  scratch.push_back('\b'); break;
+            case 'f':  scratch.push_back('\f'); break;
+            case 'n':  scratch.push_back('\n'); break;
+            case 'r':  scratch.push_back('\r'); break;
+            case 't':  scratch.push_back('\t'); break;
+            case 'u': {
+                auto read_hex4 = [&](uint32_t& v){
+                    if(pos + 4 > src.size())return false;
+                    v = 0;
+                    for(size_t k = 0;k < 4;++k){
+                        int h = text_hex_value(src[pos + k]);
+                        if(h < 0)return false;
+                        v = (v << 4) | (uint32_t)h;
+                    }
+                    pos += 4;
+                    return true;
+                };
+                uint32_t cp = 0;
+                if(!read_hex4(cp))return fail("bad unicode escape");
+                if(cp >= 0xDC00 && cp <= 0xDFFF)return fail("lone low surrogate");
+                if(cp >= 0xD800 && cp <= 0xDBFF){
+                    // 高代理项后面必须紧跟低代理项
+                    uint32_t low = 0;
+                    if(src.substr(pos,2) != "\\u")return fail("lone high surrogate");
+                    pos += 2;
+                    if(!read_hex4(low))return fail("bad unicode escape");
+                    if(low < 0xDC00 || low > 0xDFFF)return fail("lone high surrogate");
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                }
+                text_append_utf8(scratch,cp);
+                break;
+            }
+            default:
+                --pos;
+                return fail("bad escape");
+        }
+    }
+    return fail("unterminated string");
+}
+
+bool JSONStreamReader::read_number(std::string_view & out,bool & is_float){
+    skip_ws();
+    size_t begin = pos;
+    is_float = false;
+
+    if(pos < src.size() && src[pos] == '-')++pos;
+    if(pos >= src.size() || !is_digit(src[pos]))return fail("expected a value");
+    if(src[pos] == '0')++pos;
+    else while(pos < src.size() && is_digit(src[pos]))++pos;
+
+    if(pos < src.size() && src[pos] == '.'){
+        is_float = true;
+        if(++pos >= src.size() || !is_digit(src[pos]))return fail("expected a digit");
+        while(pos < src.size() && is_digit(src[pos]))++pos;
+    }
+    if(pos < src.size() && (src[pos] == 'e' || src[pos] == 'E')){
+        is_float = true;
+        ++pos;
+        if(pos < src.size() && (src[pos] == '+' || src[pos] == '-'))++pos;
+        if(pos >= src.size() || !is_digit(src[pos]))return fail("expected a digit");
+        while(pos < src.size() && is_digit(src[pos]))++pos;
+    }
+    out = src.substr(begin,pos - begin);
+    return true;
+}
+
+bool JSONStreamReader::read_literal(std::string_view lit){
+    skip_ws();
+    if(src.substr(pos,lit.size()) != lit)return fail("expected a value");
+    pos += lit.size();
+    return true;
+}
+
+bool JSONStreamReader::skip_value(){
+    // 尚未闭合的容器,用显式栈而不是递归
+    std::string stack;
+    std::string_view key;
+    std::string_view tok;
+    bool first = false;
+    bool is_float = false;
+
+    while(true){
+        char c = peek();
+        if(c == '{' || c == '['){
+            ++pos;
+            stack.push_back(c == '{' ? '}' : ']');
+            first = true;
+        }else{
+            bool ok;
+            if(c == '"')ok = read_string(tok);
+            else if(c == 't')ok = read_literal("true");
+            else if(c == 'f')ok = read_literal("false");
+            else if(c == 'n')ok = read_literal("null");
+            else ok = read_number(tok,is_float);
+            if(!ok)return false;
+            first = false;
+        }
+
+        while(!stack.empty()){
+            char close = stack.back();
+            if(next(close,first,close == '}' ? &key : nullptr))break;
+            if(failed())return false;
+            stack.pop_back();
+            first = false;
+        }
+        if(stack.empty())return true;
+    }
+}
+
+bool JSONStreamReader::finish(){
+    skip_ws();
+    if(pos < src.size())return fail("unexpected trailing content");
+    return true;
+}
+
+void JSONStreamReader::report() const {
+    size_t line = 1;
+    size_t column = 1;
+    for(size_t i = 0;i < error_pos && i < src.size();++i){
+        if(src[i] == '\n'){
+            ++line;
+            column = 1;
+        }else ++column;
+    }
+    invoke_error(err_format_error, "Failed to parse JSON at line {} column {}: {}!", line, column, error);
+}
@@ -1,67 +1,933 @@
 #include <alib5/adata.h>
-#include <toml++/toml.hpp>
+#include <alib5/data/data_text.h>
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 using namespace alib5;
 using namespace alib5::data;
 
-bool TOML::parse(std::string_view data,dadata_t & node){
-    try{
-        const toml::table table = toml::parse(data);
-        struct Frame{
-            dadata_t * node;
-            const toml::node * table;
-        };
-        struct ObjFrame{
-            size_t index;
-            const toml::node * node;
-        };
-        std::deque<Frame> frames;
-        std::vector<ObjFrame> obj_frames;
-        frames.emplace_back(&node,&table);
-
-        while(!frames.empty()){
-            Frame f = frames.back();
-            frames.pop_back();
-
-            // DFS SYNC
-            f.table->visit([&](auto&& el) {
-                using T = std::decay_t<decltype(el)>;
-                if constexpr (toml::is_string<T> || toml::is_integer<T> || toml::is_floating_point<T> || toml::is_boolean<T>) {
-                    f.node->rewrite(*el); 
-                }else if constexpr (toml::is_date<T> || toml::is_time<T> || toml::is_date_time<T>){
-                    // 无奈之举?
-                    std::stringstream ss;
-                    ss << el;
-                    f.node->rewrite(ss.str());
-                }else if constexpr (toml::is_table<T>){
-                    const toml::table & tb = *f.table->as_table();
-                    f.node->set<dobject_t>();
-                    auto & obj = f.node->object();
-                    obj_frames.clear();
-                    for(auto & c : tb){
-                        obj_frames.emplace_back(obj.ensure_node(c.first).second,&c.second);
+namespace {
+    /// 容器是怎么被定义的,决定之后还能不能再打开它
+    /// 不在表里的对象/数组是内联表或者静态数组,不能再扩展
+    enum class Defined : uint8_t {
+        None,       ///< 不在表中
+        Implicit,   ///< 作为[a.b.c]的中间表隐式创建,之后还能被[a.b]定义一次
+        Header,     ///< 由[header]定义
+        Dotted,     ///< 由a.b = 1这样的点分键创建
+        TableArray  ///< 由[[header]]创建的数组
+    };
+
+    constexpr auto bare_key_chars = []{
+        std::array<bool,256> t {};
+        for(int c = 'a';c <= 'z';++c)t[c] = true;
+        for(int c = 'A';c <= 'Z';++c)t[c] = true;
+        for(int c = '0';c <= '9';++c)t[c] = true;
+        t[(uint8_t)'_'] = true;
+        t[(uint8_t)'-'] = true;
+        return t;
+    }();
+
+    inline bool is_digit(char c){ return c >= '0' && c <= '9'; }
+
+    /// 单遍读取,节点直接建在目标AData上
+    struct TOMLReader{
+        std::string_view src;
+        size_t pos {0};
+        std::string_view error {};
+        size_t error_pos {0};
+
+        /// 容器路径 -> 定义方式,路径由'k'+长度+键 / 'i'+下标拼成,不会有歧义
+        std::unordered_map<std::string,Defined> defined;
+        std::vector<std::string> keys;
+        size_t key_count {0};
+        std::string scratch;
+
+        explicit TOMLReader(std::string_view s) : src(s) {}
+
+        bool fail(std::string_view msg){
+            if(error.empty()){
+                error = msg;
+                error_pos = pos;
+            }
+            return false;
+        }
+
+        inline bool eof() const { return pos >= src.size(); }
+        inline char peek(size_t off = 0) const { return pos + off < src.size() ? src[pos + off] : '\0'; }
+        inline bool starts(std::string_view s) const { return src.substr(pos, s.size()) == s; }
+
+        static void push_key(std::string& path, std::string_view key){
+            uint32_t n = (uint32_t)key.size();
+            path.push_back('k');
+            path.append((const char*)&n, sizeof(n));
+            path.append(key);
+        }
+
+        static void push_index(std::string& path, size_t index){
+            uint64_t n = index;
+            path.push_back('i');
+            path.append((const char*)&n, sizeof(n));
+        }
+
+        Defined lookup(const std::string& path) const {
+            auto it = defined.find(path);
+            return it == defined.end() ? Defined::None : it->second;
+        }
+
+        void skip_ws(){
+            while(pos < src.size() && (src[pos] == ' ' || src[pos] == '\t'))++pos;
+        }
+
+        bool skip_comment(){
+            if(peek() != '#')return true;
+            for(++pos;pos < src.size() && src[pos] != '\n';++pos){
+                uint8_t c = (uint8_t)src[pos];
+                if((c < 0x20 && c != '\t' && !(c == '\r' && peek(1) == '\n')) || c == 0x7F){
+                    return fail("control character in comment");
+                }
+            }
+            return true;
+        }
+
+        /// 行尾: 空白,注释,然后换行或者文件结束
+        bool end_of_line(){
+            skip_ws();
+            if(!skip_comment())return false;
+            if(eof())return true;
+            if(src[pos] == '\n'){ ++pos; return true; }
+            if(src[pos] == '\r' && peek(1) == '\n'){ pos += 2; return true; }
+            return fail("expected the end of the line");
+        }
+
+        /// 数组里可以换行和写注释
+        bool skip_ws_lines(){
+            while(true){
+                skip_ws();
+                if(!skip_comment())return false;
+                if(peek() == '\n')++pos;
+                else if(peek() == '\r' && peek(1) == '\n')pos += 2;
+                else return true;
+            }
+        }
+
+        bool read_escape(std::string& out){
+            // pos位于'\\'之后
+            char c = peek();
+            ++pos;
+            switch(c){
+            case 'b': out.push_back('\b'); return true;
+            case 't': out.push_back('\t'); return true;
+            case 'n': out.push_back('\n'); return true;
+            case 'f': out.push_back('\f'); return true;
+            case 'r': out.push_back('\r'); return true;
+            case '"': out.push_back('"'); return true;
+            case '\\': out.push_back('\\'); return true;
+            case 'u':
+            case 'U': {
+                size_t len = c == 'u' ? 4 : 8;
+                if(pos + len > src.size())return fail("truncated unicode escape");
+                uint32_t cp = 0;
+                auto r = std::from_chars(src.data() + pos, src.data() + pos + len, cp, 16);
+                if(r.ec != std::errc() || r.ptr != src.data() + pos + len)return fail("bad unicode escape");
+                if(cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF))return fail("unicode escape is not a scalar value");
+                pos += len;
+                detail::text_append_utf8(out, cp);
+                return true;
+            }
+            default:
+                --pos;
+                return fail("unknown escape sequence");
+            }
+        }
+
+        /// 结果可能指向src,也可能指向scratch,在下一次读字符串之前有效
+        bool read_string(std::string_view& out){
+            const char quote = peek();
+            const bool literal = quote == '\'';
+            const bool multi = peek(1) == quote && peek(2) == quote;
+            pos += multi ? 3 : 1;
+            if(multi){
+                // 紧跟开头的换行会被去掉
+                if(peek() == '\n')++pos;
+                else if(peek() == '\r' && peek(1) == '\n')pos += 2;
+            }
+
+            // 没有转义时直接引用原文
+            size_t begin = pos;
+            bool copied = false;
+            while(true){
+                if(eof())return fail("unterminated string");
+                char c = src[pos];
+                if(c == quote){
+                    if(!multi)break;
+                    if(peek(1) == quote && peek(2) == quote){
+                        // 结尾处最多还能有两个引号属于内容
+                        size_t extra = 0;
+                        while(extra < 2 && peek(3 + extra) == quote)++extra;
+                        if(copied)scratch.append(extra, quote);
+                        pos += extra;
+                        break;
+                    }
+                    if(copied)scratch.push_back(c);
+                    ++pos;
+                    continue;
+                }
+                if(c == '\\' && !literal){
+                    if(!copied){
+                        scratch.assign(src.data() + begin, pos - begin);
+                        copied = true;
+                    }
+                    ++pos;
+                    if(multi){
+                        // 行尾的反斜杠吃掉后面所有空白和换行
+                        size_t p = pos;
+                        while(p < src.size() && (src[p] == ' ' || src[p] == '\t'))++p;
+                        if(p < src.size() && (src[p] == '\n' || (src[p] == '\r' && p + 1 < src.size() && src[p + 1] == '\n'))){
+                            pos = p;
+                            while(pos < src.size() && (src[pos] == ' ' || src[pos] == '\t' || src[pos] == '\n' || src[pos] == '\r'))++pos;
+                            continue;
+                        }
+                    }
+                    if(!read_escape(scratch))return false;
+                    continue;
+                }
+                uint8_t u = (uint8_t)c;
+                if((u < 0x20 && u != '\t') || u == 0x7F){
+                    bool newline = c == '\n' || (c == '\r' && peek(1) == '\n');
+                    if(!multi || !newline)return fail("control character in string");
+                }
+                if(copied)scratch.push_back(c);
+                ++pos;
+            }
+            out = copied ? std::string_view(scratch) : src.substr(begin, pos - begin);
+            pos += multi ? 3 : 1;
+            return true;
+        }
+
+        /// 读取a."b".'c'形式的键到keys[0, key_count)
+        bool read_key(){
+            key_count = 0;
+            while(true){
+                skip_ws();
+                if(key_count == keys.size())keys.emplace_back();
+                std::string& k = keys[key_count++];
+                char c = peek();
+                if(c == '"' || c == '\''){
+                    if(peek(1) == c && peek(2) == c)return fail("multi-line strings cannot be keys");
+                    std::string_view v;
+                    if(!read_string(v))return false;
+                    k.assign(v);
+                }else{
+                    size_t begin = pos;
+                    while(pos < src.size() && bare_key_chars[(uint8_t)src[pos]])++pos;
+                    if(begin == pos)return fail("expected a key");
+                    k.assign(src.data() + begin, pos - begin);
+                }
+                skip_ws();
+                if(peek() != '.')return true;
+                ++pos;
+            }
+        }
+
+        /**
+         * 在table下按keys创建值节点,中间的表只能是点分键创建的
+         * path是table的路径,返回时为新节点的路径
+         */
+        AData* define_dotted(AData& table, std::string& path){
+            AData* cur = &table;
+            for(size_t i = 0;i < key_count;++i){
+                auto& obj = cur->object();
+                std::string_view k = keys[i];
+                push_key(path, k);
+                auto it = obj.find(k);
+                if(i + 1 == key_count){
+                    if(it != obj.end()){
+                        fail("duplicate key");
+                        return nullptr;
                     }
-                    for(int i = obj_frames.size() - 1;i >= 0;--i){
-                        frames.emplace_back(&obj.children[obj_frames[i].index],obj_frames[i].node);
+                    return &obj[k];
+                }
+                if(it == obj.end()){
+                    cur = &obj[k];
+                    cur->set<AData::Object>();
+                    defined[path] = Defined::Dotted;
+                }else{
+                    cur = &it.second();
+                    if(!cur->is_object() || lookup(path) != Defined::Dotted){
+                        fail("dotted keys cannot extend a value or a table defined elsewhere");
+                        return nullptr;
+                    }
+                }
+            }
+            return cur;
+        }
+
+        /// [a.b.c] / [[a.b.c]],path接收新表的路径
+        AData* open_table(AData& root, std::string& path, bool array){
+            AData* cur = &root;
+            path.clear();
+            for(size_t i = 0;i < key_count;++i){
+                auto& obj = cur->object();
+                std::string_view k = keys[i];
+                push_key(path, k);
+                auto it = obj.find(k);
+                const bool last = i + 1 == key_count;
+
+                if(it == obj.end()){
+                    cur = &obj[k];
+                    if(last && array){
+                        cur->set<AData::Array>();
+                        defined[path] = Defined::TableArray;
+                    }else{
+                        cur->set<AData::Object>();
+                        defined[path] = last ? Defined::Header : Defined::Implicit;
                     }
-                }else if constexpr(toml::is_array<T>) {
-                    const toml::array & tarr = *f.table->as_array();
-                    f.node->set<darray_t>();
-                    auto & arr = f.node->array();
-                    arr.ensure(tarr.size());
-                    for(size_t i = 0;i < tarr.size();++i){
-                        frames.emplace_back(&arr[i],&tarr[i]);
+                }else{
+                    cur = &it.second();
+                    Defined d = lookup(path);
+                    if(last){
+                        if(array){
+                            if(d != Defined::TableArray){
+                                fail("cannot append to a value or a static array");
+                                return nullptr;
+                            }
+                        }else if(d == Defined::Implicit){
+                            defined[path] = Defined::Header;
+                        }else{
+                            fail("table defined twice");
+                            return nullptr;
+                        }
+                    }else if(d == Defined::TableArray){
+                        // 进入数组的最后一个表
+                        auto& arr = cur->array();
+                        push_index(path, arr.size() - 1);
+                        cur = &arr.values.back();
+                    }else if(d == Defined::None || !cur->is_object()){
+                        fail("cannot define a table inside a value or an inline table");
+                        return nullptr;
                     }
                 }
-            });
+            }
+            if(array){
+                auto& arr = cur->array();
+                push_index(path, arr.size());
+                cur = &arr.values.emplace_back(cur->get_allocator());
+                cur->set<AData::Object>();
+            }
+            return cur;
+        }
+
+        bool read_digits(std::string& out, int base){
+            // 下划线两侧都必须是数字
+            auto valid = [base](char c){
+                if(base == 16)return is_digit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+                return c >= '0' && c < '0' + base;
+            };
+            if(!valid(peek()))return fail("expected a digit");
+            while(true){
+                out.push_back(src[pos++]);
+                if(peek() == '_'){
+                    ++pos;
+                    if(!valid(peek()))return fail("underscores must be surrounded by digits");
+                }else if(!valid(peek())){
+                    return true;
+                }
+            }
+        }
+
+        bool read_number(AData& node){
+            scratch.clear();
+            const size_t start = pos;
+            char sign = 0;
+            if(peek() == '+' || peek() == '-')sign = src[pos++];
+
+            if(starts("inf") || starts("nan")){
+                double v = peek() == 'i' ? std::numeric_limits<double>::infinity() : std::numeric_limits<double>::quiet_NaN();
+                pos += 3;
+                node = sign == '-' ? -v : v;
+                return true;
+            }
+
+            if(!sign && peek() == '0' && (peek(1) == 'x' || peek(1) == 'o' || peek(1) == 'b')){
+                int base = peek(1) == 'x' ? 16 : peek(1) == 'o' ? 8 : 2;
+                pos += 2;
+                if(!read_digits(scratch, base))return false;
+                int64_t v = 0;
+                auto r = std::from_chars(scratch.data(), scratch.data() + scratch.size(), v, base);
+                if(r.ec != std::errc())return fail("integer out of range");
+                node = v;
+                return true;
+            }
+
+            if(sign)scratch.push_back(sign);
+            size_t int_begin = scratch.size();
+            if(!read_digits(scratch, 10))return false;
+            if(scratch.size() - int_begin > 1 && scratch[int_begin] == '0'){
+                pos = start;
+                return fail("leading zeros are not allowed");
+            }
+
+            bool floating = false;
+            if(peek() == '.'){
+                ++pos;
+                scratch.push_back('.');
+                if(!read_digits(scratch, 10))return false;
+                floating = true;
+            }
+            if(peek() == 'e' || peek() == 'E'){
+                ++pos;
+                scratch.push_back('e');
+                if(peek() == '+' || peek() == '-')scratch.push_back(src[pos++]);
+                if(!read_digits(scratch, 10))return false;
+                floating = true;
+            }
+
+            // from_chars不接受前导'+'
+            const char* b = scratch.data() + (sign == '+' ? 1 : 0);
+            const char* e = scratch.data() + scratch.size();
+            if(floating){
+                double v = 0;
+                auto r = std::from_chars(b, e, v);
+                if(r.ec == std::errc::result_out_of_range){
+                    // 指数为负是下溢,否则是上溢
+                    size_t exp = scratch.find('e');
+                    bool under = exp != std::string::npos && scratch[exp + 1] == '-';
+                    v = under ? 0.0 : std::numeric_limits<double>::infinity();
+                    if(sign == '-')v = -v;
+                }else if(r.ec != std::errc()){
+                    return fail("bad float");
+                }
+                node = v;
+            }else{
+                int64_t v = 0;
+                auto r = std::from_chars(b, e, v);
+                if(r.ec != std::errc())return fail("integer out of range");
+                node = v;
+            }
+            return true;
+        }
+
+        bool expect_digits(size_t n){
+            for(size_t i = 0;i < n;++i){
+                if(!is_digit(peek(i)))return fail("malformed date or time");
+            }
+            return true;
+        }
+
+        /// HH:MM:SS(.frac)?
+        bool read_time(){
+            if(!expect_digits(2) || peek(2) != ':')return fail("malformed time");
+            pos += 3;
+            if(!expect_digits(2) || peek(2) != ':')return fail("malformed time");
+            pos += 3;
+            if(!expect_digits(2))return false;
+            pos += 2;
+            if(peek() == '.'){
+                ++pos;
+                if(!expect_digits(1))return false;
+                while(is_digit(peek()))++pos;
+            }
+            return true;
+        }
+
+        /// 日期时间没有对应的AData类型,保留为字符串,分隔符统一为'T'
+        bool read_datetime(AData& node){
+            const size_t start = pos;
+            bool has_date = peek(4) == '-';
+            if(has_date){
+                if(!expect_digits(4) || peek(4) != '-')return false;
+                pos += 5;
+                if(!expect_digits(2) || peek(2) != '-')return fail("malformed date");
+                pos += 3;
+                if(!expect_digits(2))return false;
+                pos += 2;
+                char sep = peek();
+                if(sep == 'T' || sep == 't' || (sep == ' ' && is_digit(peek(1)) && is_digit(peek(2)) && peek(3) == ':')){
+                    ++pos;
+                }else{
+                    node = src.substr(start, pos - start);
+                    return true;
+                }
+            }
+            if(!read_time())return false;
+            if(has_date){
+                if(peek() == 'Z' || peek() == 'z'){
+                    ++pos;
+                }else if(peek() == '+' || peek() == '-'){
+                    ++pos;
+                    if(!expect_digits(2) || peek(2) != ':')return fail("malformed time offset");
+                    pos += 3;
+                    if(!expect_digits(2))return false;
+                    pos += 2;
+                }
+            }
+            scratch.assign(src.data() + start, pos - start);
+            if(has_date)scratch[10] = 'T';
+            if(scratch.back() == 'z')scratch.back() = 'Z';
+            node = std::string_view(scratch);
+            return true;
+        }
+
+        bool read_scalar(AData& node){
+            char c = peek();
+            if(c == '"' || c == '\''){
+                std::string_view v;
+                if(!read_string(v))return false;
+                node = v;
+                return true;
+            }
+            if(starts("true")){
+                pos += 4;
+                node = true;
+                return true;
+            }
+            if(starts("false")){
+                pos += 5;
+                node = false;
+                return true;
+            }
+            if(is_digit(c) && is_digit(peek(1))
+                && ((is_digit(peek(2)) && is_digit(peek(3)) && peek(4) == '-') || peek(2) == ':')){
+                return read_datetime(node);
+            }
+            if(is_digit(c) || c == '+' || c == '-' || c == 'i' || c == 'n')return read_number(node);
+            return fail("expected a value");
         }
-    }catch(const toml::parse_error & err){
-        return false;
+
+        /**
+         * 读取一个值到node(空节点),数组和内联表用显式栈处理
+         * path为node的路径,内联表里的点分键需要它
+         */
+        bool read_value(AData& node, std::string& path){
+            struct Frame{
+                AData* node;
+                size_t path_len;
+                bool table;
+            };
+            std::vector<Frame> frames;
+            AData* slot = &node;
+
+            // 内联表中的下一个键值对,返回待填的节点
+            auto inline_entry = [&](Frame& f) -> AData* {
+                if(!read_key())return nullptr;
+                if(peek() != '='){
+                    fail("expected '='");
+                    return nullptr;
+                }
+                ++pos;
+                skip_ws();
+                path.resize(f.path_len);
+                return define_dotted(*f.node, path);
+            };
+
+            while(true){
+                char c = peek();
+                bool closed = false;
+                if(c == '['){
+                    ++pos;
+                    slot->set<AData::Array>();
+                    frames.push_back(Frame{slot, path.size(), false});
+                    if(!skip_ws_lines())return false;
+                    if(peek() == ']'){
+                        ++pos;
+                        frames.pop_back();
+                        closed = true;
+                    }else{
+                        push_index(path, 0);
+                        slot = &slot->array().values.emplace_back(slot->get_allocator());
+                    }
+                }else if(c == '{'){
+                    ++pos;
+                    slot->set<AData::Object>();
+                    frames.push_back(Frame{slot, path.size(), true});
+                    skip_ws();
+                    if(peek() == '}'){
+                        ++pos;
+                        frames.pop_back();
+                        closed = true;
+                    }else if(!(slot = inline_entry(frames.back()))){
+                        return false;
+                    }
+                }else{
+                    if(!read_scalar(*slot))return false;
+                    closed = true;
+                }
+                if(!closed)continue;
+
+                // 一个值结束,处理分隔符,可能连续关闭多层
+                while(!frames.empty()){
+                    Frame& f = frames.back();
+                    if(!f.table){
+                        if(!skip_ws_lines())return false;
+                        if(peek() == ','){
+                            ++pos;
+                            if(!skip_ws_lines())return false;
+                            if(peek() != ']'){
+                                auto& arr = f.node->array();
+                                path.resize(f.path_len);
+                                push_index(path, arr.size());
+                                slot = &arr.values.emplace_back(f.node->get_allocator());
+                                break;
+                            }
+                        }
+                        if(peek() != ']')return fail("expected ',' or ']'");
+                        ++pos;
+                    }else{
+                        skip_ws();
+                        if(peek() == ','){
+                            ++pos;
+                            skip_ws();
+                            if(!(slot = inline_entry(f)))return false;
+                            break;
+                        }
+                        if(peek() != '}')return fail("expected ',' or '}'");
+                        ++pos;
+                    }
+                    path.resize(f.path_len);
+                    frames.pop_back();
+                }
+                if(frames.empty())return true;
+            }
+        }
+
+        bool read_document(AData& root){
+            AData* table = &root;
+            std::string table_path;
+            std::string value_path;
+
+            // UTF-8 BOM
+            if(starts("\xEF\xBB\xBF"))pos += 3;
+
+            while(true){
+                skip_ws();
+                if(eof())return true;
+                char c = src[pos];
+                if(c == '#' || c == '\n' || c == '\r'){
+                    if(!end_of_line())return false;
+                    continue;
+                }
+                if(c == '['){
+                    bool array = peek(1) == '[';
+                    pos += array ? 2 : 1;
+                    if(!read_key())return false;
+                    if(peek() != ']' || (array && peek(1) != ']'))return fail(array ? "expected ']]'" : "expected ']'");
+                    pos += array ? 2 : 1;
+                    if(!(table = open_table(root, table_path, array)))return false;
+                }else{
+                    if(!read_key())return false;
+                    if(peek() != '=')return fail("expected '='");
+                    ++pos;
+                    skip_ws();
+                    value_path = table_path;
+                    AData* node = define_dotted(*table, value_path);
+                    if(!node || !read_value(*node, value_path))return false;
+                }
+                if(!end_of_line())return false;
+            }
+        }
+    };
+
+    /// 输出缓冲,fn为空时直接写入目标字符串,否则攒够chunk再回调一次
+    template<class Out>
+    struct TOMLWriter{
+        Out& out;
+        TOML::__dump_fn* fn;
+        void* p;
+        size_t chunk;
+
+        inline void put(std::string_view s){ out.append(s); }
+        inline void put(char c){ out.push_back(c); }
+
+        inline void commit(){
+            if(fn && out.size() >= chunk){
+                fn(out, p);
+                out.clear();
+            }
+        }
+
+        inline void finish(){
+            if(fn && !out.empty()){
+                fn(out, p);
+                out.clear();
+            }
+        }
+
+        void put_int(int64_t v){
+            char tmp[24];
+            auto r = std::to_chars(tmp, tmp + sizeof(tmp), v);
+            out.append(tmp, r.ptr);
+        }
+
+        void put_double(double v, int precision){
+            if(std::isnan(v)){
+                put("nan");
+                return;
+            }
+            if(std::isinf(v)){
+                put(v < 0 ? "-inf" : "inf");
+                return;
+            }
+            detail::text_write_finite_float(out, v, precision, true);
+        }
+
+        /// 基本字符串,非ASCII字符原样输出
+        void put_string(std::string_view s){
+            static constexpr char hex[] = "0123456789ABCDEF";
+            put('"');
+            size_t run = 0;
+            for(size_t i = 0;i < s.size();++i){
+                uint8_t c = (uint8_t)s[i];
+                if(c >= 0x20 && c != '"' && c != '\\' && c != 0x7F) [[likely]] continue;
+                out.append(s.data() + run, i - run);
+                run = i + 1;
+                switch(c){
+                case '"': put("\\\""); break;
+                case '\\': put("\\\\"); break;
+                case '\b': put("\\b"); break;
+                case '\t': put("\\t"); break;
+                case '\n': put("\\n"); break;
+                case '\f': put("\\f"); break;
+                case '\r': put("\\r"); break;
+                default: {
+                    char tmp[6] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xF]};
+                    out.append(tmp, 6);
+                    break;
+                }
+                }
+            }
+            out.append(s.data() + run, s.size() - run);
+            put('"');
+        }
+
+        void put_key(std::string_view key){
+            bool bare = !key.empty();
+            for(char c : key){
+                if(!bare_key_chars[(uint8_t)c]){
+                    bare = false;
+                    break;
+                }
+            }
+            if(bare)put(key);
+            else put_string(key);
+        }
+    };
+
+    /// 非空且元素全是对象的数组写成[[header]]
+    inline bool is_table_array(const dadata_t& node){
+        if(!node.is_array() || node.array().empty())return false;
+        for(auto& v : node.array()){
+            if(!v.is_object())return false;
+        }
+        return true;
+    }
+
+    struct DumpState{
+        const TOMLConfig& cfg;
+        TOML::DumpResult rt { TOML::Success };
+
+        void null_skipped(std::string_view key){
+            if(cfg.warn_when_null){
+                invoke_error(err_dump_error, "TOML has no null, skipped the null node {}!", key);
+            }
+            rt = TOML::EncounteredNull;
+        }
+    };
+
+    /// 内联的值: 标量,数组和内联表,显式栈展开
+    template<class Out>
+    void dump_inline(DumpState& st, TOMLWriter<Out>& w, const dadata_t& root){
+        struct Item{
+            const dadata_t* node;
+            std::string_view key;
+            bool has_key;
+            bool separator;
+            char close;     ///< 非0时只写这个结束符
+        };
+        std::vector<Item> items;
+        std::vector<Item> children;
+        items.push_back(Item{&root, {}, false, false, 0});
+
+        while(!items.empty()){
+            Item it = items.back();
+            items.pop_back();
+            if(it.close){
+                if(it.close == '}')w.put(" }");
+                else w.put(']');
+                continue;
+            }
+            if(it.separator)w.put(", ");
+            if(it.has_key){
+                w.put_key(it.key);
+                w.put(" = ");
+            }
+
+            const dadata_t& n = *it.node;
+            if(n.is_value()){
+                auto& v = n.value();
+                switch(v.get_type()){
+                case dvalue_t::INT:
+                    w.put_int(v.to<int64_t>());
+                    break;
+                case dvalue_t::BOOL:
+                    w.put(v.to<bool>() ? "true" : "false");
+                    break;
+                case dvalue_t::FLOATING:
+                    w.put_double(v.to<double>(), st.cfg.float_precision);
+                    break;
+                case dvalue_t::STRING:
+                    w.put_string(v.raw_view());
+                    break;
+                }
+                continue;
+            }
+
+            // 先收集非null的子节点再倒序入栈
+            children.clear();
+            if(n.is_array()){
+                for(auto& v : n.array()){
+                    if(v.is_null())st.null_skipped("in an array");
+                    else children.push_back(Item{&v, {}, false, !children.empty(), 0});
+                }
+            }else if(n.is_object()){
+                for(auto proxy : n.object()){
+                    if(proxy.second().is_null())st.null_skipped(proxy.first());
+                    else children.push_back(Item{&proxy.second(), proxy.first(), true, !children.empty(), 0});
+                }
+            }
+            if(n.is_array() || children.empty()){
+                w.put(n.is_array() ? "[" : "{");
+                if(children.empty()){
+                    w.put(n.is_array() ? "]" : "}");
+                    continue;
+                }
+                items.push_back(Item{nullptr, {}, false, false, ']'});
+            }else{
+                w.put("{ ");
+                items.push_back(Item{nullptr, {}, false, false, '}'});
+            }
+            for(size_t i = children.size();i > 0;--i)items.push_back(children[i - 1]);
+        }
+    }
+
+    template<class Out>
+    TOML::DumpResult dump_impl(const TOMLConfig& cfg, TOMLWriter<Out>& w, const dadata_t& root){
+        if(!root.is_object()){
+            invoke_error(err_dump_error, "Only objects can be dumped as a TOML document!");
+            return TOML::RootNotTable;
+        }
+
+        struct Table{
+            const dadata_t* node;
+            std::string header;
+            bool element;
+        };
+        struct Sub{
+            std::string_view key;
+            const dadata_t* node;
+        };
+        DumpState st { cfg };
+        std::vector<Table> tables;
+        std::vector<Sub> subs;
+        bool written = false;
+        tables.push_back(Table{&root, {}, false});
+
+        while(!tables.empty()){
+            Table t = std::move(tables.back());
+            tables.pop_back();
+
+            bool header_done = t.header.empty();
+            auto put_header = [&]{
+                if(header_done)return;
+                header_done = true;
+                if(written)w.put('\n');
+                w.put(t.element ? "[[" : "[");
+                w.put(t.header);
+                w.put(t.element ? "]]\n" : "]\n");
+                written = true;
+            };
+            if(t.element)put_header();
+
+            // 表头之后必须先写完所有普通键
+            subs.clear();
+            for(auto proxy : t.node->object()){
+                const dadata_t& v = proxy.second();
+                if(v.is_object() || is_table_array(v)){
+                    subs.push_back(Sub{proxy.first(), &v});
+                    continue;
+                }
+                if(v.is_null()){
+                    st.null_skipped(proxy.first());
+                    continue;
+                }
+                put_header();
+                w.put_key(proxy.first());
+                w.put(" = ");
+                dump_inline(st, w, v);
+                w.put('\n');
+                w.commit();
+                written = true;
+            }
+            // 只有子表的表不需要自己的表头
+            if(subs.empty())put_header();
+            w.commit();
+
+            for(size_t i = subs.size();i > 0;--i){
+                const Sub& s = subs[i - 1];
+                std::string header = t.header;
+                if(!header.empty())header.push_back('.');
+                TOMLWriter<std::string> kw { header, nullptr, nullptr, 0 };
+                kw.put_key(s.key);
+                if(s.node->is_object()){
+                    tables.push_back(Table{s.node, std::move(header), false});
+                }else{
+                    auto& arr = s.node->array();
+                    for(size_t j = arr.size();j > 0;--j){
+                        tables.push_back(Table{&arr[j - 1], header, true});
+                    }
+                }
+            }
+        }
+        w.finish();
+        return st.rt;
     }
-    return true;
 }
 
-void ALIB5_API TOML::__internal_dump(__dump_fn fn,void * p,const dadata_t & root){
-    bool im_lazy_and_dont_want_to_implement_this_useless_feature_now = true;
-    panic_if(im_lazy_and_dont_want_to_implement_this_useless_feature_now,"TOML Dump is forbidden.");
-}
\ No newline at end of file
+bool TOML::parse(std::string_view data,dadata_t & node){
+    node.set<dadata_t::Object>();
+    TOMLReader reader(data);
+    if(reader.read_document(node))return true;
+
+    size_t line = 1;
+    size_t column = 1;
+    for(size_t i = 0;i < reader.error_pos && i < data.size();++i){
+        if(data[i] == '\n'){
+            ++line;
+            column = 1;
+        }else ++column;
+    }
+    invoke_error(err_format_error, "Failed to parse TOML at line {} column {}: {}!", line, column, reader.error);
+    return false;
+}
+
+TOML::DumpResult TOML::__internal_dump(__dump_fn fn,void * p,const dadata_t & root){
+    // 和JSON一样每次dump一个缓冲,可以重入,也不会一直占着最大的容量
+    std::pmr::string chunk (ALIB5_DEFAULT_MEMORY_RESOURCE);
+    chunk.reserve(cfg.dump_chunk_size);
+    TOMLWriter<std::pmr::string> w { chunk, fn, p, cfg.dump_chunk_size };
+    return dump_impl(cfg, w, root);
+}
+
+TOML::DumpResult TOML::__internal_dump(std::string & out,const dadata_t & root){
+    TOMLWriter<std::string> w { out, nullptr, nullptr, 0 };
+    return dump_impl(cfg, w, root);
+}
+
+TOML::DumpResult TOML::__internal_dump(std::pmr::string & out,const dadata_t & root){
+    TOMLWriter<std::pmr::string> w { out, nullptr, nullptr, 0 };
+    return dump_impl(cfg, w, root);
+}
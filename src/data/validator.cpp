@@ -1,8 +1,15 @@
 #include <alib5/adata.h>
+#include <memory_resource>
+#include <algorithm>
+#include <span>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
 
 using namespace alib5;
 
-static std::pair<bool,Validator::Node::TypeRestrict> simp_validate_type(const dadata_t & doc,Validator::Node & node){
+static std::pair<bool,Validator::Node::TypeRestrict> simp_validate_type(const dadata_t & doc,Validator::Node::TypeRestrict expect){
     using enum Validator::Node::TypeRestrict;
     using enum dadata_t::Type;
     using enum Value::Type;
@@ -34,11 +41,11 @@ static std::pair<bool,Validator::Node::TypeRestrict> simp_validate_type(const da
         }
         break;
     }
-    if(node.type_restrict == RNone)return {true,ext != RNone ? ext : data_type};
+    if(expect == RNone)return {true,ext != RNone ? ext : data_type};
 
-    if(data_type == node.type_restrict){
+    if(data_type == expect){
         return { true , data_type};
-    }else if(ext == node.type_restrict){
+    }else if(ext == expect){
         return { true , ext};
     }
     return {false,ext != RNone ? ext : data_type};
@@ -84,6 +91,7 @@ bool ALIB5_API Validator::validate(dadata_t & doc,Result & result,bool ignore_mi
     int depth = 0;
 
     while(!frames.empty()){
+        if(!success && result.stop_at_first)break;
         auto [d,n,key,index] = frames.back();
         frames.pop_back();
 
@@ -128,7 +136,7 @@ bool ALIB5_API Validator::validate(dadata_t & doc,Result & result,bool ignore_mi
             /// 因为隐式转换静止,因此确保一下是NULL 
             *d = *n->default_value;
         }else if(!d->is_null() || (!n->array_subs.size() && !n->children.size())){
-            auto type_check = simp_validate_type(*d, *n);
+            auto type_check = simp_validate_type(*d, n->type_restrict);
             // std::cout << n->min_length.to<std::string>() << "DUMP" << d->str() << "DUMP\n" << std::endl;       
             // std::cout << "MATCHING " << 
             //        node_type_str(n->type_restrict) << " " <<
@@ -239,6 +247,7 @@ bool ALIB5_API Validator::validate(dadata_t & doc,Result & result,bool ignore_mi
                 if(it != validates.end()){
                     if(!it->second(*d,method.args)){
                         fail = true;
+                        success = false;
                         if(result.enable_string_errors){
                             result.record_error(
                                 "{} : Validation({}) failed.",
@@ -310,12 +319,12 @@ bool ALIB5_API Validator::validate(dadata_t & doc,Result & result,bool ignore_mi
                             // std::cout << "GENN ARR " << k << std::endl;
                             obj[k].set<darray_t>();
                             auto it = obj.find(k);
-                            object_next.emplace_back(it.it->second,k,&v);
+                            object_next.emplace_back(it.index(),k,&v);
                         }else if(v.type_restrict == Node::RObject){
                             obj[k].set<dobject_t>();
                             // 因为上面的旧的it不支持copy operator
                             auto it = obj.find(k);
-                            object_next.emplace_back(it.it->second,k,&v);
+                            object_next.emplace_back(it.index(),k,&v);
                         }else if(v.required){
                             if(result.enable_string_errors)result.record_error(
                                 "{} : Required child {},but missing",
@@ -329,7 +338,7 @@ bool ALIB5_API Validator::validate(dadata_t & doc,Result & result,bool ignore_mi
                     }
                 }else{
                     // 先不急,这个也要确保引用一致
-                    object_next.emplace_back(it.it->second,k,&v);
+                    object_next.emplace_back(it.index(),k,&v);
                 }
             }
             /// 因为前面有输出,所以push_vis需要靠后
@@ -348,6 +357,707 @@ bool ALIB5_API Validator::validate(dadata_t & doc,Result & result,bool ignore_mi
 }
     
 
+Validator::Program ALIB5_API Validator::compile(std::pmr::memory_resource * __a) const{
+    Program prog(__a ? __a : allocator);
+    // 每个Node展开成一个Op,子节点的Op先占位,出栈时再填
+    struct Job{
+        const Node * n;
+        uint32_t op;
+        size_t depth;
+        size_t slots;
+    };
+    std::vector<Job> jobs;
+    prog.ops.emplace_back();
+    jobs.emplace_back(&root,0,1,root.children.size());
+
+    // MIN/MAX可能是空串(无限制),也可能是TUPLE写入的整数
+    auto has_bound = [](const dvalue_t & v){
+        return v.get_type() != Value::STRING || v.to<std::string_view>() != "";
+    };
+
+    while(!jobs.empty()){
+        auto [n,index,depth,slots] = jobs.back();
+        jobs.pop_back();
+        prog.max_depth = std::max(prog.max_depth,depth);
+        prog.max_slots = std::max(prog.max_slots,slots);
+
+        Program::Op op {};
+        op.type = n->type_restrict;
+        op.required = n->required;
+        op.override_if_conflict = n->override_if_conflict;
+        op.is_tuple = n->is_tuple;
+        op.has_min = has_bound(n->min_length);
+        op.has_max = has_bound(n->max_length);
+        if(op.has_min){
+            op.min_size = n->min_length.to<int>();
+            op.min_value = n->min_length.to<double>();
+        }
+        if(op.has_max){
+            op.max_size = n->max_length.to<int>();
+            op.max_value = n->max_length.to<double>();
+        }
+        op.default_index = -1;
+        if(n->default_value){
+            op.default_index = (int32_t)prog.defaults.size();
+            prog.defaults.emplace_back(*n->default_value);
+        }
+
+        op.enum_begin = prog.enums.size();
+        op.enum_count = n->enums.size();
+        for(auto & e : n->enums)prog.enums.emplace_back(e);
+        std::sort(prog.enums.begin() + op.enum_begin,prog.enums.end());
+
+        op.call_begin = prog.calls.size();
+        op.call_count = n->validates.size();
+        for(auto & v : n->validates){
+            auto & call = prog.calls.emplace_back(
+                std::pmr::string(v.method,prog.allocator),
+                ValidateMethod(),
+                std::pmr::vector<std::pmr::string>(v.args,prog.allocator)
+            );
+            auto it = validates.find(v.method);
+            if(it != validates.end())call.fn = it->second;
+        }
+
+        op.member_begin = prog.members.size();
+        op.member_count = n->children.size();
+        for(auto & [k,v] : n->children){
+            uint32_t child = prog.ops.size();
+            prog.ops.emplace_back();
+            prog.members.emplace_back(
+                std::pmr::string(k,prog.allocator),
+                dadata_t::Object::hash_key(k),
+                child
+            );
+            jobs.emplace_back(&v,child,depth + 1,slots + v.children.size());
+        }
+
+        op.sub_begin = prog.subs.size();
+        op.sub_count = n->array_subs.size();
+        for(auto & v : n->array_subs){
+            uint32_t child = prog.ops.size();
+            prog.ops.emplace_back();
+            prog.subs.push_back(child);
+            jobs.emplace_back(&v,child,depth + 1,slots + v.children.size());
+        }
+
+        prog.ops[index] = op;
+    }
+    return prog;
+}
+
+namespace{
+    using Program = Validator::Program;
+    using Result = Validator::Result;
+    using Node = Validator::Node;
+
+    struct ParallelState;
+
+    /// 并行模式下的一个任务:一个子树,或者大数组中的一段元素
+    struct ParallelTask{
+        dadata_t * node;
+        darray_t * values; ///< 区间任务要访问的数组,拆分时就取好,任务里不再对node做非const访问
+        uint32_t op;
+        bool range;
+        size_t begin;
+        size_t end;
+        std::pmr::string prefix; ///< 任务起点在文档中的路径
+        std::vector<int64_t> prefix_steps; ///< 同上,compact_paths的格式
+        Result result;
+        
+        struct Split{
+            size_t errors;  ///< 拆出子任务时result里已有的错误数,合并时子任务的错误插在这个位置
+            size_t compacts;
+            size_t task;
+        };
+        std::vector<Split> splits;
+
+        ParallelTask(dadata_t * n,darray_t * a,uint32_t o,bool r,size_t b,size_t e,std::string_view p,std::vector<int64_t> && ps)
+        : node(n), values(a), op(o), range(r), begin(b), end(e), prefix(p), prefix_steps(std::move(ps)) {}
+    };
+
+    /// Program的一次遍历,增量与并行模式通过下面的几个指针挂进来
+    struct ProgramWalker{
+        // 每一层一个帧,next是下一个要访问的元素/成员,数组不会一次性把所有元素压栈
+        struct Frame{
+            dadata_t * d;
+            uint32_t op;
+            size_t next;
+            size_t end;
+            size_t slot_base;
+            std::string_view key;
+            int64_t index;
+            uint32_t member; ///< 在Program::members中的位置,不是成员时无意义
+            darray_t * range; ///< 其他任务也在访问的数组,由split_array取好,不能再对d做非const访问
+        };
+
+        const Program & prog;
+        Result & result;
+        bool ignore_missing;
+        std::string_view prefix;
+        std::span<const int64_t> prefix_steps;
+        std::pmr::vector<Frame> frames;
+        std::pmr::vector<uint32_t> slots;
+        std::pmr::string gen_loc;
+        bool success { true };
+
+        /// 增量模式:已经通过校验的(op,子树哈希)
+        const std::pmr::unordered_set<uint64_t> * memo { nullptr };
+        /// 增量模式:本次完整校验过的容器,以及进入之前它的负载是否已经泄漏
+        struct Visited{
+            dadata_t * node;
+            uint32_t op;
+            bool was_leaked;
+        };
+        std::vector<Visited> * visited { nullptr };
+        /// 并行模式
+        ParallelState * par { nullptr };
+        ParallelTask * task { nullptr };
+
+        ProgramWalker(const Program & p,Result & r,bool im,std::pmr::memory_resource * stack)
+        : prog(p), result(r), ignore_missing(im), frames(stack), slots(stack), gen_loc(p.allocator) {
+            frames.reserve(p.max_depth + 1);
+            slots.reserve(p.max_slots);
+        }
+
+        // 只有出错的时候才生成路径
+        std::string_view location(){
+            gen_loc = prefix;
+            for(size_t i = 1;i < frames.size();++i){
+                if(frames[i].index >= 0){
+                    gen_loc.push_back('[');
+                    gen_loc += ext::to_string(frames[i].index);
+                    gen_loc.push_back(']');
+                }else{
+                    gen_loc.push_back('.');
+                    gen_loc += frames[i].key;
+                }
+            }
+            if(gen_loc.empty())gen_loc.push_back('.');
+            return gen_loc;
+        }
+
+        /// 路径的compact形式,数组下标原样保存,成员保存为-(member + 1)
+        template<class Out>
+        void steps(Out & out){
+            out.insert(out.end(),prefix_steps.begin(),prefix_steps.end());
+            for(size_t i = 1;i < frames.size();++i){
+                if(frames[i].index >= 0)out.push_back(frames[i].index);
+                else out.push_back(-(int64_t)frames[i].member - 1);
+            }
+        }
+
+        /// 每个错误点都会调用,字符串错误由调用者自己格式化
+        void fail(Result::ErrorCode code,uint32_t detail = 0,double actual = 0){
+            success = false;
+            result.success = false;
+            if(!result.enable_compact_errors)return;
+            size_t begin = result.compact_paths.size();
+            steps(result.compact_paths);
+            result.compact_errors.push_back({
+                code,
+                frames.back().op,
+                detail,
+                (uint32_t)begin,
+                (uint32_t)(result.compact_paths.size() - begin),
+                actual
+            });
+        }
+
+        inline bool stopped() const { return !success && result.stop_at_first; }
+
+        static std::string bound_str(bool has,auto v,std::string_view none){
+            return has ? std::format("{}",v) : std::string(none);
+        }
+
+        /// 校验栈顶的节点,返回true表示这个帧需要继续深入
+        bool enter();
+        /// 把栈顶的帧走完
+        void drain();
+        /// 拆分子树交给其他线程,返回true表示已经拆出去了
+        bool split(dadata_t * child,uint32_t child_op,uint32_t member);
+        void split_array();
+
+        void run(dadata_t & node,uint32_t op){
+            frames.push_back({&node,op,0,SIZE_MAX,0,"",-1,0,nullptr});
+            if(!enter())frames.pop_back();
+            else if(par)split_array();
+            drain();
+        }
+
+        void run_range(dadata_t & node,darray_t & arr,uint32_t op,size_t begin,size_t end){
+            frames.push_back({&node,op,begin,end,0,"",-1,0,&arr});
+            drain();
+        }
+    };
+
+    /// 动态任务队列,任务在遍历中途产生,线程在第一次拆分时才启动
+    struct ParallelState{
+        const Program & prog;
+        bool ignore_missing;
+        size_t threads;
+        const Result & proto;
+        std::deque<ParallelTask> tasks;
+        std::mutex mutex;
+        std::condition_variable cv;
+        size_t next { 0 };
+        size_t running { 0 };
+        /// 放在最后,析构时最先join
+        std::vector<std::jthread> workers;
+
+        ParallelState(const Program & p,bool im,size_t t,const Result & r)
+        : prog(p), ignore_missing(im), threads(t), proto(r) {}
+
+        size_t push(dadata_t * node,darray_t * values,uint32_t op,bool range,size_t begin,size_t end,std::string_view prefix,std::vector<int64_t> && steps){
+            std::lock_guard lock(mutex);
+            size_t id = tasks.size();
+            auto & t = tasks.emplace_back(node,values,op,range,begin,end,prefix,std::move(steps));
+            t.result.enable_string_errors = proto.enable_string_errors;
+            t.result.enable_missing = proto.enable_missing;
+            t.result.enable_compact_errors = proto.enable_compact_errors;
+            t.result.stop_at_first = proto.stop_at_first;
+            if(id && workers.size() + 1 < threads)workers.emplace_back([this]{ work(); });
+            cv.notify_one();
+            return id;
+        }
+
+        void execute(ParallelTask & t){
+            alignas(std::max_align_t) std::byte stack_buffer[Program::inline_stack_bytes];
+            std::pmr::monotonic_buffer_resource stack_res(stack_buffer,sizeof(stack_buffer));
+            ProgramWalker w(prog,t.result,ignore_missing,&stack_res);
+            w.prefix = t.prefix;
+            w.prefix_steps = t.prefix_steps;
+            w.par = this;
+            w.task = &t;
+            if(t.range)w.run_range(*t.node,*t.values,t.op,t.begin,t.end);
+            else w.run(*t.node,t.op);
+            if(!w.success)t.result.success = false;
+        }
+
+        void work(){
+            std::unique_lock lock(mutex);
+            while(true){
+                cv.wait(lock,[this]{ return next < tasks.size() || running == 0; });
+                if(next >= tasks.size())break;
+                ParallelTask & t = tasks[next++];
+                ++running;
+                lock.unlock();
+                execute(t);
+                lock.lock();
+                --running;
+                if(!running && next == tasks.size())cv.notify_all();
+            }
+        }
+    };
+
+    bool ProgramWalker::enter(){
+        Frame & f = frames.back();
+        dadata_t & d = *f.d;
+        const Program::Op & op = prog.ops[f.op];
+
+        // 增量模式:哈希缓存还在说明上次校验之后没有被改动过
+        if(memo && (d.is_array() || d.is_object())){
+            uint64_t h = std::as_const(d).cached_hash();
+            if(h && memo->contains(detail::hash_combine(h,(uint64_t)f.op * 2 + ignore_missing)))return false;
+        }
+        // 下面的非const访问会把负载标记为泄漏,先记下原来的状态
+        const bool was_leaked = visited && d.payload_leaked();
+
+        // 默认值覆盖
+        if(d.is_null() && op.default_index >= 0){
+            d = prog.defaults[op.default_index];
+        }else if(!d.is_null() || (!op.sub_count && !op.member_count)){
+            auto type_check = simp_validate_type(d,op.type);
+            if(!type_check.first){
+                if(op.override_if_conflict && op.default_index >= 0){
+                    d.rewrite(prog.defaults[op.default_index]);
+                }else{
+                    if(result.enable_string_errors)result.record_error(
+                        "{} : Expected type {},got {}",
+                        location(),
+                        node_type_str(op.type),
+                        node_type_str(type_check.second)
+                    );
+                    fail(Result::TypeMismatch,type_check.second);
+                    return false;
+                }
+            }
+        }else if(op.sub_count){
+            d.set<darray_t>();
+        }else{
+            d.set<dobject_t>();
+        }
+
+        if(d.is_null())return false;
+        if(!d.is_value() || d.value().get_type() == Value::STRING){
+            if(op.enum_count){
+                auto e_begin = prog.enums.begin() + op.enum_begin;
+                auto e_end = e_begin + op.enum_count;
+                auto sv = d.to<std::string_view>();
+                auto it = std::lower_bound(e_begin,e_end,sv,[](std::string_view a,std::string_view b){ return a < b; });
+                if(it == e_end || *it != sv){
+                    if(result.enable_string_errors)result.record_error(
+                        "{} : Expected enum {},got \"{}\"",
+                        location(),
+                        std::span(prog.enums.data() + op.enum_begin,op.enum_count),
+                        sv
+                    );
+                    fail(Result::NotInEnum);
+                    return false;
+                }
+            }
+            if(op.has_min || op.has_max){
+                int64_t sz = 0;
+                if(d.is_array())sz = d.array().size();
+                else if(d.is_object())sz = d.object().size();
+                else sz = d.value().to<std::string_view>().size();
+                if((op.has_min && sz < op.min_size) || (op.has_max && sz > op.max_size)){
+                    if(result.enable_string_errors)result.record_error(
+                        "{} : Expected target size [{},{}],got {}",
+                        location(),
+                        bound_str(op.has_min,op.min_size,"0"),
+                        bound_str(op.has_max,op.max_size,"+inf"),
+                        sz
+                    );
+                    fail(Result::SizeOutOfRange,0,sz);
+                    return false;
+                }
+            }
+        }else if(op.has_min || op.has_max){
+            double actual = d.value().to<double>();
+            if((op.has_min && actual < op.min_value) || (op.has_max && actual > op.max_value)){
+                if(result.enable_string_errors)result.record_error(
+                    "{} : Expected target size [{},{}],got {}",
+                    location(),
+                    bound_str(op.has_min,op.min_value,"-inf"),
+                    bound_str(op.has_max,op.max_value,"+inf"),
+                    actual
+                );
+                fail(Result::ValueOutOfRange,0,actual);
+                return false;
+            }
+        }
+
+        for(uint32_t i = 0;i < op.call_count;++i){
+            Program::Call & call = prog.calls[op.call_begin + i];
+            if(!call.fn){
+                // 已经记录过就不再构造字符串
+                if(result.enable_missing && !result.missings.contains(std::string_view(call.name))){
+                    result.missing_validate(call.name);
+                }
+                continue;
+            }
+            if(!call.fn(d,call.args)){
+                if(result.enable_string_errors)result.record_error(
+                    "{} : Validation({}) failed.",
+                    location(),
+                    std::string_view(call.name)
+                );
+                fail(Result::ValidationFailed,op.call_begin + i);
+                break;
+            }
+        }
+        if(stopped())return false;
+
+        if(visited && (d.is_array() || d.is_object()))visited->push_back({&d,f.op,was_leaked});
+        if(d.is_array())return op.sub_count != 0;
+        if(!d.is_object() || !op.member_count)return false;
+
+        // 先检查REQUIRED并填充默认值,缺项时整个对象都不再深入
+        // 记下的是槽位而不是指针,插入新键之后槽位依然有效
+        auto & obj = d.object();
+        f.slot_base = slots.size();
+        for(uint32_t i = 0;i < op.member_count;++i){
+            const Program::Member & m = prog.members[op.member_begin + i];
+            auto it = obj.find(m.key,m.hash);
+            if(it != obj.end()){
+                slots.push_back(it.index());
+                continue;
+            }
+            slots.push_back(Program::skip_slot);
+            if(ignore_missing)continue;
+            const Program::Op & child = prog.ops[m.op];
+            if(child.default_index >= 0){
+                obj[m.key] = prog.defaults[child.default_index];
+            }else if(child.type == Node::RArray || child.type == Node::RObject){
+                auto [node,slot] = obj.ensure_node(m.key);
+                if(child.type == Node::RArray)node->set<darray_t>();
+                else node->set<dobject_t>();
+                slots.back() = slot;
+            }else if(child.required){
+                if(result.enable_string_errors)result.record_error(
+                    "{} : Required child {},but missing",
+                    location(),
+                    std::string_view(m.key)
+                );
+                fail(Result::RequiredMissing,op.member_begin + i);
+                slots.resize(f.slot_base);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void ProgramWalker::drain(){
+        while(!frames.empty()){
+            if(stopped())return;
+            Frame & f = frames.back();
+            const Program::Op & op = prog.ops[f.op];
+            dadata_t * child = nullptr;
+            uint32_t child_op = 0;
+            std::string_view key;
+            int64_t index = -1;
+            uint32_t member = 0;
+
+            if(f.d->is_array()){
+                auto & arr = f.range ? f.range->values : f.d->array().values;
+                size_t end = op.is_tuple ? std::min<size_t>(arr.size(),op.sub_count) : arr.size();
+                end = std::min(end,f.end);
+                while(f.next < end){
+                    size_t i = f.next++;
+                    uint32_t sub = prog.subs[op.sub_begin + (op.is_tuple ? i : 0)];
+                    int32_t dflt = prog.ops[sub].default_index;
+                    if(arr[i].is_null() && dflt >= 0){
+                        arr[i] = prog.defaults[dflt];
+                        continue;
+                    }
+                    child = &arr[i];
+                    child_op = sub;
+                    index = i;
+                    break;
+                }
+            }else{
+                auto & obj = f.d->object();
+                while(f.next < op.member_count){
+                    uint32_t slot = slots[f.slot_base + f.next];
+                    const Program::Member & m = prog.members[op.member_begin + f.next];
+                    ++f.next;
+                    if(slot == Program::skip_slot)continue;
+                    child = &obj.children.data[slot];
+                    if(par && split(child,m.op,op.member_begin + f.next - 1)){
+                        child = nullptr;
+                        continue;
+                    }
+                    child_op = m.op;
+                    key = m.key;
+                    member = op.member_begin + f.next - 1;
+                    break;
+                }
+            }
+
+            if(!child){
+                if(!f.d->is_array())slots.resize(f.slot_base);
+                frames.pop_back();
+                continue;
+            }
+            frames.push_back({child,child_op,0,SIZE_MAX,0,key,index,member,nullptr});
+            if(!enter())frames.pop_back();
+            else if(par)split_array();
+        }
+    }
+
+    /// 只由对象组成的路径上,容器类型的成员互相独立,整棵子树交给其他线程
+    bool ProgramWalker::split(dadata_t * child,uint32_t child_op,uint32_t member){
+        if(task->range || !(child->is_array() || child->is_object()))return false;
+        for(auto & f : frames)if(f.d->is_array())return false;
+        location();
+        if(gen_loc == ".")gen_loc.clear();
+        gen_loc.push_back('.');
+        gen_loc += prog.members[member].key;
+        std::vector<int64_t> path;
+        steps(path);
+        path.push_back(-(int64_t)member - 1);
+        size_t id = par->push(child,nullptr,child_op,false,0,0,gen_loc,std::move(path));
+        task->splits.push_back({result.recorded_errors.size(),result.compact_errors.size(),id});
+        return true;
+    }
+
+    /// 刚进入的大数组按conf_parallel_validate_chunk切成若干段
+    void ProgramWalker::split_array(){
+        Frame & f = frames.back();
+        const Program::Op & op = prog.ops[f.op];
+        if(!f.d->is_array() || op.is_tuple)return;
+        // 在拆分之前非const访问一次,各个区间任务共用这个数组,只写各自范围内的元素
+        darray_t & arr = f.d->array();
+        size_t n = arr.size();
+        if(n < 2 * conf_parallel_validate_chunk)return;
+        location();
+        if(gen_loc == ".")gen_loc.clear();
+        std::vector<int64_t> path;
+        steps(path);
+        for(size_t b = 0;b < n;b += conf_parallel_validate_chunk){
+            size_t id = par->push(f.d,&arr,f.op,true,b,std::min(n,b + conf_parallel_validate_chunk),gen_loc,std::vector<int64_t>(path));
+            task->splits.push_back({result.recorded_errors.size(),result.compact_errors.size(),id});
+        }
+        frames.pop_back();
+    }
+}
+
+bool ALIB5_API Validator::Program::validate(dadata_t & doc,Result & result,bool ignore_missing) const{
+    if(ops.empty()){
+        result.success = true;
+        return true;
+    }
+    // 栈深度和槽位数量在编译时就已知,放得下就完全不碰堆
+    alignas(std::max_align_t) std::byte stack_buffer[inline_stack_bytes];
+    std::pmr::monotonic_buffer_resource stack_res(stack_buffer,sizeof(stack_buffer));
+    ProgramWalker w(*this,result,ignore_missing,&stack_res);
+    w.run(doc,0);
+    result.success = w.success;
+    return w.success;
+}
+
+bool ALIB5_API Validator::Program::validate_parallel(dadata_t & doc,Result & result,size_t threads,bool ignore_missing) const{
+    if(!threads)threads = std::max<size_t>(1,std::thread::hardware_concurrency());
+    if(threads == 1 || ops.empty())return validate(doc,result,ignore_missing);
+
+    ParallelState state(*this,ignore_missing,threads,result);
+    // 根任务在调用线程上执行,期间拆出的任务由按需启动的线程领取
+    state.push(&doc,nullptr,0,false,0,0,"",{});
+    state.next = 1;
+    state.running = 1;
+    state.execute(state.tasks[0]);
+    {
+        std::lock_guard lock(state.mutex);
+        --state.running;
+    }
+    state.cv.notify_all();
+    state.work();
+    state.workers.clear();
+
+    // 按文档顺序合并,结果与串行校验完全相同
+    struct Cursor{
+        size_t task;
+        size_t error;
+        size_t compact;
+        size_t split;
+    };
+    std::vector<Cursor> stack;
+    stack.push_back({0,0,0,0});
+    const size_t base_errors = result.recorded_errors.size();
+    const size_t base_compacts = result.compact_errors.size();
+    bool success = true;
+    while(!stack.empty()){
+        Cursor & c = stack.back();
+        ParallelTask & t = state.tasks[c.task];
+        bool has_split = c.split < t.splits.size();
+        size_t stop = has_split ? t.splits[c.split].errors : t.result.recorded_errors.size();
+        for(;c.error < stop;++c.error)result.recorded_errors.emplace_back(t.result.recorded_errors[c.error]);
+        stop = has_split ? t.splits[c.split].compacts : t.result.compact_errors.size();
+        for(;c.compact < stop;++c.compact){
+            auto e = t.result.compact_errors[c.compact];
+            auto path = t.result.path_of(e);
+            e.path_begin = result.compact_paths.size();
+            result.compact_paths.insert(result.compact_paths.end(),path.begin(),path.end());
+            result.compact_errors.push_back(e);
+        }
+        if(has_split){
+            size_t child = t.splits[c.split++].task;
+            stack.push_back({child,0,0,0});
+            continue;
+        }
+        if(!t.result.success)success = false;
+        for(auto & m : t.result.missings)result.missing_validate(m);
+        stack.pop_back();
+    }
+    // 每个任务各自在第一个错误处停下,这里只保留文档顺序上的第一个
+    if(result.stop_at_first){
+        if(result.recorded_errors.size() > base_errors + 1)result.recorded_errors.resize(base_errors + 1);
+        if(result.compact_errors.size() > base_compacts + 1){
+            result.compact_errors.resize(base_compacts + 1);
+            auto & e = result.compact_errors.back();
+            result.compact_paths.resize(e.path_begin + e.path_size);
+        }
+    }
+    result.success = success;
+    return success;
+}
+
+bool ALIB5_API Validator::Program::validate_incremental(dadata_t & doc,Incremental & state,Result & result,bool ignore_missing) const{
+    if(state.program != this || state.validated.size() > state.max_entries){
+        state.validated.clear();
+        state.program = this;
+    }
+    if(ops.empty()){
+        result.success = true;
+        return true;
+    }
+    alignas(std::max_align_t) std::byte stack_buffer[inline_stack_bytes];
+    std::pmr::monotonic_buffer_resource stack_res(stack_buffer,sizeof(stack_buffer));
+    std::vector<ProgramWalker::Visited> visited;
+    ProgramWalker w(*this,result,ignore_missing,&stack_res);
+    w.memo = &state.validated;
+    w.visited = &visited;
+    w.run(doc,0);
+    result.success = w.success;
+    if(!w.success)return false;
+
+    // 校验时的引用都已经不在了,原本没有泄漏的负载恢复原状,哈希才能缓存下来;调用者写入过的部分等调用者自己seal()
+    // visited是先序的,封住外层之后内层直接返回
+    for(auto & v : visited){
+        if(!v.was_leaked)v.node->seal();
+    }
+    // 只有校验过的容器哈希被清掉了,重新计算时未改动的子树直接使用缓存
+    doc.structural_hash();
+    for(auto [node,op,was_leaked] : visited){
+        uint64_t h = std::as_const(*node).cached_hash();
+        if(h)state.validated.insert(detail::hash_combine(h,(uint64_t)op * 2 + ignore_missing));
+    }
+    return true;
+}
+
+std::pmr::string ALIB5_API Validator::Program::format_error(const Result & result,const Result::CompactError & error) const{
+    std::pmr::string out(allocator);
+    for(int64_t step : result.path_of(error)){
+        if(step >= 0){
+            out.push_back('[');
+            out += ext::to_string(step);
+            out.push_back(']');
+        }else{
+            out.push_back('.');
+            out += members[-step - 1].key;
+        }
+    }
+    if(out.empty())out.push_back('.');
+
+    const Op & op = ops[error.op];
+    auto it = std::back_inserter(out);
+    switch(error.code){
+    case Result::TypeMismatch:
+        std::format_to(it," : Expected type {},got {}",
+            node_type_str(op.type),
+            node_type_str((Node::TypeRestrict)error.detail)
+        );
+        break;
+    case Result::NotInEnum:
+        std::format_to(it," : Expected enum {}",
+            std::span(enums.data() + op.enum_begin,op.enum_count)
+        );
+        break;
+    case Result::SizeOutOfRange:
+        std::format_to(it," : Expected target size [{},{}],got {}",
+            ProgramWalker::bound_str(op.has_min,op.min_size,"0"),
+            ProgramWalker::bound_str(op.has_max,op.max_size,"+inf"),
+            (int64_t)error.actual
+        );
+        break;
+    case Result::ValueOutOfRange:
+        std::format_to(it," : Expected target size [{},{}],got {}",
+            ProgramWalker::bound_str(op.has_min,op.min_value,"-inf"),
+            ProgramWalker::bound_str(op.has_max,op.max_value,"+inf"),
+            error.actual
+        );
+        break;
+    case Result::ValidationFailed:
+        std::format_to(it," : Validation({}) failed.",std::string_view(calls[error.detail].name));
+        break;
+    case Result::RequiredMissing:
+        std::format_to(it," : Required child {},but missing",std::string_view(members[error.detail].key));
+        break;
+    }
+    return out;
+}
+
 std::pmr::string Validator::from_adata(const AData & doc){
     std::pmr::string errors (allocator);
     Node restriction (allocator);
@@ -610,7 +1320,7 @@ std::pmr::string Validator::from_adata(const AData & doc){
                     if(val.size() >= 3 - vi_offset){
                         if(current->type_restrict != Node::RArray){
                             // 检测默认值是否匹配了schema设置
-                            if(simp_validate_type(val[2 - vi_offset],*current).first){
+                            if(simp_validate_type(val[2 - vi_offset],current->type_restrict).first){
                                 if(current->enums.size() && 
                                     current->enums.find(
                                         val[2-vi_offset].to<std::string_view>()
@@ -0,0 +1,392 @@
+#include <alib5/alogger.h>
+#include <alib5/log/compress.h>
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+using namespace alib5;
+using namespace alib5::lot;
+
+namespace {
+    constexpr size_t min_match = 4;
+    constexpr int hash_bits = 14;
+
+    inline uint32_t read32(const char * p){
+        uint32_t v;
+        memcpy(&v,p,sizeof(v));
+        return v;
+    }
+
+    inline uint32_t hash4(uint32_t v){
+        return (v * 2654435761u) >> (32 - hash_bits);
+    }
+
+    inline char * put_length(char * op,size_t len){
+        while(len >= 255){
+            *op++ = (char)255;
+            len -= 255;
+        }
+        *op++ = (char)len;
+        return op;
+    }
+
+    inline char * put_sequence(char * op,const char * lit,size_t lit_len,size_t offset,size_t match_len){
+        size_t ml = match_len ? match_len - min_match : 0;
+        *op++ = (char)(((lit_len < 15 ? lit_len : 15) << 4) | (ml < 15 ? ml : 15));
+        if(lit_len >= 15)op = put_length(op,lit_len - 15);
+        memcpy(op,lit,lit_len);
+        op += lit_len;
+        // 最后一段只有字面量
+        if(!match_len)return op;
+        *op++ = (char)(offset & 0xFF);
+        *op++ = (char)(offset >> 8);
+        if(ml >= 15)op = put_length(op,ml - 15);
+        return op;
+    }
+
+    inline bool read_length(const unsigned char * src,size_t n,size_t & ip,size_t & len){
+        unsigned char b;
+        do{
+            if(ip >= n)return false;
+            b = src[ip++];
+            len += b;
+        }while(b == 255);
+        return true;
+    }
+
+    inline void put_u32(char * p,uint32_t v){
+        memcpy(p,&v,sizeof(v));
+    }
+}
+
+size_t lot::lz_compress(const char * src,size_t n,char * dst){
+    char * op = dst;
+    size_t anchor = 0;
+    size_t i = 0;
+
+    if(n >= min_match + 1){
+        std::vector<uint32_t> table (size_t(1) << hash_bits,0);
+        const size_t limit = n - min_match;
+        while(i < limit){
+            uint32_t cur = read32(src + i);
+            uint32_t h = hash4(cur);
+            size_t cand = table[h];
+            table[h] = (uint32_t)i;
+            if(cand >= i || i - cand > 0xFFFF || read32(src + cand) != cur){
+                // 长时间找不到匹配就跳得快一些
+                i += 1 + ((i - anchor) >> 6);
+                continue;
+            }
+            size_t len = min_match;
+            while(i + len < n && src[cand + len] == src[i + len])++len;
+            op = put_sequence(op,src + anchor,i - anchor,i - cand,len);
+            i += len;
+            anchor = i;
+            // 补一个位置，提高下一次命中率
+            if(i >= 2 && i - 2 + min_match <= n)table[hash4(read32(src + i - 2))] = (uint32_t)(i - 2);
+        }
+    }
+    return put_sequence(op,src + anchor,n - anchor,0,0) - dst;
+}
+
+bool lot::lz_decompress(const char * csrc,size_t n,char * dst,size_t raw_size){
+    auto src = reinterpret_cast<const unsigned char*>(csrc);
+    size_t ip = 0;
+    size_t op = 0;
+    while(ip < n){
+        unsigned char token = src[ip++];
+        size_t lit = token >> 4;
+        if(lit == 15 && !read_length(src,n,ip,lit))return false;
+        if(lit > n - ip || lit > raw_size - op)return false;
+        memcpy(dst + op,src + ip,lit);
+        ip += lit;
+        op += lit;
+        if(ip == n)break;
+
+        if(n - ip < 2)return false;
+        size_t offset = src[ip] | (size_t(src[ip + 1]) << 8);
+        ip += 2;
+        size_t ml = token & 15;
+        if(ml == 15 && !read_length(src,n,ip,ml))return false;
+        ml += min_match;
+        if(!offset || offset > op || ml > raw_size - op)return false;
+        if(offset >= ml){
+            memcpy(dst + op,dst + op - offset,ml);
+        }else{
+            // 重叠的匹配只能逐字节复制
+            for(size_t k = 0;k < ml;++k)dst[op + k] = dst[op + k - offset];
+        }
+        op += ml;
+    }
+    return op == raw_size;
+}
+
+void LZStreamWriter::open(FILE * f){
+    file = f;
+    raw.clear();
+    bytes_out = 0;
+    if(file){
+        fwrite(lz_file_magic,1,sizeof(lz_file_magic),file);
+        bytes_out += sizeof(lz_file_magic);
+    }
+}
+
+void LZStreamWriter::write(std::string_view data){
+    while(!data.empty()){
+        size_t take = std::min(data.size(),lz_block_size - raw.size());
+        raw.append(data.data(),take);
+        data.remove_prefix(take);
+        if(raw.size() == lz_block_size)emit_block();
+    }
+}
+
+void LZStreamWriter::finish(){
+    emit_block();
+}
+
+void LZStreamWriter::emit_block(){
+    if(raw.empty() || !file)return;
+    packed.resize(8 + lz_compress_bound(raw.size()));
+    size_t m = lz_compress(raw.data(),raw.size(),packed.data() + 8);
+    uint32_t stored = 0;
+    // 压不动的块原样存
+    if(m >= raw.size()){
+        memcpy(packed.data() + 8,raw.data(),raw.size());
+        m = raw.size();
+        stored = lz_stored_flag;
+    }
+    put_u32(packed.data(),(uint32_t)raw.size());
+    put_u32(packed.data() + 4,(uint32_t)m | stored);
+    fwrite(packed.data(),1,8 + m,file);
+    bytes_out += 8 + m;
+    raw.clear();
+}
+
+bool lot::lz_compress_file(std::string_view src,std::string_view dst){
+    FILE * in = fopen(std::string(src).c_str(),"rb");
+    if(!in){
+        invoke_error(err_io_error,"Failed to open file {}!",src);
+        return false;
+    }
+    FILE * out = fopen(std::string(dst).c_str(),"wb");
+    if(!out){
+        fclose(in);
+        invoke_error(err_io_error,"Failed to open file {}!",dst);
+        return false;
+    }
+    LZStreamWriter writer;
+    writer.open(out);
+    std::string buf (lz_block_size,'\0');
+    size_t got;
+    while((got = fread(buf.data(),1,buf.size(),in)) > 0){
+        writer.write(std::string_view(buf.data(),got));
+    }
+    writer.finish();
+    bool ok = !ferror(in) && !ferror(out);
+    fclose(in);
+    ok = (fclose(out) == 0) && ok;
+    if(!ok)invoke_error(err_io_error,"Failed to compress {} into {}!",src,dst);
+    return ok;
+}
+
+bool lot::lz_decompress_file(std::string_view src,std::string & out){
+    std::ifstream in (std::string(src),std::ios::binary);
+    if(!in){
+        invoke_error(err_io_error,"Failed to open file {}!",src);
+        return false;
+    }
+    std::string data ((std::istreambuf_iterator<char>(in)),std::istreambuf_iterator<char>());
+    if(data.size() < sizeof(lz_file_magic) || memcmp(data.data(),lz_file_magic,sizeof(lz_file_magic))){
+        invoke_error(err_format_error,"File {} is not a lz file!",src);
+        return false;
+    }
+    size_t pos = sizeof(lz_file_magic);
+    while(data.size() - pos >= 8){
+        uint32_t raw_size,packed_size;
+        memcpy(&raw_size,data.data() + pos,4);
+        memcpy(&packed_size,data.data() + pos + 4,4);
+        bool stored = packed_size & lz_stored_flag;
+        packed_size &= ~lz_stored_flag;
+        if(raw_size > lz_block_size || packed_size > lz_compress_bound(lz_block_size)){
+            invoke_error(err_format_error,"Corrupt block at {} in {}!",pos,src);
+            return false;
+        }
+        // 最后一块写到一半，当作崩溃时丢失的数据
+        if(data.size() - pos - 8 < packed_size)break;
+        const char * block = data.data() + pos + 8;
+        size_t base = out.size();
+        out.resize(base + raw_size);
+        bool ok = stored ? (packed_size == raw_size) : lz_decompress(block,packed_size,out.data() + base,raw_size);
+        if(!ok){
+            out.resize(base);
+            invoke_error(err_format_error,"Corrupt block at {} in {}!",pos,src);
+            return false;
+        }
+        if(stored)memcpy(out.data() + base,block,raw_size);
+        pos += 8 + packed_size;
+    }
+    return true;
+}
+
+namespace {
+    // filepath_fmt里的{...}匹配一串数字，其余原样比较，数字后面紧跟数字字面量时需要回溯
+    bool match_segment(std::string_view fmt,std::string_view name){
+        while(!fmt.empty()){
+            if(fmt.size() >= 2 && (fmt.starts_with("{{") || fmt.starts_with("}}"))){
+                if(name.empty() || name[0] != fmt[0])return false;
+                fmt.remove_prefix(2);
+                name.remove_prefix(1);
+            }else if(fmt[0] == '{'){
+                size_t close = fmt.find('}');
+                if(close == std::string_view::npos)return false;
+                fmt.remove_prefix(close + 1);
+                size_t digits = 0;
+                while(digits < name.size() && name[digits] >= '0' && name[digits] <= '9')++digits;
+                for(size_t n = digits;n >= 1;--n){
+                    if(match_segment(fmt,name.substr(n)))return true;
+                }
+                return false;
+            }else{
+                if(name.empty() || name[0] != fmt[0])return false;
+                fmt.remove_prefix(1);
+                name.remove_prefix(1);
+            }
+        }
+        return name.empty();
+    }
+}
+
+void lot::detail::SegmentJanitor::seed(std::string_view filepath_fmt){
+    namespace fs = std::filesystem;
+    fs::path fmt_path(filepath_fmt);
+    fs::path dir = fmt_path.parent_path();
+    std::string dir_str = dir.string();
+    // 目录本身带格式的话没法扫描
+    if(dir_str.find('{') != std::string::npos)return;
+    std::string name_fmt = fmt_path.filename().string();
+
+    struct Found{
+        std::string path;
+        fs::file_time_type mtime;
+    };
+    std::vector<Found> found;
+    std::error_code ec;
+    for(fs::directory_iterator it(dir.empty() ? fs::path(".") : dir,ec),end;!ec && it != end;it.increment(ec)){
+        if(!it->is_regular_file(ec))continue;
+        std::string name = it->path().filename().string();
+        std::string_view base = name;
+        if(base.ends_with(".lz"))base.remove_suffix(3);
+        if(!match_segment(name_fmt,base))continue;
+        // 和get_current_filepath拼出来的路径保持一致，方便比较
+        std::string path = dir.empty() ? name : (dir / name).string();
+        fs::file_time_type mtime = it->last_write_time(ec);
+        if(ec){
+            ec.clear();
+            continue;
+        }
+        found.push_back({std::move(path),mtime});
+    }
+    std::sort(found.begin(),found.end(),[](const Found & a,const Found & b){ return a.mtime < b.mtime; });
+
+    std::lock_guard<std::mutex> lk(lock);
+    bool queued = false;
+    for(auto & f : found){
+        if(f.path == current)continue;
+        // 上次没来得及压缩的文件(比如进程崩溃)补上
+        if(compress && !f.path.ends_with(".lz")){
+            pending.push_back(std::move(f.path));
+            queued = true;
+        }else keep(std::move(f.path));
+    }
+    enforce_retention();
+    if(queued && !worker.joinable())worker = std::jthread(&SegmentJanitor::run,this);
+    cv.notify_one();
+}
+
+void lot::detail::SegmentJanitor::set_active(std::string path){
+    std::lock_guard<std::mutex> lk(lock);
+    // 之前留下的同名文件已经被截断重用，不再算作保留的文件
+    forget(path);
+    current = std::move(path);
+}
+
+void lot::detail::SegmentJanitor::submit(std::string path){
+    std::lock_guard<std::mutex> lk(lock);
+    if(path == current)current.clear();
+    pending.push_back(std::move(path));
+    // 第一次有活干的时候才起线程
+    if(!worker.joinable())worker = std::jthread(&SegmentJanitor::run,this);
+    cv.notify_one();
+}
+
+void lot::detail::SegmentJanitor::stop(){
+    {
+        std::lock_guard<std::mutex> lk(lock);
+        stopping = true;
+    }
+    cv.notify_one();
+    if(worker.joinable())worker.join();
+}
+
+void lot::detail::SegmentJanitor::keep(std::string path){
+    std::error_code ec;
+    uint64_t size = std::filesystem::file_size(path,ec);
+    if(ec)size = 0;
+    // 同名的旧记录已经被覆盖了
+    forget(path);
+    kept_bytes += size;
+    kept.push_back({std::move(path),size});
+}
+
+void lot::detail::SegmentJanitor::forget(std::string_view path){
+    for(auto it = kept.begin();it != kept.end();){
+        if(it->path == path){
+            kept_bytes -= it->size;
+            it = kept.erase(it);
+        }else ++it;
+    }
+}
+
+void lot::detail::SegmentJanitor::enforce_retention(){
+    std::error_code ec;
+    // 从最旧的开始删
+    while(!kept.empty() && (
+        (retain_count && kept.size() > retain_count) ||
+        (retain_bytes && kept_bytes > retain_bytes)
+    )){
+        std::filesystem::remove(kept.front().path,ec);
+        kept_bytes -= kept.front().size;
+        kept.pop_front();
+    }
+}
+
+void lot::detail::SegmentJanitor::run(){
+    while(true){
+        std::string path;
+        {
+            std::unique_lock<std::mutex> lk(lock);
+            cv.wait(lk,[this]{ return !pending.empty() || stopping; });
+            // 停止前把排队的文件处理完
+            if(pending.empty())return;
+            path = std::move(pending.front());
+            pending.pop_front();
+            // 之前留下的文件在排队期间又被当成当前文件打开了
+            if(path == current)continue;
+        }
+        if(compress){
+            std::error_code ec;
+            std::string packed = path + ".lz";
+            if(lz_compress_file(path,packed)){
+                std::filesystem::remove(path,ec);
+                path = std::move(packed);
+            }else{
+                std::filesystem::remove(packed,ec);
+            }
+        }
+        std::lock_guard<std::mutex> lk(lock);
+        keep(std::move(path));
+        enforce_retention();
+    }
+}
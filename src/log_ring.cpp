@@ -0,0 +1,296 @@
+#include <alib5/log/ring_file.h>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+using namespace alib5;
+using namespace alib5::lot;
+
+namespace {
+    constexpr uint32_t ring_version = 3;
+    constexpr uint32_t flag_wrap = 1;
+
+    inline uint64_t align8(uint64_t v){
+        return (v + 7) & ~uint64_t(7);
+    }
+
+    inline uint64_t checksum_word(uint64_t h,uint64_t w){
+        return (h ^ w) * 0x9E3779B97F4A7C15ull;
+    }
+
+    /// 按8字节一组累积，够用来发现写了一半或者被覆盖的记录；在锁内执行，不能逐字节计算
+    inline uint64_t checksum_feed(uint64_t h,const char * p,size_t n){
+        for(;n >= 8;p += 8,n -= 8){
+            uint64_t w;
+            memcpy(&w,p,8);
+            h = checksum_word(h,w);
+        }
+        if(n){
+            uint64_t w = 0;
+            memcpy(&w,p,n);
+            h = checksum_word(h,w);
+        }
+        return h;
+    }
+
+    inline uint64_t checksum_head(const RingFileRecord & rec){
+        uint64_t h = checksum_word(0xCBF29CE484222325ull,(uint64_t)rec.size | ((uint64_t)rec.flags << 32));
+        return checksum_word(h,rec.seq);
+    }
+
+    /// 最后把高位混到低32位，只保留32位
+    inline uint32_t checksum_final(uint64_t h){
+        h ^= h >> 33;
+        h *= 0xFF51AFD7ED558CCDull;
+        h ^= h >> 33;
+        return (uint32_t)h;
+    }
+
+    /// 位于off处、校验通过的记录占多少字节，0表示不合法
+    inline uint64_t checked_span(const char * records,uint64_t capacity,uint64_t off){
+        uint64_t phys = off % capacity;
+        uint64_t rem = capacity - phys;
+        RingFileRecord rec;
+        memcpy(&rec,records + phys,sizeof(rec));
+        uint64_t total = rec.flags == flag_wrap ? rem : align8(sizeof(RingFileRecord) + (uint64_t)rec.size);
+        if(rec.flags > flag_wrap || total > rem)return 0;
+        if(rec.flags == flag_wrap && rec.size != rem - sizeof(RingFileRecord))return 0;
+        uint64_t h = checksum_head(rec);
+        if(rec.flags != flag_wrap)h = checksum_feed(h,records + phys + sizeof(rec),rec.size);
+        return checksum_final(h) == rec.checksum ? total : 0;
+    }
+
+    /// 位于off处的记录(或者末尾跳过的部分)一共占多少字节，0表示不合法
+    inline uint64_t record_span(const char * records,uint64_t capacity,uint64_t off){
+        uint64_t phys = off % capacity;
+        uint64_t rem = capacity - phys;
+        if(rem < sizeof(RingFileRecord))return rem;
+        RingFileRecord rec;
+        memcpy(&rec,records + phys,sizeof(rec));
+        if(rec.flags == flag_wrap)return rem;
+        uint64_t total = align8(sizeof(RingFileRecord) + rec.size);
+        if(rec.flags != 0 || total > rem)return 0;
+        return total;
+    }
+
+    inline bool header_ok(const RingFileHeader & h,uint64_t file_size){
+        return !memcmp(h.magic,ring_file_magic,sizeof(h.magic)) &&
+               h.version == ring_version &&
+               h.header_size == sizeof(RingFileHeader) &&
+               h.capacity && h.capacity % 8 == 0 &&
+               file_size >= sizeof(RingFileHeader) + h.capacity &&
+               h.tail <= h.head && h.head - h.tail <= h.capacity;
+    }
+}
+
+RingFile::RingFile(std::string_view path,uint64_t capacity){
+    // 需要截断到单条记录最多capacity/4，太小的容量没有意义
+    capacity = align8(capacity < 4096 ? 4096 : capacity);
+    batch_write = true;
+    mapped_size = sizeof(RingFileHeader) + capacity;
+    std::string p (path);
+#ifdef _WIN32
+    HANDLE file = CreateFileA(p.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    panicf_debug(file == INVALID_HANDLE_VALUE,"Cannot open file {}!",path);
+    if(file == INVALID_HANDLE_VALUE)return;
+    LARGE_INTEGER sz;
+    uint64_t old_size = GetFileSizeEx(file, &sz) ? (uint64_t)sz.QuadPart : 0;
+    if(old_size != mapped_size){
+        sz.QuadPart = (LONGLONG)mapped_size;
+        SetFilePointerEx(file, sz, nullptr, FILE_BEGIN);
+        SetEndOfFile(file);
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE, 0, 0, nullptr);
+    // 映射对象持有文件的引用,文件句柄可以直接关闭
+    CloseHandle(file);
+    panicf_debug(!mapping,"Cannot map file {}!",path);
+    if(!mapping)return;
+    void* view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, mapped_size);
+    if(!view){
+        CloseHandle(mapping);
+        panicf_debug(true,"Cannot map file {}!",path);
+        return;
+    }
+    mapping_handle = mapping;
+#else
+    int fd = ::open(p.c_str(), O_RDWR | O_CREAT, 0644);
+    panicf_debug(fd < 0,"Cannot open file {}!",path);
+    if(fd < 0)return;
+    struct stat st;
+    uint64_t old_size = ::fstat(fd, &st) ? 0 : (uint64_t)st.st_size;
+    if(old_size != mapped_size && ::ftruncate(fd, (off_t)mapped_size)){
+        ::close(fd);
+        panicf_debug(true,"Cannot resize file {}!",path);
+        return;
+    }
+    void* view = ::mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    // mmap之后fd可以关闭,映射仍然有效
+    ::close(fd);
+    panicf_debug(view == MAP_FAILED,"Cannot map file {}!",path);
+    if(view == MAP_FAILED)return;
+#endif
+    header = static_cast<RingFileHeader*>(view);
+    records = static_cast<char*>(view) + sizeof(RingFileHeader);
+
+    // 同样容量的旧文件接着写，其余情况重新初始化
+    if(old_size == mapped_size && header_ok(*header,mapped_size) && header->capacity == capacity)return;
+    memset(header,0,sizeof(RingFileHeader));
+    header->version = ring_version;
+    header->header_size = sizeof(RingFileHeader);
+    header->capacity = capacity;
+    // magic最后写，写到一半崩溃的文件下次会被重新初始化
+    std::atomic_thread_fence(std::memory_order::release);
+    memcpy(header->magic,ring_file_magic,sizeof(header->magic));
+}
+
+void RingFile::close(){
+    std::lock_guard<std::mutex> lock(ring_lock);
+    if(!header)return;
+#ifdef _WIN32
+    UnmapViewOfFile(header);
+    CloseHandle(mapping_handle);
+    mapping_handle = nullptr;
+#else
+    ::munmap(header, mapped_size);
+#endif
+    header = nullptr;
+    records = nullptr;
+}
+
+void RingFile::reserve(uint64_t need){
+    uint64_t tail = header->tail;
+    uint64_t start = tail;
+    while(header->head + need - tail > header->capacity){
+        uint64_t span = record_span(records,header->capacity,tail);
+        // 自己写的环不会出现这种情况，保险起见直接清空
+        if(!span){
+            tail = header->head;
+            break;
+        }
+        tail += span;
+    }
+    // 先让tail越过将被覆盖的记录，再动里面的字节
+    if(tail != start){
+        std::atomic_ref<uint64_t>(header->tail).store(tail,std::memory_order::release);
+        // release只约束之前的写入，覆盖记录的写入不能提到tail之前
+        std::atomic_thread_fence(std::memory_order::seq_cst);
+    }
+}
+
+void RingFile::append(std::string_view prefix,std::string_view body,std::string_view tail){
+    const uint64_t capacity = header->capacity;
+    // 单条记录最多占四分之一，超出的部分截掉
+    uint64_t limit = capacity / 4 - sizeof(RingFileRecord);
+    uint64_t size = prefix.size() + body.size() + tail.size();
+    if(size > limit){
+        size = limit;
+        if(prefix.size() > size)prefix = prefix.substr(0,size);
+        body = body.substr(0,size - prefix.size());
+        tail = tail.substr(0,size - prefix.size() - body.size());
+    }
+    uint64_t need = align8(sizeof(RingFileRecord) + size);
+
+    uint64_t head = header->head;
+    uint64_t rem = capacity - head % capacity;
+    if(rem < need){
+        // 剩下的不够放，用wrap记录跳到下一圈
+        reserve(rem);
+        if(rem >= sizeof(RingFileRecord)){
+            RingFileRecord wrap { (uint32_t)(rem - sizeof(RingFileRecord)), flag_wrap, header->seq, 0, 0 };
+            wrap.checksum = checksum_final(checksum_head(wrap));
+            memcpy(records + head % capacity,&wrap,sizeof(wrap));
+        }
+        head += rem;
+        std::atomic_ref<uint64_t>(header->head).store(head,std::memory_order::release);
+    }
+    reserve(need);
+
+    char * dst = records + head % capacity;
+    char * text = dst + sizeof(RingFileRecord);
+    memcpy(text,prefix.data(),prefix.size());
+    memcpy(text + prefix.size(),body.data(),body.size());
+    memcpy(text + prefix.size() + body.size(),tail.data(),tail.size());
+    // 文本拼好之后是连续的，与读取端一样一次算完
+    RingFileRecord rec { (uint32_t)size, 0, header->seq, 0, 0 };
+    rec.checksum = checksum_final(checksum_feed(checksum_head(rec),text,size));
+    memcpy(dst,&rec,sizeof(rec));
+
+    // 内容就位之后才发布
+    header->seq = rec.seq + 1;
+    std::atomic_ref<uint64_t>(header->head).store(head + need,std::memory_order::release);
+}
+
+void RingFile::write(LogMsg & msg){
+    write_batch(std::span(&msg,1));
+}
+
+void RingFile::write_batch(std::span<LogMsg> msgs){
+    static thread_local std::string prefix;
+    std::lock_guard<std::mutex> lock(ring_lock);
+    if(!header)return;
+    for(auto & msg : msgs){
+        prefix.clear();
+        msg.compose_prefix(prefix);
+        append(prefix,msg.body,msg.composed_tail());
+    }
+}
+
+bool lot::read_ring_file(std::string_view path,const std::function<void(uint64_t seq,std::string_view text)> & fn){
+    // 读一份快照，不受正在写入的进程影响
+    std::ifstream in (std::string(path),std::ios::binary);
+    if(!in){
+        invoke_error(err_io_error,"Failed to open file {}!",path);
+        return false;
+    }
+    std::string data ((std::istreambuf_iterator<char>(in)),std::istreambuf_iterator<char>());
+    RingFileHeader h;
+    if(data.size() < sizeof(h)){
+        invoke_error(err_format_error,"File {} is not a ring file!",path);
+        return false;
+    }
+    memcpy(&h,data.data(),sizeof(h));
+    if(!header_ok(h,data.size())){
+        invoke_error(err_format_error,"File {} is not a ring file!",path);
+        return false;
+    }
+
+    const char * records = data.data() + sizeof(RingFileHeader);
+    uint64_t off = h.tail;
+    uint64_t expect_seq = 0;
+    bool synced = false;
+    while(off < h.head){
+        uint64_t phys = off % h.capacity;
+        uint64_t rem = h.capacity - phys;
+        // 不够一个记录头的部分本来就是跳过的
+        if(rem < sizeof(RingFileRecord)){
+            off += rem;
+            continue;
+        }
+        uint64_t span = checked_span(records,h.capacity,off);
+        if(!span || off + span > h.head){
+            if(synced)break;
+            // 快照里的tail可能比内容旧，开头这段正在被覆盖，按8字节往后找第一条校验通过的记录
+            off += 8;
+            continue;
+        }
+        RingFileRecord rec;
+        memcpy(&rec,records + phys,sizeof(rec));
+        if(rec.flags != flag_wrap){
+            // 序号必须连续，不连续说明快照里这段正在被覆盖
+            if(synced && rec.seq != expect_seq)break;
+            synced = true;
+            expect_seq = rec.seq + 1;
+            fn(rec.seq,std::string_view(records + phys + sizeof(rec),rec.size));
+        }
+        off += span;
+    }
+    return true;
+}
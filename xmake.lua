@@ -6,9 +6,8 @@ add_rules("plugin.compile_commands.autoupdate", {outputdir = "."})
 if is_plat("mingw", "msys") then
     add_requires("pacman::glm", {alias = "glm"})
     add_requires("pacman::rapidjson", {alias = "rapidjson"})
-    add_requires("pacman::tomlplusplus", {alias = "toml++"})
 else
-    add_requires("glm", "rapidjson" , "toml++")
+    add_requires("glm", "rapidjson")
 end
 
 set_languages("c++26")
@@ -30,7 +29,7 @@ function generate_aaaa0ggmcLib(name, type)
         add_files("src/**.cpp")
         add_includedirs("include", {public = true})
         add_headerfiles("include/(alib5/**.h)")
-        add_packages("glm", "rapidjson", "toml++")
+        add_packages("glm", "rapidjson")
 
         -- Network
         add_defines("ASIO_STANDALONE", "BUILD_DLL", { public = false})